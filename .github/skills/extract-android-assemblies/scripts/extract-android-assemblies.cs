@@ -133,7 +133,8 @@ namespace Xamarin.Android.Tools.DecompressAssemblies
 					assemblyCount++;
 					string fileName = assembly.Name.EndsWith (".dll", StringComparison.OrdinalIgnoreCase) ? assembly.Name : $"{assembly.Name}.dll";
 					string assemblyName = abi == null ? fileName : $"{abi}/{fileName}";
-					using Stream? stream = store.ReadImageData (assembly);
+					// Assemblies compressed with the store's dictionary can only be decompressed by the store reader
+					using Stream? stream = store.ReadImageData (assembly, uncompressIfNeeded: true);
 					if (stream == null) {
 						Console.Error.WriteLine ($"Unable to read '{assembly.Name}' from assembly store '{store.StorePath}'");
 						retVal = false;
@@ -5,6 +5,7 @@ using System.IO;
 using System.Buffers;
 using K4os.Compression.LZ4;
 using ZstandardDecoder = System.IO.Compression.ZstandardDecoder;
+using ZstandardDictionary = System.IO.Compression.ZstandardDictionary;
 #endif // NET11_0_OR_GREATER
 
 namespace Xamarin.Android.AssemblyStore;
@@ -13,20 +14,36 @@ public enum AssemblyCompressionFormat
 {
 	Lz4,
 	Zstandard,
+	Stored,
 }
 
 public static class AssemblyCompression
 {
+	// Followed by the descriptor index, uncompressed length, codec and dictionary ID (0 if none)
+	const uint CompressedDataMagic = 0x41434158; // 'XACA', little-endian
+	const int HeaderSize = 5 * sizeof (uint);
+
+	// Older applications identify the codec by the magic, followed by the descriptor index and uncompressed length
 	const uint Lz4Magic = 0x5A4C4158; // 'XALZ', little-endian
 	const uint ZstandardMagic = 0x535A4158; // 'XAZS', little-endian
+	const int LegacyHeaderSize = 3 * sizeof (uint);
+
+	// Values of the codec header field
+	const uint StoredCodec = 0;
+	const uint ZstandardCodec = 1;
+	const uint Lz4Codec = 2;
 
 #if NET11_0_OR_GREATER
-	const int HeaderSize = 3 * sizeof (uint);
 	const uint MaximumUncompressedAssemblySize = 512 * 1024 * 1024;
 
 	static readonly ArrayPool<byte> bytePool = ArrayPool<byte>.Shared;
 
-	public static bool TryDecompress (Stream input, Stream output, out AssemblyCompressionFormat format)
+	/// <summary>
+	/// Decompresses <paramref name="input"/> into <paramref name="output"/>, if it's compressed. Assemblies
+	/// compressed with a Zstandard dictionary need <paramref name="dictionary"/>, the one stored in their
+	/// assembly store.
+	/// </summary>
+	public static bool TryDecompress (Stream input, Stream output, out AssemblyCompressionFormat format, byte[]? dictionary = null)
 	{
 		ArgumentNullException.ThrowIfNull (input);
 		ArgumentNullException.ThrowIfNull (output);
@@ -38,15 +55,10 @@ public static class AssemblyCompression
 			throw new ArgumentException ("Output stream must be writable", nameof (output));
 		}
 
-		long start = input.Position;
-		if (!TryReadFormat (input, out format)) {
+		if (!TryReadFormat (input, out format, out int headerSize)) {
 			return false;
 		}
 
-		if (input.Length - start < HeaderSize) {
-			throw new InvalidDataException ($"Truncated {format} assembly header");
-		}
-
 		using var reader = new BinaryReader (input, System.Text.Encoding.UTF8, leaveOpen: true);
 		reader.ReadUInt32 (); // descriptor index
 		uint uncompressedLength = reader.ReadUInt32 ();
@@ -54,6 +66,18 @@ public static class AssemblyCompression
 			throw new InvalidDataException ($"{format} assembly expands to an unsupported size of {uncompressedLength} bytes (maximum {MaximumUncompressedAssemblySize} bytes)");
 		}
 
+		ZstandardDictionary? zstdDictionary = null;
+		if (headerSize == HeaderSize) {
+			reader.ReadUInt32 (); // codec, already read by TryReadFormat
+			uint dictionaryId = reader.ReadUInt32 ();
+			if (dictionaryId != 0) {
+				if (format != AssemblyCompressionFormat.Zstandard || dictionary == null) {
+					throw new InvalidDataException ($"{format} assembly was compressed with dictionary {dictionaryId}, which is not available");
+				}
+				zstdDictionary = ZstandardDictionary.Create (dictionary);
+			}
+		}
+
 		long compressedLength = input.Length - input.Position;
 		if (compressedLength > Int32.MaxValue) {
 			throw new InvalidDataException ($"{format} assembly contains an unsupported compressed size of {compressedLength} bytes");
@@ -75,11 +99,19 @@ public static class AssemblyCompression
 					0,
 					(int)uncompressedLength
 				),
+				AssemblyCompressionFormat.Zstandard when zstdDictionary != null => ZstandardDecoder.TryDecompress (
+					compressedBytes.AsSpan (0, (int)compressedLength),
+					assemblyBytes.AsSpan (0, (int)uncompressedLength),
+					out int bytesWritten,
+					zstdDictionary
+				) ? bytesWritten : -1,
 				AssemblyCompressionFormat.Zstandard => ZstandardDecoder.TryDecompress (
 					compressedBytes.AsSpan (0, (int)compressedLength),
 					assemblyBytes.AsSpan (0, (int)uncompressedLength),
 					out int bytesWritten
 				) ? bytesWritten : -1,
+				AssemblyCompressionFormat.Stored when compressedLength == uncompressedLength => CopyStored (compressedBytes, assemblyBytes, (int)compressedLength),
+				AssemblyCompressionFormat.Stored => -1,
 				_ => throw new InvalidOperationException ($"Unsupported compression format '{format}'"),
 			};
 
@@ -91,6 +123,7 @@ public static class AssemblyCompression
 			output.Flush ();
 			return true;
 		} finally {
+			zstdDictionary?.Dispose ();
 			if (compressedBytes != null) {
 				bytePool.Return (compressedBytes);
 			}
@@ -100,6 +133,12 @@ public static class AssemblyCompression
 		}
 	}
 
+	static int CopyStored (byte[] source, byte[] destination, int count)
+	{
+		Buffer.BlockCopy (source, 0, destination, 0, count);
+		return count;
+	}
+
 	static void ReadFully (BinaryReader reader, byte[] destination, int count)
 	{
 		int totalRead = 0;
@@ -122,32 +161,56 @@ public static class AssemblyCompression
 		}
 
 		long start = input.Position;
-		bool compressed = TryReadFormat (input, out _);
+		bool compressed = TryReadFormat (input, out _, out _);
 		input.Seek (start, SeekOrigin.Begin);
 		return compressed;
 	}
 
-	static bool TryReadFormat (Stream input, out AssemblyCompressionFormat format)
+	// On success, leaves `input` positioned right after the magic
+	static bool TryReadFormat (Stream input, out AssemblyCompressionFormat format, out int headerSize)
 	{
 		long start = input.Position;
+		format = default;
+		headerSize = 0;
 		if (input.Length - start < sizeof (uint)) {
-			format = default;
 			return false;
 		}
 
 		using var reader = new BinaryReader (input, System.Text.Encoding.UTF8, leaveOpen: true);
 		uint magic = reader.ReadUInt32 ();
 		switch (magic) {
+			case CompressedDataMagic:
+				headerSize = HeaderSize;
+				break;
 			case Lz4Magic:
 				format = AssemblyCompressionFormat.Lz4;
-				return true;
+				headerSize = LegacyHeaderSize;
+				break;
 			case ZstandardMagic:
 				format = AssemblyCompressionFormat.Zstandard;
-				return true;
+				headerSize = LegacyHeaderSize;
+				break;
 			default:
 				input.Seek (start, SeekOrigin.Begin);
-				format = default;
 				return false;
 		}
+
+		if (input.Length - start < headerSize) {
+			throw new InvalidDataException ("Truncated compressed assembly header");
+		}
+
+		if (magic == CompressedDataMagic) {
+			input.Seek (start + 3 * sizeof (uint), SeekOrigin.Begin);
+			uint codec = reader.ReadUInt32 ();
+			format = codec switch {
+				StoredCodec => AssemblyCompressionFormat.Stored,
+				ZstandardCodec => AssemblyCompressionFormat.Zstandard,
+				Lz4Codec => AssemblyCompressionFormat.Lz4,
+				_ => throw new InvalidDataException ($"Assembly compressed with an unknown codec {codec}"),
+			};
+			input.Seek (start + sizeof (uint), SeekOrigin.Begin);
+		}
+
+		return true;
 	}
 }
@@ -23,6 +23,9 @@ abstract class AssemblyStoreReader
 	public IList<AssemblyStoreItem>? Assemblies { get; protected set; }
 	public bool Is64Bit                         { get; protected set; }
 
+	// The Zstandard dictionary some of the store's assemblies are compressed with, if any
+	protected byte[]? CompressionDictionary     { get; set; }
+
 	protected AssemblyStoreReader (Stream store, string path)
 	{
 		StoreStream = store;
@@ -83,7 +86,7 @@ abstract class AssemblyStoreReader
 		return UncompressIfNeeded (stream, uncompressIfNeeded);
 	}
 
-	protected static Stream UncompressIfNeeded (MemoryStream stream, bool uncompressIfNeeded)
+	protected Stream UncompressIfNeeded (MemoryStream stream, bool uncompressIfNeeded)
 	{
 		if (!uncompressIfNeeded) {
 			return stream;
@@ -91,7 +94,7 @@ abstract class AssemblyStoreReader
 
 #if NET11_0_OR_GREATER
 		var output = new MemoryStream ();
-		if (AssemblyCompression.TryDecompress (stream, output, out _)) {
+		if (AssemblyCompression.TryDecompress (stream, output, out _, CompressionDictionary)) {
 			stream.Dispose ();
 			output.Seek (0, SeekOrigin.Begin);
 			return output;
@@ -17,6 +17,12 @@ partial class StoreReader_V2 : AssemblyStoreReader
 	const uint ASSEMBLY_STORE_FORMAT_VERSION_32BIT_V3 = 0x00000003;
 	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V4 = 0x80000004; // Must match the ASSEMBLY_STORE_FORMAT_VERSION native constant
 	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V4 = 0x00000004;
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V5 = 0x80000005; // Must match the ASSEMBLY_STORE_FORMAT_VERSION native constant
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V5 = 0x00000005;
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V6 = 0x80000006; // Must match the ASSEMBLY_STORE_FORMAT_VERSION_SORTED_INDEX native constant
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V6 = 0x00000006;
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V7 = 0x80000007; // Must match the ASSEMBLY_STORE_FORMAT_VERSION native constant
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V7 = 0x00000007;
 	const uint ASSEMBLY_STORE_FORMAT_VERSION_MASK  = 0xF0000000;
 	const uint ASSEMBLY_STORE_FORMAT_NUMBER_MASK   = 0x0000FFFF;
 
@@ -26,6 +32,17 @@ partial class StoreReader_V2 : AssemblyStoreReader
 	const uint ASSEMBLY_STORE_ABI_X86              = 0x00040000;
 	const uint ASSEMBLY_STORE_ABI_MASK             = 0x00FF0000;
 
+	// Set in CoreCLR stores which contain a Zstandard dictionary, placed right after the assembly names
+	const uint ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG = 0x01000000;
+
+	// Set in CoreCLR stores which keep the debug and config data of all the assemblies after all the images.
+	// The descriptors point at the data either way.
+	const uint ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG = 0x02000000;
+
+	// Set in CoreCLR primary stores which list the secondary stores of the application. The secondary
+	// stores themselves are ordinary stores, read from their own files.
+	const uint ASSEMBLY_STORE_SECONDARY_STORES_FLAG = 0x04000000;
+
 	public override string Description => "Assembly store v2";
 	public override bool NeedsExtensionInName => true;
 
@@ -94,6 +111,18 @@ partial class StoreReader_V2 : AssemblyStoreReader
 			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V4 | ASSEMBLY_STORE_ABI_X64,
 			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V4 | ASSEMBLY_STORE_ABI_ARM,
 			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V4 | ASSEMBLY_STORE_ABI_X86,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V5 | ASSEMBLY_STORE_ABI_AARCH64,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V5 | ASSEMBLY_STORE_ABI_X64,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V5 | ASSEMBLY_STORE_ABI_ARM,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V5 | ASSEMBLY_STORE_ABI_X86,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V6 | ASSEMBLY_STORE_ABI_AARCH64,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V6 | ASSEMBLY_STORE_ABI_X64,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V6 | ASSEMBLY_STORE_ABI_ARM,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V6 | ASSEMBLY_STORE_ABI_X86,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V7 | ASSEMBLY_STORE_ABI_AARCH64,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT_V7 | ASSEMBLY_STORE_ABI_X64,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V7 | ASSEMBLY_STORE_ABI_ARM,
+			ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT_V7 | ASSEMBLY_STORE_ABI_X86,
 		};
 	}
 
@@ -132,7 +161,7 @@ partial class StoreReader_V2 : AssemblyStoreReader
 		}
 
 		uint version = reader.ReadUInt32 ();
-		if (!supportedVersions.Contains (version)) {
+		if (!supportedVersions.Contains (version & ~(ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG | ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG | ASSEMBLY_STORE_SECONDARY_STORES_FLAG))) {
 			Log.Debug ($"Store '{StorePath}' has unsupported version 0x{version:x}");
 			return false;
 		}
@@ -193,6 +222,13 @@ partial class StoreReader_V2 : AssemblyStoreReader
 			index.Add (new IndexEntry (name_hash, descriptor_index, ignore));
 		}
 
+		// Starting with v5, the index entries are followed by the perfect hash displacement table,
+		// which is of no interest here.
+		StoreStream.Seek ((long)elfOffset + header.NativeSize + header.index_size, SeekOrigin.Begin);
+
+		// Starting with v6, the descriptors also contain the location of the assembly name. The names
+		// section is still read sequentially below.
+		bool hasNamedDescriptors = (header.version & ASSEMBLY_STORE_FORMAT_NUMBER_MASK) >= 6;
 		var descriptors = new List<EntryDescriptor> ();
 		for (uint i = 0; i < header.entry_count; i++) {
 			uint mapping_index      = reader.ReadUInt32 ();
@@ -202,6 +238,10 @@ partial class StoreReader_V2 : AssemblyStoreReader
 			uint debug_data_size    = reader.ReadUInt32 ();
 			uint config_data_offset = reader.ReadUInt32 ();
 			uint config_data_size   = reader.ReadUInt32 ();
+			if (hasNamedDescriptors) {
+				reader.ReadUInt32 (); // name offset
+				reader.ReadUInt32 (); // name length
+			}
 
 			var desc = new EntryDescriptor {
 				mapping_index      = mapping_index,
@@ -222,6 +262,11 @@ partial class StoreReader_V2 : AssemblyStoreReader
 			names.Add (Encoding.UTF8.GetString (name_bytes));
 		}
 
+		if ((header.version & ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG) != 0) {
+			uint dictionary_size = reader.ReadUInt32 ();
+			CompressionDictionary = reader.ReadBytes ((int)dictionary_size);
+		}
+
 		var tempItems = new Dictionary<uint, TemporaryItem> ();
 		foreach (IndexEntry ie in index) {
 			if (!tempItems.TryGetValue (ie.descriptor_index, out TemporaryItem? item)) {
@@ -249,6 +294,12 @@ partial class StoreReader_V2 : AssemblyStoreReader
 				return 0;
 			}
 
+			// v5 and newer stores are CoreCLR-only and always use 32-bit hashes. The v5 and v7 index also
+			// contains the perfect hash table, so its size can't be used to determine the entry size.
+			if ((header.version & ASSEMBLY_STORE_FORMAT_NUMBER_MASK) >= 5) {
+				return IndexEntry.NativeSize32;
+			}
+
 			if (header.index_size % header.index_entry_count != 0) {
 				throw new InvalidOperationException ($"Assembly store '{StorePath}' index is corrupted: index size {header.index_size} is not evenly divisible by entry count {header.index_entry_count}.");
 			}
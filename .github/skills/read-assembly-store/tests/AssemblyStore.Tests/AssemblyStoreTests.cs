@@ -21,11 +21,14 @@ public class AssemblyStoreTests
 	static readonly byte[] assemblyData = "Synthetic managed assembly"u8.ToArray ();
 
 #if NET11_0_OR_GREATER
-	[TestCase (AssemblyCompressionFormat.Lz4)]
-	[TestCase (AssemblyCompressionFormat.Zstandard)]
-	public void DecompressesBothCompressionFormats (AssemblyCompressionFormat format)
+	[TestCase (AssemblyCompressionFormat.Lz4, false)]
+	[TestCase (AssemblyCompressionFormat.Zstandard, false)]
+	[TestCase (AssemblyCompressionFormat.Stored, false)]
+	[TestCase (AssemblyCompressionFormat.Lz4, true)]
+	[TestCase (AssemblyCompressionFormat.Zstandard, true)]
+	public void DecompressesAllCompressionFormats (AssemblyCompressionFormat format, bool legacyHeader)
 	{
-		using Stream input = CreateCompressedAssembly (format, assemblyData);
+		using Stream input = CreateCompressedAssembly (format, assemblyData, legacyHeader);
 		using var output = new MemoryStream ();
 
 		Assert.IsTrue (AssemblyCompression.TryDecompress (input, output, out AssemblyCompressionFormat detectedFormat));
@@ -33,6 +36,36 @@ public class AssemblyStoreTests
 		CollectionAssert.AreEqual (assemblyData, output.ToArray ());
 	}
 
+	[Test]
+	public void DecompressesAssembliesCompressedWithDictionary ()
+	{
+		byte[] dictionaryData = "Synthetic managed assembly dictionary"u8.ToArray ();
+		byte[] compressed = new byte [checked ((int)ZstandardEncoder.GetMaxCompressedLength (assemblyData.Length))];
+		using (var dictionary = System.IO.Compression.ZstandardDictionary.Create (dictionaryData, 3)) {
+			Assert.IsTrue (ZstandardEncoder.TryCompress (assemblyData, compressed, out int length, dictionary, 0));
+			Array.Resize (ref compressed, length);
+		}
+
+		using var input = new MemoryStream ();
+		using (var writer = new BinaryWriter (input, System.Text.Encoding.UTF8, leaveOpen: true)) {
+			writer.Write (0x41434158u);
+			writer.Write (0u);
+			writer.Write ((uint)assemblyData.Length);
+			writer.Write (1u); // Zstandard
+			writer.Write (0x12345678u); // dictionary ID, not checked against the dictionary
+			writer.Write (compressed);
+		}
+
+		input.Seek (0, SeekOrigin.Begin);
+		Assert.Throws<InvalidDataException> (() => AssemblyCompression.TryDecompress (input, new MemoryStream (), out _));
+
+		input.Seek (0, SeekOrigin.Begin);
+		using var output = new MemoryStream ();
+		Assert.IsTrue (AssemblyCompression.TryDecompress (input, output, out AssemblyCompressionFormat detectedFormat, dictionaryData));
+		Assert.AreEqual (AssemblyCompressionFormat.Zstandard, detectedFormat);
+		CollectionAssert.AreEqual (assemblyData, output.ToArray ());
+	}
+
 	[Test]
 	public void LeavesUncompressedAssembliesUntouched ()
 	{
@@ -70,7 +103,7 @@ public class AssemblyStoreTests
 	{
 		string directory = CreateTemporaryDirectory ();
 		try {
-			using MemoryStream compressedStream = CreateCompressedAssembly (format, assemblyData);
+			using MemoryStream compressedStream = CreateCompressedAssembly (format, assemblyData, legacyHeader: true);
 			byte[] compressedAssembly = compressedStream.ToArray ();
 			string indexStore = Path.Combine (directory, "base_assemblies.blob");
 			CreateV1StoreSet (indexStore, compressedAssembly);
@@ -101,7 +134,7 @@ public class AssemblyStoreTests
 	{
 		string directory = CreateTemporaryDirectory ();
 		try {
-			using MemoryStream compressedStream = CreateCompressedAssembly (AssemblyCompressionFormat.Lz4, assemblyData);
+			using MemoryStream compressedStream = CreateCompressedAssembly (AssemblyCompressionFormat.Lz4, assemblyData, legacyHeader: true);
 			string indexStore = Path.Combine (directory, "assemblies.blob");
 			CreateV1StoreSet (indexStore, compressedStream.ToArray ());
 
@@ -164,6 +197,39 @@ public class AssemblyStoreTests
 		}
 	}
 
+	[TestCase (6u)]
+	[TestCase (7u)]
+	public void ReadsStoresWithNamedDescriptors (uint version)
+	{
+		string directory = CreateTemporaryDirectory ();
+		try {
+			string apk = Path.Combine (directory, "named-descriptors.apk");
+			using (FileStream file = File.Create (apk))
+			using (var archive = new ZipArchive (file, ZipArchiveMode.Create)) {
+				archive.CreateEntry ("AndroidManifest.xml");
+				WriteEntry (
+					archive,
+					"lib/arm64-v8a/libassembly-store.so",
+					CreateNamedDescriptorStore (assemblyData, version)
+				);
+			}
+
+			(IList<AssemblyStoreExplorer>? explorers, string? errorMessage) = AssemblyStoreExplorer.Open (apk);
+			Assert.IsNull (errorMessage);
+			Assert.IsNotNull (explorers);
+
+			AssemblyStoreExplorer explorer = RequireSingle (explorers, "named descriptor store explorer");
+			AssemblyStoreItem item = RequireSingle (explorer.Find ("Test.dll", AndroidTargetArch.Arm64), "named descriptor store item");
+			using Stream image = explorer.ReadImageData (item, uncompressIfNeeded: true) ??
+				throw new InvalidOperationException ("Named descriptor store image was not returned");
+			using var output = new MemoryStream ();
+			image.CopyTo (output);
+			CollectionAssert.AreEqual (assemblyData, output.ToArray ());
+		} finally {
+			Directory.Delete (directory, recursive: true);
+		}
+	}
+
 	[Test]
 	public void IncludesCommonAssembliesInLegacyArchitectureViews ()
 	{
@@ -188,7 +254,7 @@ public class AssemblyStoreTests
 	}
 
 #if NET11_0_OR_GREATER
-	static MemoryStream CreateCompressedAssembly (AssemblyCompressionFormat format, byte[] data)
+	static MemoryStream CreateCompressedAssembly (AssemblyCompressionFormat format, byte[] data, bool legacyHeader)
 	{
 		byte[] compressed;
 		switch (format) {
@@ -205,15 +271,30 @@ public class AssemblyStoreTests
 				Array.Resize (ref compressed, length);
 				break;
 			}
+			case AssemblyCompressionFormat.Stored:
+				compressed = data;
+				break;
 			default:
 				throw new NotSupportedException ($"Unsupported compression format '{format}'");
 		}
 
 		var output = new MemoryStream ();
 		using (var writer = new BinaryWriter (output, System.Text.Encoding.UTF8, leaveOpen: true)) {
-			writer.Write (format == AssemblyCompressionFormat.Lz4 ? 0x5A4C4158u : 0x535A4158u);
-			writer.Write (0u);
-			writer.Write ((uint)data.Length);
+			if (legacyHeader) {
+				writer.Write (format == AssemblyCompressionFormat.Lz4 ? 0x5A4C4158u : 0x535A4158u);
+				writer.Write (0u);
+				writer.Write ((uint)data.Length);
+			} else {
+				writer.Write (0x41434158u);
+				writer.Write (0u);
+				writer.Write ((uint)data.Length);
+				writer.Write (format switch {
+					AssemblyCompressionFormat.Stored => 0u,
+					AssemblyCompressionFormat.Zstandard => 1u,
+					_ => 2u,
+				});
+				writer.Write (0u); // no dictionary
+			}
 			writer.Write (compressed);
 		}
 		output.Seek (0, SeekOrigin.Begin);
@@ -333,6 +414,48 @@ public class AssemblyStoreTests
 		return output.ToArray ();
 	}
 
+	static byte[] CreateNamedDescriptorStore (byte[] image, uint version)
+	{
+		byte[] name = "Test.dll"u8.ToArray ();
+		const int HeaderSize = 5 * sizeof (uint) + sizeof (ulong);
+		const int IndexEntrySize = 2 * sizeof (uint) + sizeof (byte);
+		// v7 stores append the perfect hash displacements (a single bucket here) to the index
+		int indexSize = IndexEntrySize + (version >= 7 ? 2 * sizeof (uint) : 0);
+		const int DescriptorSize = 9 * sizeof (uint);
+		int nameOffset = HeaderSize + indexSize + DescriptorSize + sizeof (uint);
+		int dataOffset = nameOffset + name.Length;
+
+		using var output = new MemoryStream ();
+		using (var writer = new BinaryWriter (output, System.Text.Encoding.UTF8, leaveOpen: true)) {
+			writer.Write (0x41424158u);
+			writer.Write (0x80010000u | version);
+			writer.Write (1u);
+			writer.Write (1u);
+			writer.Write ((uint)indexSize);
+			writer.Write (0x123456789abcdef0ul);
+			writer.Write (0x12345678u);
+			writer.Write (0u);
+			writer.Write (false);
+			if (version >= 7) {
+				writer.Write (1u);
+				writer.Write (0u);
+			}
+			writer.Write (0u);
+			writer.Write ((uint)dataOffset);
+			writer.Write ((uint)image.Length);
+			writer.Write (0u);
+			writer.Write (0u);
+			writer.Write (0u);
+			writer.Write (0u);
+			writer.Write ((uint)nameOffset);
+			writer.Write ((uint)name.Length);
+			writer.Write ((uint)name.Length);
+			writer.Write (name);
+			writer.Write (image);
+		}
+		return output.ToArray ();
+	}
+
 	static void WriteEntry (ZipArchive archive, string path, byte[] data)
 	{
 		ZipArchiveEntry entry = archive.CreateEntry (path, CompressionLevel.NoCompression);
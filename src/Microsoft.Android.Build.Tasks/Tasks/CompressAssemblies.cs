@@ -1,5 +1,8 @@
 #nullable enable
+using System;
 using System.Collections.Generic;
+using System.IO;
+using System.Linq;
 using Microsoft.Android.Build.Tasks;
 using Microsoft.Build.Framework;
 using Properties = Xamarin.Android.Tasks.Properties;
@@ -31,6 +34,32 @@ public class CompressAssemblies : AndroidTask
 	[Required]
 	public int CompressionLevel { get; set; } = 3;
 
+	/// <summary>
+	/// When greater than 0, assemblies at least 4 times larger than this many bytes are compressed
+	/// as a sequence of independently decodable chunks of this size, so that the CoreCLR host can
+	/// decompress them on demand, one chunk at a time, or several chunks in parallel. Rounded up to a
+	/// multiple of <see cref="MaxPageSize"/>. Flows from the <c>$(_AndroidAssemblyStoreCompressionChunkSize)</c>
+	/// MSBuild property.
+	/// </summary>
+	public int ChunkSize { get; set; }
+
+	/// <summary>
+	/// When set, a Zstandard dictionary is trained for each ABI (as given by the <c>Abi</c> metadata)
+	/// on the assemblies of at most 128 KiB, which are then compressed with it. The dictionaries are
+	/// written to <c>{DictionaryDirectory}/{abi}.zdict</c>, to be stored in the assembly stores. Since
+	/// a dictionary depends on all the assemblies, all of them must be passed to the task whenever this
+	/// is set. Flows from the <c>$(_AndroidAssemblyCompressionDictionaryDirectory)</c> MSBuild property.
+	/// </summary>
+	public string? DictionaryDirectory { get; set; }
+
+	/// <summary>
+	/// Names of the assemblies (with or without the <c>.dll</c> extension) to compress with LZ4 instead
+	/// of Zstandard. LZ4 decompresses several times faster, at the cost of a larger assembly store, so
+	/// this is meant for the assemblies loaded during startup. Flows from the
+	/// <c>$(_AndroidAssemblyStoreLz4Assemblies)</c> MSBuild property.
+	/// </summary>
+	public string [] Lz4Assemblies { get; set; } = [];
+
 	[Output]
 	public ITaskItem [] FailedToCompressAssembliesOutput { get; set; } = [];
 
@@ -38,6 +67,10 @@ public class CompressAssemblies : AndroidTask
 	const int MinCompressionLevel = 1;
 	const int MaxCompressionLevel = 22;
 
+	// The largest page size of Android devices, a multiple of all the other ones. The runtime materializes
+	// the pages of chunks decompressed on demand whole, which is simplest when no page spans two chunks.
+	const int MaxPageSize = 16384;
+
 	public override bool RunTask ()
 	{
 		if (CompressionLevel < MinCompressionLevel || CompressionLevel > MaxCompressionLevel) {
@@ -45,7 +78,14 @@ public class CompressAssemblies : AndroidTask
 			return false;
 		}
 
+		if (ChunkSize > 0 && ChunkSize % MaxPageSize != 0) {
+			int chunkSize = (ChunkSize + MaxPageSize - 1) / MaxPageSize * MaxPageSize;
+			Log.LogDebugMessage ($"Rounding the compression chunk size of {ChunkSize} bytes up to {chunkSize} bytes, a multiple of the page size.");
+			ChunkSize = chunkSize;
+		}
+
 		var failed_assemblies = new List<ITaskItem> ();
+		var assemblies = new List<(ITaskItem item, string destination_path, uint descriptor_index)> ();
 
 		foreach (var assembly in AssembliesToCompress) {
 			ReferenceAssemblyChecker.LogIfReferenceAssembly (assembly, Log);
@@ -61,16 +101,98 @@ public class CompressAssemblies : AndroidTask
 				break;
 			}
 
-			if (!AssemblyCompressor.TryCompress (Log, assembly.ItemSpec, destination_path, descriptor_index, CompressionLevel)) {
-				failed_assemblies.Add (assembly);
-				continue;
-			}
+			assemblies.Add ((assembly, destination_path, descriptor_index));
+		}
 
-			Log.LogDebugMessage ($"Compressed '{assembly.ItemSpec}' to '{destination_path}'.");
+		Dictionary<string, AssemblyCompressionDictionary> dictionaries = TrainDictionaries (assemblies);
+		try {
+			foreach (var (assembly, destination_path, descriptor_index) in assemblies) {
+				if (IsLz4Assembly (assembly)) {
+					if (!AssemblyCompressor.TryCompress (Log, assembly.ItemSpec, destination_path, descriptor_index, CompressionLevel, codec: AssemblyCompressionCodec.LZ4)) {
+						failed_assemblies.Add (assembly);
+						continue;
+					}
+
+					Log.LogDebugMessage ($"Compressed '{assembly.ItemSpec}' to '{destination_path}' with LZ4.");
+					continue;
+				}
+
+				AssemblyCompressionDictionary? dictionary = null;
+				if (dictionaries.TryGetValue (assembly.GetMetadata ("Abi"), out AssemblyCompressionDictionary? abiDictionary) && IsDictionaryCandidate (assembly)) {
+					dictionary = abiDictionary;
+				}
+
+				if (!AssemblyCompressor.TryCompress (Log, assembly.ItemSpec, destination_path, descriptor_index, CompressionLevel, ChunkSize, dictionary)) {
+					failed_assemblies.Add (assembly);
+					continue;
+				}
+
+				if (dictionary != null) {
+					Log.LogDebugMessage ($"Compressed '{assembly.ItemSpec}' to '{destination_path}' with dictionary {dictionary.Id}.");
+				} else {
+					Log.LogDebugMessage ($"Compressed '{assembly.ItemSpec}' to '{destination_path}'.");
+				}
+			}
+		} finally {
+			foreach (AssemblyCompressionDictionary dictionary in dictionaries.Values) {
+				dictionary.Dispose ();
+			}
 		}
 
 		FailedToCompressAssembliesOutput = failed_assemblies.ToArray ();
 
 		return !Log.HasLoggedErrors;
 	}
+
+	Dictionary<string, AssemblyCompressionDictionary> TrainDictionaries (List<(ITaskItem item, string destination_path, uint descriptor_index)> assemblies)
+	{
+		var ret = new Dictionary<string, AssemblyCompressionDictionary> (StringComparer.Ordinal);
+		if (string.IsNullOrEmpty (DictionaryDirectory)) {
+			return ret;
+		}
+
+		Directory.CreateDirectory (DictionaryDirectory);
+		foreach (var abiAssemblies in assemblies.GroupBy (a => a.item.GetMetadata ("Abi"), StringComparer.Ordinal)) {
+			string abi = abiAssemblies.Key;
+			if (abi.Length == 0) {
+				continue;
+			}
+
+			List<string> samples = abiAssemblies.Where (a => IsDictionaryCandidate (a.item) && !IsLz4Assembly (a.item)).Select (a => a.item.ItemSpec).ToList ();
+			AssemblyCompressionDictionary? dictionary = AssemblyCompressor.TryTrainDictionary (Log, samples, CompressionLevel);
+
+			// A dictionary left over from a previous build must not end up in the store
+			string dictionaryPath = Path.Combine (DictionaryDirectory, $"{abi}.zdict");
+			if (dictionary == null) {
+				File.Delete (dictionaryPath);
+				continue;
+			}
+
+			File.WriteAllBytes (dictionaryPath, dictionary.Data);
+			ret.Add (abi, dictionary);
+			Log.LogDebugMessage ($"Trained compression dictionary {dictionary.Id} ({dictionary.Data.Length} bytes) for ABI '{abi}' on {samples.Count} assemblies.");
+		}
+
+		return ret;
+	}
+
+	static bool IsDictionaryCandidate (ITaskItem assembly) => new FileInfo (assembly.ItemSpec).Length <= AssemblyCompressor.MaximumDictionaryAssemblySize;
+
+	HashSet<string>? lz4AssemblyNames;
+
+	bool IsLz4Assembly (ITaskItem assembly)
+	{
+		if (Lz4Assemblies.Length == 0) {
+			return false;
+		}
+
+		lz4AssemblyNames ??= new HashSet<string> (Lz4Assemblies.Select (GetAssemblyName), StringComparer.OrdinalIgnoreCase);
+		return lz4AssemblyNames.Contains (GetAssemblyName (assembly.ItemSpec));
+
+		static string GetAssemblyName (string path)
+		{
+			string name = Path.GetFileName (path.Trim ());
+			return name.EndsWith (".dll", StringComparison.OrdinalIgnoreCase) ? name.Substring (0, name.Length - 4) : name;
+		}
+	}
 }
@@ -1,23 +1,56 @@
 #nullable enable
 using System;
 using System.Buffers;
+using System.Buffers.Binary;
+using System.Collections.Generic;
 using System.IO;
 using System.IO.Compression;
 
+using K4os.Compression.LZ4;
+using Microsoft.Android.Build.Tasks;
 using Microsoft.Build.Utilities;
 
 namespace Microsoft.Android.Tasks;
 
 /// <summary>
 /// Compresses assemblies with Zstandard before they are placed in the AssemblyStore.
-/// The native runtime decompresses them at assembly load time. The 12-byte header
-/// (magic / descriptor index / uncompressed length) is read back by the runtime and by
-/// the diagnostic tools; the reader-side helpers live in <c>AssemblyCompression</c> in
-/// Xamarin.Android.Build.Tasks.
+/// The native runtime decompresses them at assembly load time. The 20-byte header
+/// (magic / descriptor index / uncompressed length / codec / dictionary ID) is read back
+/// by the runtime and by the diagnostic tools; the reader-side helpers live in
+/// <c>AssemblyCompression</c> in Xamarin.Android.Build.Tasks.
+///
+/// When a chunk size is given, large assemblies are compressed as a sequence of independent
+/// frames, one per chunk, followed by a seek table in the Zstandard "seekable format" (a
+/// skippable frame, so the data remains a valid Zstandard stream for readers which aren't
+/// aware of it). The CoreCLR host uses the seek table to decompress only the chunks of the
+/// image which are actually accessed, or to decompress the chunks in parallel.
+///
+/// When a dictionary is given, the assembly is compressed with it (unless it's split into chunks)
+/// and its ID is recorded in the header. The dictionary itself is stored once, in the assembly store.
+///
+/// The codec is identified by the header codec field. Assemblies compressed with LZ4 instead of
+/// Zstandard decompress several times faster at the cost of a worse compression ratio, which is a good
+/// trade for the assemblies needed during startup. LZ4 data is never split into chunks nor compressed
+/// with a dictionary. Assemblies which compression doesn't make any smaller are stored as they are.
 /// </summary>
 static class AssemblyCompressor
 {
-	const uint CompressedDataMagic = 0x535A4158; // 'XAZS', little-endian
+	const uint CompressedDataMagic = 0x41434158; // 'XACA', little-endian
+	const uint ZstandardDictionaryMagic = 0xEC30A437;
+
+	// Dictionaries help small inputs the most, larger assemblies have enough context of their own
+	public const int MaximumDictionaryAssemblySize = 128 * 1024;
+	const int MaximumDictionarySize = 112 * 1024;
+	const int MinimumDictionarySamples = 8;
+
+	// See https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md
+	const uint SkippableFrameMagic = 0x184D2A5E;
+	const uint SeekableMagic = 0x8F92EAB1;
+	const int SeekTableEntrySize = 2 * sizeof (uint);
+	const int SeekTableFooterSize = sizeof (uint) + sizeof (byte) + sizeof (uint);
+
+	// Splitting smaller assemblies isn't worth the loss of compression ratio
+	const int MinimumChunksPerAssembly = 4;
 
 	static readonly ArrayPool<byte> bytePool = ArrayPool<byte>.Shared;
 
@@ -27,9 +60,9 @@ static class AssemblyCompressor
 		EncodingFailed,
 	}
 
-	public static bool TryCompress (TaskLoggingHelper log, string sourceAssembly, string destinationAssembly, uint descriptorIndex, int compressionLevel)
+	public static bool TryCompress (TaskLoggingHelper log, string sourceAssembly, string destinationAssembly, uint descriptorIndex, int compressionLevel, int chunkSize = 0, AssemblyCompressionDictionary? dictionary = null, AssemblyCompressionCodec codec = AssemblyCompressionCodec.Zstandard)
 	{
-		CompressionResult result = Compress (sourceAssembly, destinationAssembly, descriptorIndex, compressionLevel);
+		CompressionResult result = Compress (sourceAssembly, destinationAssembly, descriptorIndex, compressionLevel, chunkSize, dictionary, codec);
 
 		if (result != CompressionResult.Success) {
 			log.LogMessage ($"Failed to compress {sourceAssembly}");
@@ -39,7 +72,55 @@ static class AssemblyCompressor
 		return true;
 	}
 
-	static CompressionResult Compress (string sourcePath, string outputFilePath, uint descriptorIndex, int compressionLevel)
+	/// <summary>
+	/// Trains a dictionary on the given assemblies, returning <c>null</c> if there are too few of them
+	/// or if training fails.
+	/// </summary>
+	public static AssemblyCompressionDictionary? TryTrainDictionary (TaskLoggingHelper log, IList<string> sampleAssemblies, int compressionLevel)
+	{
+		if (sampleAssemblies.Count < MinimumDictionarySamples) {
+			log.LogDebugMessage ($"Not training a compression dictionary, only {sampleAssemblies.Count} sample assemblies available (at least {MinimumDictionarySamples} needed)");
+			return null;
+		}
+
+		var sampleLengths = new long [sampleAssemblies.Count];
+		using var samples = new MemoryStream ();
+		for (int i = 0; i < sampleAssemblies.Count; i++) {
+			using var fs = File.Open (sampleAssemblies [i], FileMode.Open, FileAccess.Read, FileShare.Read);
+			fs.CopyTo (samples);
+			sampleLengths [i] = fs.Length;
+		}
+
+		ZstandardDictionary trained;
+		try {
+			trained = ZstandardDictionary.Train (samples.GetBuffer ().AsSpan (0, (int) samples.Length), sampleLengths, MaximumDictionarySize);
+		} catch (Exception ex) {
+			log.LogDebugMessage ($"Failed to train a compression dictionary: {ex.Message}");
+			return null;
+		}
+
+		byte[] data;
+		using (trained) {
+			data = trained.Data.ToArray ();
+		}
+
+		// Only dictionaries in the Zstandard format carry an ID, which the runtime requires
+		if (data.Length < 2 * sizeof (uint) || BinaryPrimitives.ReadUInt32LittleEndian (data) != ZstandardDictionaryMagic) {
+			log.LogDebugMessage ("Trained compression dictionary is not in the Zstandard format, ignoring it");
+			return null;
+		}
+
+		// ID 0 means "no dictionary" in the compressed assembly header
+		uint id = BinaryPrimitives.ReadUInt32LittleEndian (data.AsSpan (sizeof (uint)));
+		if (id == 0) {
+			log.LogDebugMessage ("Trained compression dictionary has no ID, ignoring it");
+			return null;
+		}
+
+		return new AssemblyCompressionDictionary (id, data, ZstandardDictionary.Create (data, compressionLevel));
+	}
+
+	static CompressionResult Compress (string sourcePath, string outputFilePath, uint descriptorIndex, int compressionLevel, int chunkSize, AssemblyCompressionDictionary? dictionary, AssemblyCompressionCodec codec)
 	{
 		var outputDirectory = Path.GetDirectoryName (outputFilePath);
 		if (string.IsNullOrEmpty (outputDirectory))
@@ -71,20 +152,50 @@ static class AssemblyCompressor
 			if (bytesRead != fileSize)
 				return CompressionResult.EncodingFailed;
 
-			long maxOutputSize = ZstandardEncoder.GetMaxCompressedLength (bytesRead);
+			bool lz4 = codec == AssemblyCompressionCodec.LZ4;
+			bool seekable = !lz4 && chunkSize > 0 && bytesRead / chunkSize >= MinimumChunksPerAssembly;
+			int frameCount = seekable ? (bytesRead + chunkSize - 1) / chunkSize : 1;
+			int frameSize = seekable ? chunkSize : bytesRead;
+			bool useDictionary = !lz4 && dictionary != null && !seekable;
+
+			long maxOutputSize = lz4 ? LZ4Codec.MaximumOutputSize (bytesRead) : (long) frameCount * ZstandardEncoder.GetMaxCompressedLength (frameSize);
+			if (seekable)
+				maxOutputSize += 2 * sizeof (uint) + (long) frameCount * SeekTableEntrySize + SeekTableFooterSize;
 			if (maxOutputSize <= 0 || maxOutputSize > int.MaxValue)
 				return CompressionResult.EncodingFailed;
 
 			destBytes = bytePool.Rent ((int) maxOutputSize);
-			if (!ZstandardEncoder.TryCompress (sourceBytes.AsSpan (0, bytesRead), destBytes, out int encodedLength, compressionLevel, 0))
+			int encodedLength;
+			if (lz4) {
+				// Decompression speed doesn't depend on the level, only the build time does
+				encodedLength = LZ4Codec.Encode (sourceBytes, 0, bytesRead, destBytes, 0, (int) maxOutputSize, LZ4Level.L12_MAX);
+			} else if (seekable) {
+				encodedLength = CompressSeekable (sourceBytes.AsSpan (0, bytesRead), destBytes, chunkSize, frameCount, compressionLevel);
+			} else if (useDictionary) {
+				encodedLength = ZstandardEncoder.TryCompress (sourceBytes.AsSpan (0, bytesRead), destBytes, out int written, dictionary!.Dictionary, 0) ? written : -1;
+			} else {
+				encodedLength = ZstandardEncoder.TryCompress (sourceBytes.AsSpan (0, bytesRead), destBytes, out int written, compressionLevel, 0) ? written : -1;
+			}
+			if (encodedLength < 0)
 				return CompressionResult.EncodingFailed;
 
+			// Copying the data is cheaper than decompressing it, if compression doesn't save anything
+			byte[] data = destBytes;
+			if (encodedLength >= bytesRead) {
+				codec = AssemblyCompressionCodec.Stored;
+				useDictionary = false;
+				data = sourceBytes;
+				encodedLength = bytesRead;
+			}
+
 			using (var fs = File.Open (outputFilePath, FileMode.Create, FileAccess.Write, FileShare.Read))
 			using (var bw = new BinaryWriter (fs)) {
 				bw.Write (CompressedDataMagic);         // magic
 				bw.Write (descriptorIndex);             // index into runtime array of descriptors
 				bw.Write (checked ((uint) fi.Length));  // file size before compression
-				bw.Write (destBytes, 0, encodedLength);
+				bw.Write ((uint) codec);                // codec
+				bw.Write (useDictionary ? dictionary!.Id : 0u); // dictionary ID, must match the one stored in the assembly store
+				bw.Write (data, 0, encodedLength);
 				bw.Flush ();
 			}
 		} finally {
@@ -96,4 +207,70 @@ static class AssemblyCompressor
 
 		return CompressionResult.Success;
 	}
+
+	// Returns the length of the encoded data, or -1 on failure. Every frame but the last one
+	// decompresses to exactly `chunkSize` bytes, which the runtime relies on.
+	static int CompressSeekable (ReadOnlySpan<byte> source, byte[] destination, int chunkSize, int frameCount, int compressionLevel)
+	{
+		var seekTable = new (int compressed, int decompressed) [frameCount];
+		int encodedLength = 0;
+
+		for (int i = 0; i < frameCount; i++) {
+			int offset = i * chunkSize;
+			int length = Math.Min (chunkSize, source.Length - offset);
+			if (!ZstandardEncoder.TryCompress (source.Slice (offset, length), destination.AsSpan (encodedLength), out int written, compressionLevel, 0))
+				return -1;
+
+			seekTable [i] = (written, length);
+			encodedLength += written;
+		}
+
+		Span<byte> output = destination.AsSpan (encodedLength);
+		BinaryPrimitives.WriteUInt32LittleEndian (output, SkippableFrameMagic);
+		BinaryPrimitives.WriteUInt32LittleEndian (output.Slice (4), checked ((uint) (frameCount * SeekTableEntrySize + SeekTableFooterSize)));
+		output = output.Slice (8);
+
+		foreach ((int compressed, int decompressed) in seekTable) {
+			BinaryPrimitives.WriteUInt32LittleEndian (output, (uint) compressed);
+			BinaryPrimitives.WriteUInt32LittleEndian (output.Slice (4), (uint) decompressed);
+			output = output.Slice (SeekTableEntrySize);
+		}
+
+		BinaryPrimitives.WriteUInt32LittleEndian (output, (uint) frameCount);
+		output [4] = 0; // seek table descriptor: no per-frame checksums
+		BinaryPrimitives.WriteUInt32LittleEndian (output.Slice (5), SeekableMagic);
+
+		return encodedLength + 8 + frameCount * SeekTableEntrySize + SeekTableFooterSize;
+	}
+}
+
+/// <summary>
+/// The codec an assembly is compressed with.
+/// </summary>
+// Keep in sync with CompressionCodec in src/native/clr/include/xamarin-app.hh and src/native/mono/xamarin-app-stub/xamarin-app.hh
+enum AssemblyCompressionCodec : uint
+{
+	Stored    = 0,
+	Zstandard = 1,
+	LZ4       = 2,
+}
+
+/// <summary>
+/// A Zstandard dictionary shared by the assemblies of a single assembly store. <see cref="Data"/>
+/// is what ends up in the store.
+/// </summary>
+sealed class AssemblyCompressionDictionary : IDisposable
+{
+	public uint Id { get; }
+	public byte[] Data { get; }
+	public ZstandardDictionary Dictionary { get; }
+
+	public AssemblyCompressionDictionary (uint id, byte[] data, ZstandardDictionary dictionary)
+	{
+		Id = id;
+		Data = data;
+		Dictionary = dictionary;
+	}
+
+	public void Dispose () => Dictionary.Dispose ();
 }
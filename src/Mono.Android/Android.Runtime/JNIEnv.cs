@@ -461,10 +461,19 @@ namespace Android.Runtime {
 				if (RuntimeFeature.IsMonoRuntime) {
 					ret = monovm_typemap_managed_to_java (type, mvidptr);
 				} else if (RuntimeFeature.IsCoreClrRuntime) {
-					if (type.FullName is null)
-						return null;
-					string? assemblyFullName = RuntimeFeature.ManagedToJavaUsesAssemblyFullName ? type.Assembly.FullName : null;
-					ret = RuntimeNativeMethods.clr_typemap_managed_to_java (type.FullName, assemblyFullName, (IntPtr)mvidptr);
+					if (RuntimeFeature.ManagedToJavaUsesAssemblyFullName) {
+						if (type.FullName is null)
+							return null;
+						ret = RuntimeNativeMethods.clr_typemap_managed_to_java (type.FullName, type.Assembly.FullName, (IntPtr)mvidptr);
+					} else {
+						// The Release typemaps are searched by the hash of the type name, which needn't be computed on every call
+						TypemapName? name = TypemapName.ForType (type);
+						if (name is null)
+							return null;
+						fixed (byte* nameptr = name.Utf8Name) {
+							ret = RuntimeNativeMethods.clr_typemap_managed_to_java_hashed (nameptr, name.Length, name.Hash, null, (IntPtr)mvidptr);
+						}
+					}
 				} else {
 					throw new NotSupportedException ("Internal error: unknown runtime not supported");
 				}
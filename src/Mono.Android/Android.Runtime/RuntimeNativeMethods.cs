@@ -117,6 +117,17 @@ namespace Android.Runtime
 		[UnmanagedCallConv (CallConvs = new[] { typeof (CallConvCdecl) })]
 		internal static partial IntPtr clr_typemap_managed_to_java (string fullName, string? assemblyFullName, IntPtr mvid);
 
+		// The hash of the `nameLength` bytes of UTF-8 `name` which the typemap is keyed on, for
+		// `clr_typemap_managed_to_java_hashed`. Its kind depends on the typemap, so it must not be computed by managed code.
+		[LibraryImport (RuntimeConstants.InternalDllName)]
+		[UnmanagedCallConv (CallConvs = new[] { typeof (CallConvCdecl) })]
+		internal static partial ulong clr_typemap_hash_name (byte* name, uint nameLength);
+
+		// `fullName` is NUL-terminated UTF-8, `fullNameHash` its `clr_typemap_hash_name` as kept by `TypemapName`
+		[LibraryImport (RuntimeConstants.InternalDllName, StringMarshalling = StringMarshalling.Utf8)]
+		[UnmanagedCallConv (CallConvs = new[] { typeof (CallConvCdecl) })]
+		internal static partial IntPtr clr_typemap_managed_to_java_hashed (byte* fullName, uint fullNameLength, ulong fullNameHash, string? assemblyFullName, IntPtr mvid);
+
 		[LibraryImport (RuntimeConstants.InternalDllName, StringMarshalling = StringMarshalling.Utf8)]
 		[UnmanagedCallConv (CallConvs = new[] { typeof (CallConvCdecl) })]
 		[return: MarshalAs (UnmanagedType.U1)]
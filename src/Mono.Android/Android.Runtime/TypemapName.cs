@@ -0,0 +1,43 @@
+using System;
+using System.Runtime.CompilerServices;
+using System.Text;
+
+namespace Android.Runtime
+{
+	// The name of a managed type, in the form the CoreCLR typemap p/invokes consume, together with its length and hash.
+	// They are computed once per type, so that neither the managed nor the native side has to do it on every lookup.
+	// The hash comes from the runtime, which knows whether the typemap is keyed on CRC32 or xxh3 hashes.
+	sealed class TypemapName
+	{
+		static readonly ConditionalWeakTable<Type, TypemapName> cache = new ();
+
+		// NUL-terminated UTF-8
+		public readonly byte[] Utf8Name;
+		public readonly uint Length;
+		public readonly ulong Hash;
+
+		unsafe TypemapName (string name)
+		{
+			int length = Encoding.UTF8.GetByteCount (name);
+			Utf8Name = new byte [length + 1];
+			Encoding.UTF8.GetBytes (name, 0, name.Length, Utf8Name, 0);
+			Length = (uint)length;
+			fixed (byte* nameptr = Utf8Name) {
+				Hash = RuntimeNativeMethods.clr_typemap_hash_name (nameptr, Length);
+			}
+		}
+
+		public static TypemapName? ForType (Type type)
+		{
+			if (cache.TryGetValue (type, out TypemapName? ret)) {
+				return ret;
+			}
+
+			if (type.FullName is null) {
+				return null;
+			}
+
+			return cache.GetValue (type, static t => new TypemapName (t.FullName!));
+		}
+	}
+}
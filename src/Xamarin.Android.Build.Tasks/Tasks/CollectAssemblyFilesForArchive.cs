@@ -83,7 +83,7 @@ public class CollectAssemblyFilesToCompress : AndroidTask
 
 				var compressed_assembly = AssemblyCompression.GetCompressedAssemblyOutputPath (asm, AssemblyCompressionDirectory);
 
-				assemblies_to_compress.Add (CreateAssemblyToCompress (asm.ItemSpec, compressed_assembly, descriptor_index));
+				assemblies_to_compress.Add (CreateAssemblyToCompress (asm.ItemSpec, compressed_assembly, descriptor_index, MonoAndroidHelper.ArchToAbi (kvp.Key)));
 
 				// Mark this assembly as "compressed", if the compression process fails we will remove this metadata later
 				asm.SetMetadata ("CompressedAssembly", compressed_assembly);
@@ -95,11 +95,12 @@ public class CollectAssemblyFilesToCompress : AndroidTask
 		return !Log.HasLoggedErrors;
 	}
 
-	TaskItem CreateAssemblyToCompress (string sourceAssembly, string destinationAssembly, uint descriptorIndex)
+	TaskItem CreateAssemblyToCompress (string sourceAssembly, string destinationAssembly, uint descriptorIndex, string abi)
 	{
 		var item = new TaskItem (sourceAssembly);
 		item.SetMetadata ("DestinationPath", destinationAssembly);
 		item.SetMetadata ("DescriptorIndex", descriptorIndex.ToString ());
+		item.SetMetadata ("Abi", abi);
 
 		return item;
 	}
@@ -2,6 +2,7 @@
 
 using System;
 using System.Collections.Generic;
+using System.IO;
 using System.Linq;
 using Microsoft.Android.Build.Tasks;
 using Microsoft.Build.Framework;
@@ -10,7 +11,8 @@ using Microsoft.Build.Utilities;
 namespace Xamarin.Android.Tasks;
 
 /// <summary>
-/// If using $(AndroidUseAssemblyStore), place all the assemblies in a single assembly store file.
+/// If using $(AndroidUseAssemblyStore), place all the assemblies in a single assembly store file (per ABI) or, with
+/// CoreCLR and $(_AndroidAssemblyStoreSecondaryAssemblies), split them between a primary and secondary store files.
 /// </summary>
 public class CreateAssemblyStore : AndroidTask
 {
@@ -19,6 +21,12 @@ public class CreateAssemblyStore : AndroidTask
 	[Required]
 	public string AppSharedLibrariesDir { get; set; } = "";
 
+	/// <summary>
+	/// Zstandard dictionaries written by the <c>CompressAssemblies</c> task, named after the ABI
+	/// whose assemblies were compressed with them (e.g. <c>arm64-v8a.zdict</c>). CoreCLR only.
+	/// </summary>
+	public ITaskItem [] CompressionDictionaries { get; set; } = [];
+
 	public bool IncludeDebugSymbols { get; set; }
 
 	[Required]
@@ -27,12 +35,26 @@ public class CreateAssemblyStore : AndroidTask
 	[Required]
 	public ITaskItem [] ResolvedUserAssemblies { get; set; } = [];
 
+	/// <summary>
+	/// Assemblies to place in secondary assembly stores, which the runtime maps only when it first looks for an
+	/// assembly they contain. Each entry is an assembly name, optionally followed by <c>=</c> and the name of the
+	/// secondary store to place it in. Assemblies without a store name share a single store. CoreCLR only, ignored
+	/// for the other runtimes.
+	/// </summary>
+	public string [] SecondaryStoreAssemblies { get; set; } = [];
+
 	[Required]
 	public string [] SupportedAbis { get; set; } = [];
 
 	[Required]
 	public string TargetRuntime { get; set; } = "";
 
+	/// <summary>
+	/// Place the debug and config data of all the assemblies after all the assembly images, instead of
+	/// next to each image. CoreCLR only, ignored for the other runtimes.
+	/// </summary>
+	public bool TrailingDebugData { get; set; }
+
 	public bool UseAssemblyStore { get; set; }
 
 	[Output]
@@ -55,14 +77,39 @@ public class CreateAssemblyStore : AndroidTask
 		var store_builder = new AssemblyStoreBuilder (Log, targetRuntime);
 		var per_arch_assemblies = MonoAndroidHelper.GetPerArchAssemblies (assemblies, SupportedAbis, true);
 
+		if (TrailingDebugData && targetRuntime == AndroidRuntime.CoreCLR) {
+			store_builder.UseTrailingDebugData ();
+		}
+
+		foreach (ITaskItem dictionary in CompressionDictionaries) {
+			string abi = Path.GetFileNameWithoutExtension (dictionary.ItemSpec);
+			if (!SupportedAbis.Contains (abi)) {
+				continue;
+			}
+
+			store_builder.SetCompressionDictionary (MonoAndroidHelper.AbiToTargetArch (abi), dictionary.ItemSpec);
+			Log.LogDebugMessage ($"Adding compression dictionary '{dictionary.ItemSpec}' to the {abi} assembly store.");
+		}
+
+		Dictionary<string, uint>? secondary_store_numbers = null;
+		if (SecondaryStoreAssemblies.Length > 0 && targetRuntime == AndroidRuntime.CoreCLR) {
+			secondary_store_numbers = GetSecondaryStoreNumbers ();
+		}
+
 		foreach (var kvp in per_arch_assemblies) {
 			Log.LogDebugMessage ($"Adding assemblies for architecture '{kvp.Key}'");
 
 			foreach (var assembly in kvp.Value.Values) {
 				var sourcePath = assembly.GetMetadataOrDefault ("CompressedAssembly", assembly.ItemSpec);
-				store_builder.AddAssembly (sourcePath, assembly, includeDebugSymbols: IncludeDebugSymbols);
-
-				Log.LogDebugMessage ($"Added '{sourcePath}' to assembly store.");
+				uint store_number = 0;
+				secondary_store_numbers?.TryGetValue (GetAssemblyName (assembly.ItemSpec), out store_number);
+				store_builder.AddAssembly (sourcePath, assembly, includeDebugSymbols: IncludeDebugSymbols, storeNumber: store_number);
+
+				if (store_number == 0) {
+					Log.LogDebugMessage ($"Added '{sourcePath}' to assembly store.");
+				} else {
+					Log.LogDebugMessage ($"Added '{sourcePath}' to secondary assembly store {store_number}.");
+				}
 			}
 		}
 
@@ -76,11 +123,49 @@ public class CreateAssemblyStore : AndroidTask
 			throw new InvalidOperationException ("Internal error: assembly store did not generate store for each supported ABI");
 		}
 
-		AssembliesToAddToArchive = assembly_store_paths.Select (kvp => new TaskItem (kvp.Value, new Dictionary<string, string> { { "Abi", MonoAndroidHelper.ArchToAbi (kvp.Key) } })).ToArray ();
+		AssembliesToAddToArchive = assembly_store_paths
+			.SelectMany (kvp => kvp.Value.Select (path => new TaskItem (path, new Dictionary<string, string> { { "Abi", MonoAndroidHelper.ArchToAbi (kvp.Key) } })))
+			.ToArray ();
 
 		return !Log.HasLoggedErrors;
 	}
 
+	// Secondary stores are numbered in the order in which their names first appear in the list
+	Dictionary<string, uint> GetSecondaryStoreNumbers ()
+	{
+		var ret = new Dictionary<string, uint> (StringComparer.OrdinalIgnoreCase);
+		var store_numbers = new Dictionary<string, uint> (StringComparer.Ordinal);
+
+		foreach (string entry in SecondaryStoreAssemblies) {
+			string assembly_name = entry;
+			string store_name = String.Empty;
+			int separator = entry.IndexOf ('=');
+			if (separator >= 0) {
+				assembly_name = entry.Substring (0, separator);
+				store_name = entry.Substring (separator + 1).Trim ();
+			}
+
+			assembly_name = GetAssemblyName (assembly_name);
+			if (assembly_name.Length == 0) {
+				continue;
+			}
+
+			if (!store_numbers.TryGetValue (store_name, out uint store_number)) {
+				store_number = (uint)store_numbers.Count + 1;
+				store_numbers.Add (store_name, store_number);
+			}
+			ret[assembly_name] = store_number;
+		}
+
+		return ret;
+	}
+
+	static string GetAssemblyName (string path)
+	{
+		string name = Path.GetFileName (path.Trim ());
+		return name.EndsWith (".dll", StringComparison.OrdinalIgnoreCase) ? name.Substring (0, name.Length - 4) : name;
+	}
+
 	bool ShouldSkipAssembly (ITaskItem asm)
 	{
 		var should_skip = asm.GetMetadataOrDefault ("AndroidSkipAddToPackage", false);
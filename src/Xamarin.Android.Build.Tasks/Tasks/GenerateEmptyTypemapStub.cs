@@ -74,16 +74,31 @@ target triple = "{{triple}}"
 @type_map_assembly_names = dso_local constant [1 x i8] zeroinitializer, align 1
 @type_map_managed_type_names = dso_local constant [1 x i8] zeroinitializer, align 1
 @type_map_java_type_names = dso_local constant [1 x i8] zeroinitializer, align 1
+@type_map_name_index_size = dso_local constant i32 0, align 4
+@type_map_java_to_managed_index = dso_local constant [0 x i32] zeroinitializer, align 4
+@type_map_managed_to_java_index = dso_local constant [0 x i32] zeroinitializer, align 4
 """;
 		}
 
 		return header + """
 @managed_to_java_map_module_count = dso_local constant i32 0, align 4
 @managed_to_java_map = dso_local constant [0 x i8] zeroinitializer, align 8
+@managed_to_java_module_index_size = dso_local constant i32 0, align 4
+@managed_to_java_module_index = dso_local constant [0 x i32] zeroinitializer, align 4
 @java_to_managed_map = dso_local constant [0 x i8] zeroinitializer, align 8
+@typemap_name_hash_bits = dso_local constant i32 32, align 4
 @java_to_managed_hashes = dso_local constant [0 x i32] zeroinitializer, align 4
+@java_to_managed_hashes64 = dso_local constant [0 x i64] zeroinitializer, align 8
+@java_to_managed_perfect_hash_bucket_count = dso_local constant i32 0, align 4
+@java_to_managed_perfect_hash_slot_count = dso_local constant i32 0, align 4
+@java_to_managed_perfect_hash_displacements = dso_local constant [0 x i32] zeroinitializer, align 4
+@java_to_managed_perfect_hash_slots = dso_local constant [0 x i32] zeroinitializer, align 4
 @modules_map_data = dso_local constant [0 x i8] zeroinitializer, align 8
 @modules_duplicates_data = dso_local constant [0 x i8] zeroinitializer, align 8
+@modules_map_hashes = dso_local constant [0 x i32] zeroinitializer, align 4
+@modules_duplicates_hashes = dso_local constant [0 x i32] zeroinitializer, align 4
+@modules_map_hashes64 = dso_local constant [0 x i64] zeroinitializer, align 8
+@modules_duplicates_hashes64 = dso_local constant [0 x i64] zeroinitializer, align 8
 @java_type_count = dso_local constant i32 0, align 4
 @java_type_names = dso_local constant [1 x i8] zeroinitializer, align 1
 @java_type_names_size = dso_local constant i64 0, align 8
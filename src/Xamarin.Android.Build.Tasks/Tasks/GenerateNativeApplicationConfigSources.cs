@@ -67,6 +67,18 @@ namespace Xamarin.Android.Tasks
 		public bool EmitLlvmIrComments { get; set; }
 
 		public bool AndroidEnableAssemblyStoreDecompressionCache { get; set; }
+
+		/// <summary>
+		/// Maximum on-device size, in megabytes, of the decompressed-assembly cache. <c>0</c> means
+		/// there's no limit. Set from the <c>$(AndroidAssemblyStoreDecompressionCacheMaxSize)</c> MSBuild property.
+		/// </summary>
+		public int AndroidAssemblyStoreDecompressionCacheMaxSize { get; set; }
+
+		/// <summary>
+		/// Whether the assemblies compressed in chunks should be decompressed on demand, as their pages are
+		/// accessed, rather than eagerly. Set from the <c>$(_AndroidAssemblyStoreOnDemandDecompression)</c> MSBuild property.
+		/// </summary>
+		public bool AssemblyStoreOnDemandDecompression { get; set; }
 		public string? RuntimeConfigBinFilePath { get; set; }
 		public string ProjectRuntimeConfigFilePath { get; set; } = String.Empty;
 		public string? ProjectRuntimeConfigDevFilePath { get; set; }
@@ -295,6 +307,8 @@ namespace Xamarin.Android.Tasks
 					IgnoreSplitConfigs = ShouldIgnoreSplitConfigs (),
 					HaveAssemblyStore = UseAssemblyStore,
 					AssemblyStoreDecompressionCacheEnabled = AndroidEnableAssemblyStoreDecompressionCache,
+					AssemblyStoreDecompressionCacheMaxSizeMB = AndroidAssemblyStoreDecompressionCacheMaxSize,
+					AssemblyStoreOnDemandDecompression = AssemblyStoreOnDemandDecompression,
 				};
 			} else {
 				appConfigAsmGen = new ApplicationConfigNativeAssemblyGenerator (envBuilder.EnvironmentVariables, envBuilder.SystemProperties, Log) {
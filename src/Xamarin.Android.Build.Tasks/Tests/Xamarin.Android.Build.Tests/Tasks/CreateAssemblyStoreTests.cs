@@ -15,43 +15,317 @@ namespace Xamarin.Android.Build.Tests.Tasks;
 [TestFixture]
 public class CreateAssemblyStoreTests : BaseTest
 {
+	const uint StoreMagic = 0x41424158;
+	const int StoreHeaderSize = 5 * sizeof (uint) + sizeof (ulong);
+	const uint DictionaryFlag = 0x01000000;
+	const uint TrailingDebugDataFlag = 0x02000000;
+	const uint SecondaryStoresFlag = 0x04000000;
+
 	[Test]
 	public void ContentIdMatchesStoreContents ()
 	{
-		string testDirectory = Path.Combine (Root, "temp", nameof (ContentIdMatchesStoreContents));
+		string testDirectory = CreateTestDirectory (nameof (ContentIdMatchesStoreContents));
+		CreateAssemblyStore task = CreateTask (testDirectory, CreateAssembly (testDirectory, "Example.dll.zst", [1, 3, 3, 7, 9, 11, 17, 23]));
+
+		Assert.IsTrue (task.Execute (), "CreateAssemblyStore should succeed.");
+
+		StoreContents store = ReadStore (task.AssembliesToAddToArchive.Single ().ItemSpec);
+		Assert.AreEqual (0x80010007u, store.Version, "Unexpected arm64 assembly store version.");
+		Assert.AreEqual (
+			XxHash3.HashToUInt64 (store.Data.AsSpan (StoreHeaderSize)),
+			store.ContentId,
+			"The content ID should hash everything after the assembly store header."
+		);
+	}
+
+	[Test]
+	public void CompressionDictionaryFollowsTheNames ()
+	{
+		string testDirectory = CreateTestDirectory (nameof (CompressionDictionaryFollowsTheNames));
+
+		// Contents don't matter to the store generator, it's stored verbatim
+		string dictionaryPath = Path.Combine (testDirectory, "arm64-v8a.zdict");
+		byte [] dictionary = [0x37, 0xa4, 0x30, 0xec, 42, 0, 0, 0, 9, 8, 7];
+		File.WriteAllBytes (dictionaryPath, dictionary);
+
+		CreateAssemblyStore task = CreateTask (testDirectory, CreateAssembly (testDirectory, "Example.dll.zst", [1, 3, 3, 7]));
+		task.CompressionDictionaries = [new TaskItem (dictionaryPath)];
+
+		Assert.IsTrue (task.Execute (), "CreateAssemblyStore should succeed.");
+
+		StoreContents store = ReadStore (task.AssembliesToAddToArchive.Single ().ItemSpec);
+		Assert.AreEqual (0x80010007u | DictionaryFlag, store.Version, "Store version should have the dictionary flag set.");
+
+		using BinaryReader reader = store.OpenAt (store.OptionalSectionsOffset);
+		Assert.AreEqual ((uint)dictionary.Length, reader.ReadUInt32 (), "Unexpected dictionary size.");
+		CollectionAssert.AreEqual (dictionary, reader.ReadBytes (dictionary.Length), "Dictionary should be stored verbatim.");
+		Assert.AreEqual ((uint)reader.BaseStream.Position, store.Descriptors.Max (d => d.DataOffset), "Assembly data should follow the dictionary.");
+	}
+
+	[Test]
+	public void TrailingDebugDataFollowsAllImages ()
+	{
+		string testDirectory = CreateTestDirectory (nameof (TrailingDebugDataFollowsAllImages));
+
+		var assemblies = new List<ITaskItem> ();
+		for (int i = 0; i < 3; i++) {
+			ITaskItem assembly = CreateAssembly (testDirectory, $"Example{i}.dll", [(byte)i, 1, 3, 3, 7]);
+			File.WriteAllBytes (Path.ChangeExtension (assembly.ItemSpec, "pdb"), [(byte)i, 2, 4, 6]);
+			File.WriteAllText ($"{assembly.ItemSpec}.config", "<configuration />");
+			assemblies.Add (assembly);
+		}
+
+		CreateAssemblyStore task = CreateTask (testDirectory, assemblies.ToArray ());
+		task.IncludeDebugSymbols = true;
+		task.TrailingDebugData = true;
+
+		Assert.IsTrue (task.Execute (), "CreateAssemblyStore should succeed.");
+
+		StoreContents store = ReadStore (task.AssembliesToAddToArchive.Single ().ItemSpec);
+		Assert.AreEqual (TrailingDebugDataFlag, store.Version & TrailingDebugDataFlag, "Store version should have the trailing debug data flag set.");
+
+		using BinaryReader reader = store.OpenAt (store.OptionalSectionsOffset);
+		uint regionOffset = reader.ReadUInt32 ();
+		uint regionSize = reader.ReadUInt32 ();
+
+		List<StoreDescriptor> images = store.Assemblies.ToList ();
+		Assert.AreEqual ((uint)reader.BaseStream.Position, images.Min (d => d.DataOffset), "Assembly images should follow the debug data region section.");
+		Assert.AreEqual (regionOffset, images.Max (d => d.DataOffset + d.DataSize), "The debug data region should start right after the last image.");
+		Assert.AreEqual ((uint)store.Data.Length, regionOffset + regionSize, "The debug data region should end the store.");
+
+		foreach (StoreDescriptor image in images) {
+			Assert.IsTrue (image.DebugDataSize > 0 && image.ConfigDataSize > 0, $"'{image.Name}' should have its debug and config data stored.");
+			foreach ((uint offset, uint size) in new [] { (image.DebugDataOffset, image.DebugDataSize), (image.ConfigDataOffset, image.ConfigDataSize) }) {
+				Assert.IsTrue (offset >= regionOffset && offset + size <= regionOffset + regionSize, $"Debug data at {offset} should be within the region.");
+			}
+
+			// The first byte of both the image and the PDB is the assembly number
+			byte assemblyNumber = store.Data [image.DataOffset];
+			CollectionAssert.AreEqual (
+				new byte [] { assemblyNumber, 2, 4, 6 },
+				store.Data.AsSpan ((int)image.DebugDataOffset, (int)image.DebugDataSize).ToArray (),
+				$"Unexpected debug data of assembly {assemblyNumber}."
+			);
+		}
+	}
+
+	[Test]
+	public void PerfectHashIndexResolvesAllNames ()
+	{
+		string testDirectory = CreateTestDirectory (nameof (PerfectHashIndexResolvesAllNames));
+
+		var assemblies = new List<ITaskItem> ();
+		for (int i = 0; i < 200; i++) {
+			assemblies.Add (CreateAssembly (testDirectory, $"Example{i}.dll", [(byte)i, 1, 3, 3, 7]));
+		}
+
+		CreateAssemblyStore task = CreateTask (testDirectory, assemblies.ToArray ());
+
+		Assert.IsTrue (task.Execute (), "CreateAssemblyStore should succeed.");
+
+		StoreContents store = ReadStore (task.AssembliesToAddToArchive.Single ().ItemSpec);
+		Assert.AreEqual (0x80010007u, store.Version, "Store should use the perfect hash index.");
+
+		using BinaryReader reader = store.OpenAt (StoreHeaderSize);
+		var indexHashes = new uint [store.IndexEntryCount];
+		var indexDescriptors = new uint [store.IndexEntryCount];
+		for (uint i = 0; i < store.IndexEntryCount; i++) {
+			indexHashes [i] = reader.ReadUInt32 ();
+			indexDescriptors [i] = reader.ReadUInt32 ();
+			reader.ReadByte (); // ignore
+		}
+
+		uint bucketCount = reader.ReadUInt32 ();
+		var displacements = new uint [bucketCount];
+		for (uint i = 0; i < bucketCount; i++) {
+			displacements [i] = reader.ReadUInt32 ();
+		}
+		Assert.AreEqual (store.IndexSize, store.IndexEntryCount * 9 + (bucketCount + 1) * sizeof (uint), "Index size should cover the entries and the displacement table.");
+
+		for (int i = 0; i < store.Descriptors.Count; i++) {
+			AssertResolves (store.Descriptors [i].Name, i);
+			AssertResolves (Path.GetFileNameWithoutExtension (store.Descriptors [i].Name), i);
+		}
+
+		void AssertResolves (string name, int expectedDescriptor)
+		{
+			uint hash = Crc32.HashToUInt32 (System.Text.Encoding.UTF8.GetBytes (name));
+			uint bucket = MinimalPerfectHash.GetBucket (hash, bucketCount);
+			uint slot = MinimalPerfectHash.GetSlot (hash, displacements [bucket], store.IndexEntryCount);
+			Assert.AreEqual (hash, indexHashes [slot], $"Slot {slot} should contain the hash of '{name}'.");
+			Assert.AreEqual ((uint)expectedDescriptor, indexDescriptors [slot], $"'{name}' should resolve to descriptor {expectedDescriptor}.");
+		}
+	}
+
+	[Test]
+	public void SecondaryStoresAreListedInPrimaryStore ()
+	{
+		string testDirectory = CreateTestDirectory (nameof (SecondaryStoresAreListedInPrimaryStore));
+
+		var assemblies = new List<ITaskItem> ();
+		foreach (string name in new [] { "Startup", "Maps", "Chat", "Chat.Emoji" }) {
+			assemblies.Add (CreateAssembly (testDirectory, $"{name}.dll", [1, 3, 3, 7]));
+		}
+
+		CreateAssemblyStore task = CreateTask (testDirectory, assemblies.ToArray ());
+		task.SecondaryStoreAssemblies = ["Maps", "Chat=chat", "Chat.Emoji.dll=chat"];
+
+		Assert.IsTrue (task.Execute (), "CreateAssemblyStore should succeed.");
+
+		string [] storePaths = task.AssembliesToAddToArchive.Select (i => i.ItemSpec).ToArray ();
+		CollectionAssert.AreEqual (
+			new [] { "assembly-store.so", "assembly-store-1.so", "assembly-store-2.so" },
+			storePaths.Select (p => Path.GetFileName (p)).ToArray (),
+			"The primary store should be followed by the secondary stores."
+		);
+
+		StoreContents primary = ReadStore (storePaths [0]);
+		StoreContents maps = ReadStore (storePaths [1]);
+		StoreContents chat = ReadStore (storePaths [2]);
+		Assert.AreEqual (SecondaryStoresFlag, primary.Version & SecondaryStoresFlag, "Primary store should have the secondary stores flag set.");
+		Assert.AreEqual (0u, maps.Version & SecondaryStoresFlag, "Secondary stores should not list other stores.");
+		CollectionAssert.AreEquivalent (new [] { "Startup.dll" }, primary.Assemblies.Select (d => d.Name));
+		CollectionAssert.AreEquivalent (new [] { "Maps.dll" }, maps.Assemblies.Select (d => d.Name));
+		CollectionAssert.AreEquivalent (new [] { "Chat.dll", "Chat.Emoji.dll" }, chat.Assemblies.Select (d => d.Name));
+		CollectionAssert.AreEquivalent (
+			Enumerable.Range (0, 4).Select (i => (uint)i).ToArray (),
+			new [] { primary, maps, chat }.SelectMany (s => s.Assemblies).Select (d => d.MappingIndex).ToArray (),
+			"Mapping indices should be unique across all the stores."
+		);
+
+		using BinaryReader reader = primary.OpenAt (primary.OptionalSectionsOffset);
+		Assert.AreEqual (2u, reader.ReadUInt32 (), "Unexpected secondary store count.");
+		uint indexEntryCount = reader.ReadUInt32 ();
+		Assert.AreEqual (maps.ContentId, reader.ReadUInt64 (), "Unexpected content ID of the first secondary store.");
+		Assert.AreEqual (chat.ContentId, reader.ReadUInt64 (), "Unexpected content ID of the second secondary store.");
+
+		var secondaryIndex = new List<(uint hash, uint store)> ();
+		for (uint i = 0; i < indexEntryCount; i++) {
+			secondaryIndex.Add ((reader.ReadUInt32 (), reader.ReadUInt32 ()));
+		}
+		CollectionAssert.AreEqual (secondaryIndex.OrderBy (e => e.hash).ToArray (), secondaryIndex, "Secondary index should be sorted by name hash.");
+
+		foreach (string name in new [] { "Maps", "Maps.dll" }) {
+			AssertListed (name, 1);
+		}
+		foreach (string name in new [] { "Chat", "Chat.dll", "Chat.Emoji", "Chat.Emoji.dll" }) {
+			AssertListed (name, 2);
+		}
+		uint startupHash = Crc32.HashToUInt32 (System.Text.Encoding.UTF8.GetBytes ("Startup"));
+		Assert.IsFalse (secondaryIndex.Any (e => e.hash == startupHash), "Assemblies of the primary store should not be in the secondary index.");
+
+		void AssertListed (string name, uint expectedStore)
+		{
+			uint hash = Crc32.HashToUInt32 (System.Text.Encoding.UTF8.GetBytes (name));
+			Assert.IsTrue (secondaryIndex.Contains ((hash, expectedStore)), $"'{name}' should be listed in secondary store {expectedStore}.");
+		}
+	}
+
+	string CreateTestDirectory (string testName)
+	{
+		string testDirectory = Path.Combine (Root, "temp", testName);
 		Directory.CreateDirectory (testDirectory);
+		return testDirectory;
+	}
 
-		string assemblyPath = Path.Combine (testDirectory, "Example.dll.zst");
-		byte [] assemblyData = [1, 3, 3, 7, 9, 11, 17, 23];
-		File.WriteAllBytes (assemblyPath, assemblyData);
+	static ITaskItem CreateAssembly (string testDirectory, string fileName, byte [] contents)
+	{
+		string assemblyPath = Path.Combine (testDirectory, fileName);
+		File.WriteAllBytes (assemblyPath, contents);
 
 		var metadata = new Dictionary<string, string> {
 			["Abi"] = "arm64-v8a",
 		};
-		var task = new CreateAssemblyStore {
+		return new TaskItem (assemblyPath, metadata);
+	}
+
+	static CreateAssemblyStore CreateTask (string testDirectory, params ITaskItem [] assemblies)
+	{
+		return new CreateAssemblyStore {
 			BuildEngine = new MockBuildEngine (TestContext.Out),
 			AppSharedLibrariesDir = Path.Combine (testDirectory, "stores"),
 			ResolvedFrameworkAssemblies = [],
-			ResolvedUserAssemblies = [new TaskItem (assemblyPath, metadata)],
+			ResolvedUserAssemblies = assemblies,
 			SupportedAbis = ["arm64-v8a"],
 			TargetRuntime = "CoreCLR",
 			UseAssemblyStore = true,
 		};
+	}
 
-		Assert.IsTrue (task.Execute (), "CreateAssemblyStore should succeed.");
+	sealed class StoreDescriptor
+	{
+		public uint MappingIndex;
+		public uint DataOffset;
+		public uint DataSize;
+		public uint DebugDataOffset;
+		public uint DebugDataSize;
+		public uint ConfigDataOffset;
+		public uint ConfigDataSize;
+		public string Name = "";
 
-		string storePath = task.AssembliesToAddToArchive.Single ().ItemSpec;
-		byte [] store = File.ReadAllBytes (storePath);
-		using var reader = new BinaryReader (new MemoryStream (store));
-		Assert.AreEqual (0x41424158u, reader.ReadUInt32 (), "Unexpected assembly store magic.");
-		Assert.AreEqual (0x80010004u, reader.ReadUInt32 (), "Unexpected arm64 assembly store version.");
-		reader.BaseStream.Seek (3 * sizeof (uint), SeekOrigin.Current);
-		ulong contentId = reader.ReadUInt64 ();
+		// `.ni.dll` entries have no data
+		public bool IsIgnored => DataSize == 0;
+	}
 
-		Assert.AreEqual (
-			XxHash3.HashToUInt64 (store.AsSpan (5 * sizeof (uint) + sizeof (ulong))),
-			contentId,
-			"The content ID should hash everything after the assembly store header."
-		);
+	sealed class StoreContents
+	{
+		public byte [] Data = [];
+		public uint Version;
+		public uint IndexEntryCount;
+		public uint IndexSize;
+		public ulong ContentId;
+		public List<StoreDescriptor> Descriptors = new ();
+
+		// Right after the names, where the sections present only with some of the version flags start
+		public long OptionalSectionsOffset;
+
+		public IEnumerable<StoreDescriptor> Assemblies => Descriptors.Where (d => !d.IsIgnored);
+
+		public BinaryReader OpenAt (long offset)
+		{
+			var reader = new BinaryReader (new MemoryStream (Data));
+			reader.BaseStream.Seek (offset, SeekOrigin.Begin);
+			return reader;
+		}
+	}
+
+	// Reads the header, the descriptors and the names, which all the store versions have
+	static StoreContents ReadStore (string storePath)
+	{
+		var ret = new StoreContents {
+			Data = File.ReadAllBytes (storePath),
+		};
+
+		using BinaryReader reader = ret.OpenAt (0);
+		Assert.AreEqual (StoreMagic, reader.ReadUInt32 (), $"Unexpected magic of assembly store '{storePath}'.");
+		ret.Version = reader.ReadUInt32 ();
+		uint entryCount = reader.ReadUInt32 ();
+		ret.IndexEntryCount = reader.ReadUInt32 ();
+		ret.IndexSize = reader.ReadUInt32 ();
+		ret.ContentId = reader.ReadUInt64 ();
+
+		reader.BaseStream.Seek (ret.IndexSize, SeekOrigin.Current);
+		var nameLocations = new List<(uint offset, uint length)> ();
+		for (uint i = 0; i < entryCount; i++) {
+			ret.Descriptors.Add (new StoreDescriptor {
+				MappingIndex = reader.ReadUInt32 (),
+				DataOffset = reader.ReadUInt32 (),
+				DataSize = reader.ReadUInt32 (),
+				DebugDataOffset = reader.ReadUInt32 (),
+				DebugDataSize = reader.ReadUInt32 (),
+				ConfigDataOffset = reader.ReadUInt32 (),
+				ConfigDataSize = reader.ReadUInt32 (),
+			});
+			nameLocations.Add ((reader.ReadUInt32 (), reader.ReadUInt32 ()));
+		}
+
+		for (int i = 0; i < entryCount; i++) {
+			uint length = reader.ReadUInt32 ();
+			Assert.AreEqual (((uint)reader.BaseStream.Position, length), nameLocations [i], $"Descriptor {i} should point at its name.");
+			ret.Descriptors [i].Name = System.Text.Encoding.UTF8.GetString (reader.ReadBytes ((int)length));
+		}
+		ret.OptionalSectionsOffset = reader.BaseStream.Position;
+
+		return ret;
 	}
 }
@@ -0,0 +1,82 @@
+#nullable enable
+using System;
+using System.Collections.Generic;
+using System.Linq;
+
+using NUnit.Framework;
+using Xamarin.Android.Tasks;
+
+namespace Xamarin.Android.Build.Tests.Tasks;
+
+[TestFixture]
+public class EytzingerLayoutTests : BaseTest
+{
+	// The runtime looks up the managed-to-Java map entries with `Search::eytzinger_lower_bound` and visits all the
+	// entries with the same hash with `Search::eytzinger_next`, the two functions are mirrored here
+	[Test]
+	public void LowerBoundMatchesSortedTable ([Values (1, 2, 63, 64, 100, 1000)] int count)
+	{
+		var sorted = new List<uint> ();
+		for (int i = 0; i < count; i++) {
+			sorted.Add (TypeMapHelper.HashNameForCLR ($"Company.Product.Feature{i % 17}.Type{i}, Company.Product"));
+		}
+
+		// Simulate managed type names whose hashes collide
+		if (count > 10) {
+			sorted [3] = sorted [10];
+			sorted [4] = sorted [10];
+		}
+		sorted.Sort ();
+
+		var eytzinger = new List<uint> (sorted);
+		EytzingerLayout.Apply (eytzinger);
+
+		var keys = new List<uint> (sorted) { 0, UInt32.MaxValue };
+		keys.AddRange (sorted.Select (h => h + 1));
+
+		foreach (uint key in keys) {
+			var expected = sorted.Where (h => h == key).ToList ();
+			var actual = new List<uint> ();
+			for (int idx = EytzingerLowerBound (eytzinger, key); idx < count && eytzinger [idx] == key; idx = EytzingerNext (idx, count)) {
+				actual.Add (eytzinger [idx]);
+			}
+
+			CollectionAssert.AreEqual (expected, actual, $"Eytzinger search for 0x{key:x} disagrees with the sorted table");
+		}
+
+		var inOrder = new List<uint> ();
+		for (int idx = EytzingerLowerBound (eytzinger, 0); idx < count; idx = EytzingerNext (idx, count)) {
+			inOrder.Add (eytzinger [idx]);
+		}
+		CollectionAssert.AreEqual (sorted, inOrder, "In-order walk should visit the entries in sorted order");
+	}
+
+	static int EytzingerLowerBound (List<uint> arr, uint key)
+	{
+		ulong k = 1;
+		while (k <= (ulong)arr.Count) {
+			k = 2 * k + (arr [(int)k - 1] < key ? 1ul : 0ul);
+		}
+
+		k >>= System.Numerics.BitOperations.TrailingZeroCount (~k) + 1;
+		return k == 0 ? arr.Count : (int)k - 1;
+	}
+
+	static int EytzingerNext (int idx, int n)
+	{
+		int k = idx + 1;
+		if (2 * k + 1 <= n) {
+			k = 2 * k + 1;
+			while (2 * k <= n) {
+				k = 2 * k;
+			}
+			return k - 1;
+		}
+
+		while ((k & 1) != 0) {
+			k >>= 1;
+		}
+		k >>= 1;
+		return k == 0 ? n : k - 1;
+	}
+}
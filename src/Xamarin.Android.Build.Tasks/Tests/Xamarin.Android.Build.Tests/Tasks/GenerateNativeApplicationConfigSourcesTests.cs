@@ -43,11 +43,11 @@ public class GenerateNativeApplicationConfigSourcesTests : BaseTest
 		Assert.AreEqual (haveAssemblyStore, config.have_assembly_store);
 	}
 
-	[TestCase (false)]
-	[TestCase (true)]
-	public void AssemblyStoreDecompressionCacheSettingIsEmitted (bool enabled)
+	[TestCase (false, 0, false)]
+	[TestCase (true, 64, true)]
+	public void AssemblyStoreDecompressionCacheSettingIsEmitted (bool enabled, int maxSizeMB, bool onDemandDecompression)
 	{
-		string outputRoot = Path.Combine (Root, "temp", $"{nameof (AssemblyStoreDecompressionCacheSettingIsEmitted)}-{enabled}");
+		string outputRoot = Path.Combine (Root, "temp", $"{nameof (AssemblyStoreDecompressionCacheSettingIsEmitted)}-{enabled}-{maxSizeMB}-{onDemandDecompression}");
 		string monoAndroidPath = Path.Combine (TestEnvironment.MonoAndroidFrameworkDirectory, "Mono.Android.dll");
 		FileAssert.Exists (monoAndroidPath);
 
@@ -62,6 +62,8 @@ public class GenerateNativeApplicationConfigSourcesTests : BaseTest
 			AndroidRuntime = "CoreCLR",
 			UseAssemblyStore = true,
 			AndroidEnableAssemblyStoreDecompressionCache = enabled,
+			AndroidAssemblyStoreDecompressionCacheMaxSize = maxSizeMB,
+			AssemblyStoreOnDemandDecompression = onDemandDecompression,
 		};
 
 		Assert.IsTrue (task.Execute (), "GenerateNativeApplicationConfigSources should succeed.");
@@ -74,5 +76,7 @@ public class GenerateNativeApplicationConfigSourcesTests : BaseTest
 		);
 		var config = (EnvironmentHelper.ApplicationConfig_CoreCLR)EnvironmentHelper.ReadApplicationConfig (environmentFiles, AndroidRuntime.CoreCLR);
 		Assert.AreEqual (enabled, config.assembly_store_decompression_cache_enabled);
+		Assert.AreEqual ((uint)maxSizeMB, config.assembly_store_decompression_cache_max_size_mb);
+		Assert.AreEqual (onDemandDecompression, config.assembly_store_on_demand_decompression);
 	}
 }
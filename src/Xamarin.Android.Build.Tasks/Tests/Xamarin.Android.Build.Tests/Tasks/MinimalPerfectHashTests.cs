@@ -0,0 +1,48 @@
+#nullable enable
+using System;
+using System.Collections.Generic;
+
+using NUnit.Framework;
+using Xamarin.Android.Tasks;
+
+namespace Xamarin.Android.Build.Tests.Tasks;
+
+[TestFixture]
+public class MinimalPerfectHashTests : BaseTest
+{
+	[Test]
+	public void SortedHashesWithDuplicatesMapToFirstOccurrence ()
+	{
+		var hashes = new List<uint> ();
+		for (int i = 0; i < 500; i++) {
+			hashes.Add (TypeMapHelper.HashNameForCLR ($"crc64{i:x16}/Type{i}"));
+		}
+
+		// Simulate Java type names whose hashes collide, the generator keeps all of them next to each other
+		hashes.Add (hashes [7]);
+		hashes.Add (hashes [7]);
+		hashes.Add (hashes [123]);
+		hashes.Sort ();
+
+		Assert.IsTrue (MinimalPerfectHash.TryBuildForSortedHashes (hashes, out uint[] displacements, out uint[] slots), "Perfect hash table should be built");
+
+		var distinctHashes = new HashSet<uint> (hashes);
+		Assert.AreEqual (distinctHashes.Count, slots.Length, "There should be one slot per distinct hash");
+		Assert.AreEqual (MinimalPerfectHash.GetBucketCount (slots.Length), (uint)displacements.Length, "There should be one displacement per bucket");
+
+		for (int i = 0; i < hashes.Count; i++) {
+			uint hash = hashes [i];
+			uint bucket = MinimalPerfectHash.GetBucket (hash, (uint)displacements.Length);
+			uint entryIndex = slots [MinimalPerfectHash.GetSlot (hash, displacements [bucket], (uint)slots.Length)];
+
+			Assert.AreEqual (hash, hashes [(int)entryIndex], $"Hash 0x{hash:x} maps to the wrong entry");
+			Assert.IsTrue (entryIndex == 0 || hashes [(int)entryIndex - 1] != hash, $"Hash 0x{hash:x} doesn't map to its first occurrence");
+		}
+	}
+
+	[Test]
+	public void UnsortedHashesAreRejected ()
+	{
+		Assert.Throws<ArgumentException> (() => MinimalPerfectHash.TryBuildForSortedHashes (new uint[] { 3, 1, 2 }, out _, out _));
+	}
+}
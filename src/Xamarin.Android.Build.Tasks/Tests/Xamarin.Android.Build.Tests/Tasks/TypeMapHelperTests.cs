@@ -0,0 +1,26 @@
+#nullable enable
+using System;
+
+using NUnit.Framework;
+using Xamarin.Android.Tasks;
+
+namespace Xamarin.Android.Build.Tests.Tasks;
+
+[TestFixture]
+public class TypeMapHelperTests : BaseTest
+{
+	// The native runtime hashes must be identical, the same values are checked against all the `Crc32` implementations in
+	// src/native/host-tests/crc32-tests.cc
+	[TestCase ("", 0xffffffffu)]
+	[TestCase ("a", 0xe8b7be43u)]
+	[TestCase ("123456789", 0xcbf43926u)]
+	[TestCase ("java/lang/Object", 0x7cb3837du)]
+	[TestCase ("Android.App.Activity, Mono.Android", 0xed93ff66u)]
+	[TestCase ("crc32/Zażółć gęślą jaźń", 0x04a39337u)]
+	[TestCase ("The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog.", 0x9ae90aa7u)]
+	[TestCase ("System.Collections.Generic.Dictionary`2+ValueCollection+Enumerator[[System.String, System.Private.CoreLib],[System.Object, System.Private.CoreLib]], System.Private.CoreLib", 0x76712dadu)]
+	public void HashNameForCLRMatchesNativeHashes (string name, uint expected)
+	{
+		Assert.AreEqual (expected, TypeMapHelper.HashNameForCLR (name), $"Hash of '{name}'");
+	}
+}
@@ -0,0 +1,200 @@
+#nullable enable
+using System;
+using System.Collections;
+using System.Collections.Generic;
+using System.Linq;
+
+using Microsoft.Build.Utilities;
+using NUnit.Framework;
+using Xamarin.Android.Tasks;
+using Xamarin.Android.Tasks.LLVMIR;
+
+using TypeMapDebugAssembly = Xamarin.Android.Tasks.TypeMapGenerator.TypeMapDebugAssembly;
+using TypeMapDebugEntry = Xamarin.Android.Tasks.TypeMapGenerator.TypeMapDebugEntry;
+
+namespace Xamarin.Android.Build.Tests.Tasks;
+
+[TestFixture]
+public class TypeMapNameHashIndexTests : BaseTest
+{
+	const string MonoAndroidFullName = "Mono.Android, Version=0.0.0.0, Culture=neutral, PublicKeyToken=84e04ff9cfb79065";
+	const string AppFullName = "HelloAndroid, Version=1.0.0.0, Culture=neutral, PublicKeyToken=null";
+
+	sealed class EmittedRow
+	{
+		public string From = String.Empty;
+		public uint FromHash;
+		public uint To;
+	}
+
+	// Every entry of the name indexes emitted by the CoreCLR debug typemap generator must point to the table row the
+	// runtime would find for the entry's name (see `TypeMapper::find_index_by_name_index`)
+	[Test]
+	public void GeneratedIndexesMatchGeneratedTables ()
+	{
+		var activity = Entry ("android/app/Activity", "Android.App.Activity, Mono.Android", 0x02000010);
+		var bundle = Entry ("android/os/Bundle", "Android.OS.Bundle, Mono.Android", 0x02000011);
+		var view = Entry ("android/view/View", "Android.Views.View, Mono.Android", 0x02000012);
+		var onClickListener = Entry ("android/view/View$OnClickListener", "Android.Views.View/IOnClickListener, Mono.Android", 0x02000013);
+		var onClickListenerInvoker = Entry ("android/view/View$OnClickListener", "Android.Views.View/IOnClickListenerInvoker, Mono.Android", 0x02000014);
+		var javaObject = Entry ("java/lang/Object", "Java.Lang.Object, Mono.Android", 0x02000015);
+		var javaString = Entry ("java/lang/String", "Java.Lang.String, Mono.Android", 0x02000016);
+		var throwable = Entry ("java/lang/Throwable", "Java.Lang.Throwable, Mono.Android", 0x02000017);
+		var mainActivity = Entry ("crc64a0e0a82d0db9a07d/MainActivity", "HelloAndroid.MainActivity, HelloAndroid", 0x02000002, AppFullName);
+
+		// Interfaces aren't instantiated from Java, their invokers are
+		onClickListener.SkipInJavaToManaged = true;
+		onClickListenerInvoker.DuplicateForJavaToManaged = onClickListener;
+
+		var entries = new List<TypeMapDebugEntry> {
+			activity, bundle, view, onClickListener, onClickListenerInvoker, javaObject, javaString, throwable, mainActivity,
+		};
+
+		// Sorted the same way `TypeMapGenerator` sorts them before passing them to the generator
+		var data = new TypeMapGenerator.ModuleDebugData {
+			EntryCount = (uint)entries.Count,
+			JavaToManagedMap = entries.OrderBy (e => e.JavaName, StringComparer.Ordinal).ToList (),
+			ManagedToJavaMap = entries.OrderBy (e => e.ManagedName, StringComparer.Ordinal).ToList (),
+			UniqueAssemblies = new List<TypeMapDebugAssembly> {
+				new TypeMapDebugAssembly { Name = "Mono.Android" },
+				new TypeMapDebugAssembly { Name = "HelloAndroid" },
+			},
+		};
+
+		var log = new TaskLoggingHelper (new MockBuildEngine (TestContext.Out, [], [], []), TestName);
+		LlvmIrModule module = new TypeMappingDebugNativeAssemblyGeneratorCLR (log, data).Construct ();
+
+		Dictionary<uint, string> javaNames = GetBlobStrings (module, "type_map_java_type_names");
+		Dictionary<uint, string> managedNames = GetBlobStrings (module, "type_map_managed_type_names");
+		List<EmittedRow> javaToManaged = GetRows (module, "map_java_to_managed", javaNames);
+		List<EmittedRow> managedToJava = GetRows (module, "map_managed_to_java", managedNames);
+		var indexSize = (uint)GetGlobal (module, "type_map_name_index_size");
+		var javaToManagedIndex = (List<uint>)GetGlobal (module, "type_map_java_to_managed_index");
+		var managedToJavaIndex = (List<uint>)GetGlobal (module, "type_map_managed_to_java_index");
+
+		Assert.AreEqual (entries.Count, javaToManaged.Count, "Number of java_to_managed rows");
+		Assert.AreEqual (entries.Count, managedToJava.Count, "Number of managed_to_java rows");
+		Assert.AreEqual (TypeMapNameHashIndex.GetSize ((uint)entries.Count), indexSize, "Name index size");
+		CollectionAssert.AreEquivalent (entries.Select (e => e.JavaName), javaToManaged.Select (r => r.From), "java_to_managed row names");
+		CollectionAssert.AreEquivalent (
+			entries.Select (e => e.ManagedName.Replace (", Mono.Android", $", {MonoAndroidFullName}").Replace (", HelloAndroid", $", {AppFullName}")),
+			managedToJava.Select (r => r.From),
+			"managed_to_java row names"
+		);
+
+		AssertIndexMatchesRows ("java_to_managed", javaToManaged, javaToManagedIndex, indexSize);
+		AssertIndexMatchesRows ("managed_to_java", managedToJava, managedToJavaIndex, indexSize);
+
+		Assert.AreEqual (-1, FindInIndex (javaToManaged, javaToManagedIndex, "android/widget/Button"), "Unmapped Java type found in the index");
+		Assert.AreEqual (-1, FindInIndex (managedToJava, managedToJavaIndex, $"Android.Widget.Button, {MonoAndroidFullName}"), "Unmapped managed type found in the index");
+
+		// Java-to-managed rows and managed type infos are emitted in the same order
+		IList typeInfos = (IList)GetGlobal (module, "type_map_managed_type_info");
+		Assert.AreEqual (javaToManaged.Count, typeInfos.Count, "Number of managed type infos");
+		for (int i = 0; i < javaToManaged.Count; i++) {
+			EmittedRow row = javaToManaged [i];
+			if (row.To == UInt32.MaxValue) {
+				Assert.AreEqual (onClickListener.JavaName, row.From, $"Unexpected java_to_managed row {i} without a managed type");
+				continue;
+			}
+
+			Assert.AreEqual (GetField<string> ((StructureInstance)typeInfos [i]!, "ManagedTypeName"), managedNames [row.To], $"Managed type of java_to_managed row {i}");
+		}
+	}
+
+	[Test]
+	public void EmptyMapHasNoIndex ()
+	{
+		uint indexSize = TypeMapNameHashIndex.GetSize (0);
+		Assert.AreEqual (0u, indexSize);
+		Assert.IsEmpty (TypeMapNameHashIndex.Build (new List<uint> (), indexSize));
+	}
+
+	static void AssertIndexMatchesRows (string table, List<EmittedRow> rows, List<uint> index, uint indexSize)
+	{
+		Assert.AreEqual (indexSize, (uint)index.Count, $"Size of the {table} name index");
+		CollectionAssert.AreEquivalent (
+			Enumerable.Range (1, rows.Count).Select (i => (uint)i),
+			index.Where (v => v != 0),
+			$"Every {table} row must be in the name index exactly once"
+		);
+
+		for (int i = 0; i < rows.Count; i++) {
+			EmittedRow row = rows [i];
+			Assert.AreEqual (TypeMapHelper.HashNameForCLR (row.From), row.FromHash, $"Hash of {table} row {i} ('{row.From}')");
+
+			// Rows with duplicate names must resolve to the first of them, same as the binary search of the sorted table
+			int expected = rows.FindIndex (r => String.Equals (r.From, row.From, StringComparison.Ordinal));
+			int found = FindInIndex (rows, index, row.From);
+			Assert.AreEqual (expected, found, $"Name index lookup of {table} row {i} ('{row.From}')");
+			Assert.AreEqual (rows [expected].To, rows [found].To, $"Target of {table} row {i} ('{row.From}')");
+		}
+	}
+
+	// Mirrors `TypeMapper::find_index_by_name_index`
+	static int FindInIndex (List<EmittedRow> rows, List<uint> index, string name)
+	{
+		uint hash = TypeMapHelper.HashNameForCLR (name);
+		uint mask = (uint)index.Count - 1;
+		for (uint slot = TypeMapNameHashIndex.GetHomeSlot (hash, (uint)index.Count);; slot = (slot + 1) & mask) {
+			if (index [(int)slot] == 0) {
+				return -1;
+			}
+
+			int entryIndex = (int)index [(int)slot] - 1;
+			EmittedRow row = rows [entryIndex];
+			if (row.FromHash == hash && String.Equals (row.From, name, StringComparison.Ordinal)) {
+				return entryIndex;
+			}
+		}
+	}
+
+	static TypeMapDebugEntry Entry (string javaName, string managedName, uint tokenId, string assemblyFullName = MonoAndroidFullName)
+	{
+		string assemblyName = managedName.Substring (managedName.LastIndexOf (", ", StringComparison.Ordinal) + 2);
+		return new TypeMapDebugEntry {
+			JavaName = javaName,
+			ManagedName = managedName,
+			ManagedTypeTokenId = tokenId,
+			AssemblyName = assemblyName,
+			AssemblyFullName = assemblyFullName,
+		};
+	}
+
+	static object GetGlobal (LlvmIrModule module, string name)
+	{
+		LlvmIrGlobalVariable? variable = module.GlobalVariables?.FirstOrDefault (v => String.Equals (v.Name, name, StringComparison.Ordinal));
+		Assert.IsNotNull (variable, $"Global variable '{name}' not emitted");
+		Assert.IsNotNull (variable!.Value, $"Global variable '{name}' has no value");
+		return variable.Value!;
+	}
+
+	static Dictionary<uint, string> GetBlobStrings (LlvmIrModule module, string name)
+	{
+		var blob = (LlvmIrStringBlob)GetGlobal (module, name);
+		return blob.GetSegments ().ToDictionary (si => (uint)si.Offset, si => si.Value);
+	}
+
+	static List<EmittedRow> GetRows (LlvmIrModule module, string name, Dictionary<uint, string> fromNames)
+	{
+		var rows = new List<EmittedRow> ();
+		foreach (StructureInstance si in (IEnumerable)GetGlobal (module, name)) {
+			uint from = GetField<uint> (si, "from");
+			Assert.IsTrue (fromNames.ContainsKey (from), $"{name} row {rows.Count} points outside of the name blob");
+			rows.Add (new EmittedRow {
+				From = fromNames [from],
+				FromHash = GetField<uint> (si, "from_hash"),
+				To = GetField<uint> (si, "to"),
+			});
+		}
+
+		return rows;
+	}
+
+	// The generator's structures are private, read them the way the LLVM IR generator does
+	static T GetField<T> (StructureInstance instance, string fieldName)
+	{
+		object obj = instance.Obj!;
+		return (T)obj.GetType ().GetField (fieldName)!.GetValue (obj)!;
+	}
+}
@@ -62,9 +62,11 @@ namespace Xamarin.Android.Build.Tests
 			public string android_package_name = String.Empty;
 			public bool   have_assembly_store;
 			public bool   assembly_store_decompression_cache_enabled;
+			public uint   assembly_store_decompression_cache_max_size_mb;
+			public bool   assembly_store_on_demand_decompression;
 		}
 
-		const uint ApplicationConfigFieldCount_CoreCLR = 20;
+		const uint ApplicationConfigFieldCount_CoreCLR = 22;
 
 		// This must be identical to the ApplicationConfig structure in src/native/mono/xamarin-app-stub/xamarin-app.hh
 		public sealed class ApplicationConfig_MonoVM : IApplicationConfig
@@ -406,6 +408,16 @@ namespace Xamarin.Android.Build.Tests
 						AssertFieldType (envFile.Path, parser.SourceFilePath, ".byte", field [0], item.LineNumber);
 						ret.assembly_store_decompression_cache_enabled = ConvertFieldToBool ("assembly_store_decompression_cache_enabled", envFile.Path, parser.SourceFilePath, item.LineNumber, field [1]);
 						break;
+
+					case 20: // assembly_store_decompression_cache_max_size_mb: uint32_t / .word | .long
+						Assert.IsTrue (expectedUInt32Types.Contains (field [0]), $"Unexpected uint32_t field type in '{envFile.Path}:{item.LineNumber}': {field [0]}");
+						ret.assembly_store_decompression_cache_max_size_mb = ConvertFieldToUInt32 ("assembly_store_decompression_cache_max_size_mb", envFile.Path, parser.SourceFilePath, item.LineNumber, field [1]);
+						break;
+
+					case 21: // assembly_store_on_demand_decompression: bool / .byte
+						AssertFieldType (envFile.Path, parser.SourceFilePath, ".byte", field [0], item.LineNumber);
+						ret.assembly_store_on_demand_decompression = ConvertFieldToBool ("assembly_store_on_demand_decompression", envFile.Path, parser.SourceFilePath, item.LineNumber, field [1]);
+						break;
 				}
 				fieldCount++;
 			}
@@ -767,6 +779,8 @@ namespace Xamarin.Android.Build.Tests
 			Assert.AreEqual (firstAppConfig.android_package_name, secondAppConfig.android_package_name, $"Field 'android_package_name' has different value in environment file '{secondEnvFile}' than in environment file '{firstEnvFile}'");
 			Assert.AreEqual (firstAppConfig.have_assembly_store, secondAppConfig.have_assembly_store, $"Field 'have_assembly_store' has different value in environment file '{secondEnvFile}' than in environment file '{firstEnvFile}'");
 			Assert.AreEqual (firstAppConfig.assembly_store_decompression_cache_enabled, secondAppConfig.assembly_store_decompression_cache_enabled, $"Field 'assembly_store_decompression_cache_enabled' has different value in environment file '{secondEnvFile}' than in environment file '{firstEnvFile}'");
+			Assert.AreEqual (firstAppConfig.assembly_store_decompression_cache_max_size_mb, secondAppConfig.assembly_store_decompression_cache_max_size_mb, $"Field 'assembly_store_decompression_cache_max_size_mb' has different value in environment file '{secondEnvFile}' than in environment file '{firstEnvFile}'");
+			Assert.AreEqual (firstAppConfig.assembly_store_on_demand_decompression, secondAppConfig.assembly_store_on_demand_decompression, $"Field 'assembly_store_on_demand_decompression' has different value in environment file '{secondEnvFile}' than in environment file '{firstEnvFile}'");
 		}
 
 		static void AssertApplicationConfigIsIdentical (ApplicationConfig_MonoVM firstAppConfig, string firstEnvFile, ApplicationConfig_MonoVM secondAppConfig, string secondEnvFile)
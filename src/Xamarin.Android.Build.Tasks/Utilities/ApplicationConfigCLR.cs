@@ -51,4 +51,6 @@ sealed class ApplicationConfigCLR
 	public string android_package_name = String.Empty;
 	public bool   have_assembly_store;
 	public bool   assembly_store_decompression_cache_enabled;
+	public uint   assembly_store_decompression_cache_max_size_mb;
+	public bool   assembly_store_on_demand_decompression;
 }
@@ -200,6 +200,8 @@ class ApplicationConfigNativeAssemblyGeneratorCLR : LlvmIrComposer
 	public bool IgnoreSplitConfigs { get; set; }
 	public bool HaveAssemblyStore { get; set; }
 	public bool AssemblyStoreDecompressionCacheEnabled { get; set; }
+	public int AssemblyStoreDecompressionCacheMaxSizeMB { get; set; }
+	public bool AssemblyStoreOnDemandDecompression { get; set; }
 
 	public ApplicationConfigNativeAssemblyGeneratorCLR (IDictionary<string, string> environmentVariables, IDictionary<string, string> systemProperties,
 		IDictionary<string, string>? runtimeProperties, TaskLoggingHelper log)
@@ -288,6 +290,8 @@ class ApplicationConfigNativeAssemblyGeneratorCLR : LlvmIrComposer
 			android_package_name = AndroidPackageName,
 			have_assembly_store = HaveAssemblyStore,
 			assembly_store_decompression_cache_enabled = AssemblyStoreDecompressionCacheEnabled,
+			assembly_store_decompression_cache_max_size_mb = (uint)Math.Max (0, AssemblyStoreDecompressionCacheMaxSizeMB),
+			assembly_store_on_demand_decompression = AssemblyStoreOnDemandDecompression,
 		};
 		application_config = new StructureInstance<ApplicationConfigCLR> (applicationConfigStructureInfo, app_cfg);
 		module.AddGlobalVariable ("application_config", application_config);
@@ -19,6 +19,9 @@ class AssemblyStoreAssemblyInfo
 	public FileInfo? ConfigFile          { get; set; }
 	public bool Ignored                  { get; }
 
+	// 0 for the primary store, otherwise the number of the secondary store the assembly is placed in
+	public uint StoreNumber              { get; set; }
+
 	public AssemblyStoreAssemblyInfo (string sourceFilePath, ITaskItem assembly, bool assemblyIsIgnored = false)
 	{
 		Arch = MonoAndroidHelper.GetTargetArch (assembly);
@@ -23,9 +23,12 @@ class AssemblyStoreBuilder
 		storeGenerator = new (log, targetRuntime);
 	}
 
-	public void AddAssembly (string assemblySourcePath, ITaskItem assemblyItem, bool includeDebugSymbols)
+	/// <param name="storeNumber">0 to place the assembly in the primary store, otherwise the number of the secondary store to place it in. CoreCLR only.</param>
+	public void AddAssembly (string assemblySourcePath, ITaskItem assemblyItem, bool includeDebugSymbols, uint storeNumber = 0)
 	{
-		var storeAssemblyInfo = new AssemblyStoreAssemblyInfo (assemblySourcePath, assemblyItem);
+		var storeAssemblyInfo = new AssemblyStoreAssemblyInfo (assemblySourcePath, assemblyItem) {
+			StoreNumber = storeNumber,
+		};
 
 		// Try to add config if exists.  We use assemblyItem, because `sourcePath` might refer to a compressed
 		// assembly file in a different location.
@@ -43,7 +46,7 @@ class AssemblyStoreBuilder
 
 		storeGenerator.Add (storeAssemblyInfo);
 
-		ClrAddIgnoredNativeImageAssembly (assemblyItem);
+		ClrAddIgnoredNativeImageAssembly (assemblyItem, storeNumber);
 	}
 
 	// When CoreCLR tries to load an assembly (say `AssemblyName.dll`) it will always first try to load
@@ -51,16 +54,22 @@ class AssemblyStoreBuilder
 	// assemblies were once supported only on Windows and were never (nor will ever be) supported on
 	// Unix. In order to speed up load times, we add an empty entry for each `*.ni.dll` to the assembly
 	// store index.
-	void ClrAddIgnoredNativeImageAssembly (ITaskItem assemblyItem)
+	void ClrAddIgnoredNativeImageAssembly (ITaskItem assemblyItem, uint storeNumber)
 	{
 		if (targetRuntime != AndroidRuntime.CoreCLR) {
 			return;
 		}
 
 		string ignoredName = Path.GetFileName (Path.ChangeExtension (assemblyItem.ItemSpec, ".ni.dll"));
-		var storeAssemblyInfo = new AssemblyStoreAssemblyInfo (ignoredName, assemblyItem, assemblyIsIgnored: true);
+		var storeAssemblyInfo = new AssemblyStoreAssemblyInfo (ignoredName, assemblyItem, assemblyIsIgnored: true) {
+			StoreNumber = storeNumber,
+		};
 		storeGenerator.Add (storeAssemblyInfo);
 	}
 
-	public Dictionary<AndroidTargetArch, string> Generate (string outputDirectoryPath) => storeGenerator.Generate (outputDirectoryPath);
+	public void SetCompressionDictionary (AndroidTargetArch arch, string dictionaryPath) => storeGenerator.SetCompressionDictionary (arch, new FileInfo (dictionaryPath));
+
+	public void UseTrailingDebugData () => storeGenerator.UseTrailingDebugData ();
+
+	public Dictionary<AndroidTargetArch, List<string>> Generate (string outputDirectoryPath) => storeGenerator.Generate (outputDirectoryPath);
 }
@@ -1,4 +1,6 @@
 #nullable enable
+using System.Collections.Generic;
+
 namespace Xamarin.Android.Tasks;
 
 partial class AssemblyStoreGenerator
@@ -56,6 +58,8 @@ partial class AssemblyStoreGenerator
 	sealed class AssemblyStoreEntryDescriptor
 	{
 		public const uint NativeSize = 7 * sizeof (uint);
+		// CoreCLR descriptors also carry the location of the assembly name
+		public const uint NativeSizeWithName = NativeSize + 2 * sizeof (uint);
 
 		public uint mapping_index;
 
@@ -67,5 +71,26 @@ partial class AssemblyStoreGenerator
 
 		public uint config_data_offset;
 		public uint config_data_size;
+
+		public uint name_offset;
+		public uint name_length;
+	}
+
+	// A store holding assemblies which aren't needed during startup, described in the SECONDARY_STORES
+	// section of the primary store
+	sealed class SecondaryStore
+	{
+		public const uint NativeIndexEntrySize = 2 * sizeof (uint);
+
+		public readonly uint store_number;
+		public readonly ulong content_id;
+		public readonly List<AssemblyStoreIndexEntry> index;
+
+		public SecondaryStore (uint store_number, ulong content_id, List<AssemblyStoreIndexEntry> index)
+		{
+			this.store_number = store_number;
+			this.content_id = content_id;
+			this.index = index;
+		}
 	}
 }
@@ -13,12 +13,17 @@ namespace Xamarin.Android.Tasks;
 //
 // Assembly store format
 //
-// Each target ABI/architecture has a single assembly store file, composed of the following parts:
+// Each target ABI/architecture has a single primary assembly store file (assembly-store.so) and, with CoreCLR,
+// optionally a number of secondary store files (assembly-store-1.so, assembly-store-2.so etc), each composed of
+// the following parts:
 //
 // [HEADER]
 // [INDEX]
 // [ASSEMBLY_DESCRIPTORS]
 // [ASSEMBLY_NAMES]
+// [ZSTD_DICTIONARY]     CoreCLR only, present if HEADER.FORMAT_VERSION has the ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG bit set
+// [DEBUG_DATA_REGION]   CoreCLR only, present if HEADER.FORMAT_VERSION has the ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG bit set
+// [SECONDARY_STORES]    CoreCLR only, present if HEADER.FORMAT_VERSION has the ASSEMBLY_STORE_SECONDARY_STORES_FLAG bit set
 // [ASSEMBLY DATA]
 //
 // Formats of the sections above are as follows:
@@ -31,11 +36,19 @@ namespace Xamarin.Android.Tasks;
 //  [INDEX_SIZE]         uint; index size in bytes
 //  [CONTENT_ID]         ulong: deterministic hash of everything after the header
 //
-// INDEX (variable size, HEADER.ENTRY_COUNT*2 entries, for assembly names with and without the extension)
+// INDEX (variable size, HEADER.INDEX_ENTRY_COUNT entries, for assembly names with and without the extension)
 //  [NAME_HASH]          uint CRC32 for CoreCLR; uint/ulong xxhash for MonoVM depending on target bitness
 //  [DESCRIPTOR_INDEX]   uint; index into in-store assembly descriptor array
 //  [IGNORE]             byte; if set to anything other than 0, the assembly is to be ignored when loading
 //
+// In CoreCLR v7 stores the index entries are placed in the slots of a minimal perfect hash table (see
+// MinimalPerfectHash) and are followed by the table's displacements, all included in
+// HEADER.INDEX_SIZE:
+//  [BUCKET_COUNT]       uint; number of displacement entries
+//  [DISPLACEMENTS]      uint[BUCKET_COUNT]
+// In CoreCLR v6 (and MonoVM v4) stores the entries are sorted by NAME_HASH instead. CoreCLR stores fall
+// back to v6 if the perfect hash table cannot be built (e.g. two different names share a CRC32 hash).
+//
 // ASSEMBLY_DESCRIPTORS (variable size, HEADER.ENTRY_COUNT entries), each entry formatted as follows:
 //  [MAPPING_INDEX]      uint; index into a runtime array where assembly data pointers are stored
 //  [DATA_OFFSET]        uint; offset from the beginning of the store to the start of assembly data
@@ -44,10 +57,32 @@ namespace Xamarin.Android.Tasks;
 //  [DEBUG_DATA_SIZE]    uint; size of the stored assembly PDB data, 0 if absent
 //  [CONFIG_DATA_OFFSET] uint; offset from the beginning of the store to the start of assembly .config contents, 0 if absent
 //  [CONFIG_DATA_SIZE]   uint; size of the stored assembly .config contents, 0 if absent
+//  [NAME_OFFSET]        uint; CoreCLR only, offset from the beginning of the store to the NAME bytes of the assembly's ASSEMBLY_NAMES entry
+//  [NAME_LENGTH]        uint; CoreCLR only, length of the assembly name
 //
-// ASSEMBLY_NAMES (variable size, HEADER.ENTRY_COUNT entries), each entry formatted as follows:
+// ASSEMBLY_NAMES (variable size, HEADER.ENTRY_COUNT entries, in descriptor order), each entry formatted as follows:
 //  [NAME_LENGTH]        uint: length of assembly name
 //  [NAME]               byte: UTF-8 bytes of assembly name, without the NUL terminator
+// CoreCLR doesn't read the section sequentially, it uses the descriptors to find the names.
+//
+// ZSTD_DICTIONARY (variable size), the dictionary some of the assemblies are compressed with:
+//  [DICTIONARY_SIZE]    uint: size of the dictionary
+//  [DICTIONARY]         byte: the dictionary, in the Zstandard dictionary format
+//
+// DEBUG_DATA_REGION (fixed size), location of the trailing part of ASSEMBLY DATA which contains the debug
+// and config data of all the assemblies, all the assembly images precede it:
+//  [REGION_OFFSET]      uint: offset from the beginning of the store to the start of the region
+//  [REGION_SIZE]        uint: size of the region
+//
+// SECONDARY_STORES (variable size), present in the primary store only:
+//  [STORE_COUNT]        uint: number of secondary stores
+//  [ENTRY_COUNT]        uint: number of entries in SECONDARY_INDEX
+//  [CONTENT_IDS]        ulong[STORE_COUNT]: CONTENT_ID of each of the secondary stores
+//  [SECONDARY_INDEX]    ENTRY_COUNT entries, sorted by NAME_HASH, each formatted as follows:
+//    [NAME_HASH]        uint; CRC32 of an assembly name found in the INDEX of a secondary store
+//    [STORE_NUMBER]     uint; 1-based number of that secondary store
+// Secondary stores never contain a dictionary, the assemblies they hold are compressed with the dictionary of the
+// primary store. Descriptor MAPPING_INDEX values are unique across all the stores of an architecture.
 //
 partial class AssemblyStoreGenerator
 {
@@ -57,17 +92,25 @@ partial class AssemblyStoreGenerator
 	// Bit 31 is set for 64-bit platforms, cleared for the 32-bit ones
 	const uint ASSEMBLY_STORE_FORMAT_VERSION_MONOVM_64BIT = 0x80000004; // Must match the ASSEMBLY_STORE_FORMAT_VERSION native constant
 	const uint ASSEMBLY_STORE_FORMAT_VERSION_MONOVM_32BIT = 0x00000004;
-	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT = 0x80000004; // Must match the ASSEMBLY_STORE_FORMAT_VERSION native constant
-	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT = 0x00000004;
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT = 0x80000007; // Must match the ASSEMBLY_STORE_FORMAT_VERSION native constant
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT = 0x00000007;
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_SORTED_INDEX_64BIT = 0x80000006; // Must match the ASSEMBLY_STORE_FORMAT_VERSION_SORTED_INDEX native constant
+	const uint ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_SORTED_INDEX_32BIT = 0x00000006;
 
 	const uint ASSEMBLY_STORE_ABI_AARCH64 = 0x00010000;
 	const uint ASSEMBLY_STORE_ABI_ARM = 0x00020000;
 	const uint ASSEMBLY_STORE_ABI_X64 = 0x00030000;
 	const uint ASSEMBLY_STORE_ABI_X86 = 0x00040000;
 
+	const uint ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG = 0x01000000; // Must match the ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG native constant
+	const uint ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG = 0x02000000; // Must match the ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG native constant
+	const uint ASSEMBLY_STORE_SECONDARY_STORES_FLAG = 0x04000000; // Must match the ASSEMBLY_STORE_SECONDARY_STORES_FLAG native constant
+
 	readonly TaskLoggingHelper log;
 	readonly Dictionary<AndroidTargetArch, List<AssemblyStoreAssemblyInfo>> assemblies;
 	readonly AndroidRuntime targetRuntime;
+	readonly Dictionary<AndroidTargetArch, FileInfo> compressionDictionaries = new ();
+	bool trailingDebugData;
 
 	public AssemblyStoreGenerator (TaskLoggingHelper log, AndroidRuntime targetRuntime)
 	{
@@ -78,6 +121,10 @@ partial class AssemblyStoreGenerator
 
 	public void Add (AssemblyStoreAssemblyInfo asmInfo)
 	{
+		if (asmInfo.StoreNumber != 0 && targetRuntime != AndroidRuntime.CoreCLR) {
+			throw new NotSupportedException ($"Secondary assembly stores are not supported by the {targetRuntime} runtime");
+		}
+
 		if (!assemblies.TryGetValue (asmInfo.Arch, out List<AssemblyStoreAssemblyInfo> infos)) {
 			infos = new List<AssemblyStoreAssemblyInfo> ();
 			assemblies.Add (asmInfo.Arch, infos);
@@ -86,19 +133,96 @@ partial class AssemblyStoreGenerator
 		infos.Add (asmInfo);
 	}
 
-	public Dictionary<AndroidTargetArch, string> Generate (string baseOutputDirectory)
+	/// <summary>
+	/// Stores the Zstandard dictionary the assemblies of the given architecture were compressed with
+	/// (see <c>AssemblyCompressor</c>) in the architecture's store.
+	/// </summary>
+	public void SetCompressionDictionary (AndroidTargetArch arch, FileInfo dictionary)
+	{
+		if (targetRuntime != AndroidRuntime.CoreCLR) {
+			throw new NotSupportedException ($"Assembly compression dictionaries are not supported by the {targetRuntime} runtime");
+		}
+
+		compressionDictionaries[arch] = dictionary;
+	}
+
+	/// <summary>
+	/// Places the debug (PDB) and config data of all the assemblies in a single region following all the
+	/// assembly images, so that it doesn't come between the images the runtime reads during startup.
+	/// </summary>
+	public void UseTrailingDebugData ()
+	{
+		if (targetRuntime != AndroidRuntime.CoreCLR) {
+			throw new NotSupportedException ($"Trailing assembly debug data is not supported by the {targetRuntime} runtime");
+		}
+
+		trailingDebugData = true;
+	}
+
+	/// <summary>
+	/// Returns paths of the generated stores for each architecture, the primary store first.
+	/// </summary>
+	public Dictionary<AndroidTargetArch, List<string>> Generate (string baseOutputDirectory)
 	{
-		var ret = new Dictionary<AndroidTargetArch, string> ();
+		var ret = new Dictionary<AndroidTargetArch, List<string>> ();
 
 		foreach (var kvp in assemblies) {
-			string storePath = Generate (baseOutputDirectory, kvp.Key, kvp.Value);
-			ret.Add (kvp.Key, storePath);
+			ret.Add (kvp.Key, GenerateStores (baseOutputDirectory, kvp.Key, kvp.Value));
+		}
+
+		return ret;
+	}
+
+	List<string> GenerateStores (string baseOutputDirectory, AndroidTargetArch arch, List<AssemblyStoreAssemblyInfo> infos)
+	{
+		var primaryInfos = new List<AssemblyStoreAssemblyInfo> ();
+		var secondaryInfos = new SortedDictionary<uint, List<AssemblyStoreAssemblyInfo>> ();
+		foreach (AssemblyStoreAssemblyInfo info in infos) {
+			if (info.StoreNumber == 0) {
+				primaryInfos.Add (info);
+				continue;
+			}
+
+			if (!secondaryInfos.TryGetValue (info.StoreNumber, out List<AssemblyStoreAssemblyInfo>? storeInfos)) {
+				storeInfos = new List<AssemblyStoreAssemblyInfo> ();
+				secondaryInfos.Add (info.StoreNumber, storeInfos);
+			}
+			storeInfos.Add (info);
 		}
 
+		// The secondary stores are generated first, since the primary store records their content IDs. They're
+		// numbered from 1 in the order of their store numbers, which needn't be contiguous. The runtime keeps the
+		// data of the assemblies from all the stores in a single array, so the mapping indices of the assemblies
+		// in the secondary stores follow those of the primary store.
+		var ret = new List<string> ();
+		var secondaryStores = new List<SecondaryStore> ();
+		uint firstMappingIndex = CountMappedAssemblies (primaryInfos);
+		foreach (List<AssemblyStoreAssemblyInfo> storeInfos in secondaryInfos.Values) {
+			var storeNumber = (uint)secondaryStores.Count + 1;
+			(string storePath, ulong contentId, List<AssemblyStoreIndexEntry> index) = Generate (baseOutputDirectory, arch, storeInfos, storeNumber, firstMappingIndex, secondaryStores: []);
+			secondaryStores.Add (new SecondaryStore (storeNumber, contentId, index));
+			firstMappingIndex += CountMappedAssemblies (storeInfos);
+			ret.Add (storePath);
+		}
+
+		(string primaryStorePath, _, _) = Generate (baseOutputDirectory, arch, primaryInfos, storeNumber: 0, firstMappingIndex: 0, secondaryStores);
+		ret.Insert (0, primaryStorePath);
+
 		return ret;
+
+		static uint CountMappedAssemblies (List<AssemblyStoreAssemblyInfo> storeInfos)
+		{
+			uint count = 0;
+			foreach (AssemblyStoreAssemblyInfo info in storeInfos) {
+				if (!info.Ignored) {
+					count++;
+				}
+			}
+			return count;
+		}
 	}
 
-	string Generate (string baseOutputDirectory, AndroidTargetArch arch, List<AssemblyStoreAssemblyInfo> infos)
+	(string storePath, ulong contentId, List<AssemblyStoreIndexEntry> index) Generate (string baseOutputDirectory, AndroidTargetArch arch, List<AssemblyStoreAssemblyInfo> infos, uint storeNumber, uint firstMappingIndex, List<SecondaryStore> secondaryStores)
 	{
 		(bool is64Bit, uint abiFlag) = arch switch {
 			AndroidTargetArch.Arm    => (false, ASSEMBLY_STORE_ABI_ARM),
@@ -113,12 +237,14 @@ partial class AssemblyStoreGenerator
 		Directory.CreateDirectory (outputDir);
 
 		uint infoCount = (uint)infos.Count;
-		string storePath = Path.Combine (outputDir, "assembly-store.so");
+		string storePath = Path.Combine (outputDir, storeNumber == 0 ? "assembly-store.so" : $"assembly-store-{storeNumber}.so");
 		var index = new List<AssemblyStoreIndexEntry> ();
 		var descriptors = new List<AssemblyStoreEntryDescriptor> ();
 		bool useCrc32NameHashes = targetRuntime == AndroidRuntime.CoreCLR;
 		bool use64BitNameHashes = is64Bit && !useCrc32NameHashes;
 		uint indexEntrySize = use64BitNameHashes ? AssemblyStoreIndexEntry.NativeSize64 : AssemblyStoreIndexEntry.NativeSize32;
+		bool useNamedDescriptors = targetRuntime == AndroidRuntime.CoreCLR;
+		uint descriptorSize = useNamedDescriptors ? AssemblyStoreEntryDescriptor.NativeSizeWithName : AssemblyStoreEntryDescriptor.NativeSize;
 		ulong namesSize = 0;
 
 		foreach (AssemblyStoreAssemblyInfo info in infos) {
@@ -126,7 +252,52 @@ partial class AssemblyStoreGenerator
 			namesSize += sizeof (uint);
 		}
 
-		ulong assemblyDataStart = (infoCount * indexEntrySize * 2) + (AssemblyStoreEntryDescriptor.NativeSize * infoCount) + AssemblyStoreHeader.NativeSize + namesSize;
+		// The index doesn't depend on where the assembly data ends up, so it's built up front in order
+		// to know its size before the data is written.
+		for (int i = 0; i < infos.Count; i++) {
+			AssemblyStoreAssemblyInfo info = infos[i];
+			ulong name_with_ext_hash = HashAssemblyName (info.AssemblyNameBytes, useCrc32NameHashes, use64BitNameHashes);
+			ulong name_no_ext_hash = HashAssemblyName (info.AssemblyNameNoExtBytes, useCrc32NameHashes, use64BitNameHashes);
+			index.Add (new AssemblyStoreIndexEntry (info.AssemblyName, name_with_ext_hash, (uint)i, info.Ignored));
+			index.Add (new AssemblyStoreIndexEntry (info.AssemblyNameNoExt, name_no_ext_hash, (uint)i, info.Ignored));
+		}
+
+		uint[]? perfectHashDisplacements = null;
+		if (useCrc32NameHashes) {
+			perfectHashDisplacements = BuildPerfectHashIndex (index);
+			if (perfectHashDisplacements == null) {
+				log.LogDebugMessage ($"Unable to build a perfect hash index for assembly store '{storePath}', using the sorted index");
+			}
+		}
+
+		ulong indexSize = (ulong)index.Count * indexEntrySize;
+		if (perfectHashDisplacements != null) {
+			indexSize += sizeof (uint) + ((ulong)perfectHashDisplacements.Length * sizeof (uint));
+		}
+
+		// The secondary stores share the dictionary of the primary store
+		FileInfo? dictionary = null;
+		if (storeNumber == 0) {
+			compressionDictionaries.TryGetValue (arch, out dictionary);
+		}
+		ulong dictionarySectionSize = dictionary == null ? 0 : sizeof (uint) + (ulong)dictionary.Length;
+		uint storeFlags = dictionary == null ? 0 : ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG;
+		ulong debugDataRegionSectionSize = 0;
+		if (trailingDebugData) {
+			debugDataRegionSectionSize = 2 * sizeof (uint);
+			storeFlags |= ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG;
+		}
+
+		List<(uint nameHash, uint storeNumber)>? secondaryIndex = null;
+		ulong secondaryStoresSectionSize = 0;
+		if (secondaryStores.Count > 0) {
+			secondaryIndex = BuildSecondaryIndex (secondaryStores);
+			secondaryStoresSectionSize = 2 * sizeof (uint) + ((ulong)secondaryStores.Count * sizeof (ulong)) + ((ulong)secondaryIndex.Count * SecondaryStore.NativeIndexEntrySize);
+			storeFlags |= ASSEMBLY_STORE_SECONDARY_STORES_FLAG;
+		}
+
+		ulong namesStart = AssemblyStoreHeader.NativeSize + indexSize + (descriptorSize * infoCount);
+		ulong assemblyDataStart = namesStart + namesSize + dictionarySectionSize + debugDataRegionSectionSize + secondaryStoresSectionSize;
 		// We'll start writing to the stream after we seek to the position just after the header, index, descriptors and name data.
 		ulong curPos = assemblyDataStart;
 
@@ -134,52 +305,85 @@ partial class AssemblyStoreGenerator
 		using var fs = File.Open (storePath, FileMode.Create, FileAccess.ReadWrite, FileShare.Read);
 		fs.Seek ((long)curPos, SeekOrigin.Begin);
 
-		uint mappingIndex = 0;
+		uint mappingIndex = firstMappingIndex;
+		ulong namePos = namesStart;
 		foreach (AssemblyStoreAssemblyInfo info in infos) {
-			(AssemblyStoreEntryDescriptor desc, curPos) = MakeDescriptor (info, curPos);
+			(AssemblyStoreEntryDescriptor desc, curPos) = MakeDescriptor (info, curPos, includeDebugAndConfigData: !trailingDebugData);
+			desc.name_offset = (uint)(namePos + sizeof (uint));
+			desc.name_length = (uint)info.AssemblyNameBytes.Length;
+			namePos += sizeof (uint) + desc.name_length;
 			if (info.Ignored) {
 				desc.mapping_index = 0;
 			} else {
 				desc.mapping_index = mappingIndex++;
 			}
-			uint entryIndex = (uint)descriptors.Count;
 			descriptors.Add (desc);
 
 			if (!info.Ignored && (uint)fs.Position != desc.data_offset) {
 				throw new InvalidOperationException ($"Internal error: corrupted store '{storePath}' stream");
 			}
 
-			ulong name_with_ext_hash = HashAssemblyName (info.AssemblyNameBytes, useCrc32NameHashes, use64BitNameHashes);
-			ulong name_no_ext_hash = HashAssemblyName (info.AssemblyNameNoExtBytes, useCrc32NameHashes, use64BitNameHashes);
-			index.Add (new AssemblyStoreIndexEntry (info.AssemblyName, name_with_ext_hash, entryIndex, info.Ignored));
-			index.Add (new AssemblyStoreIndexEntry (info.AssemblyNameNoExt, name_no_ext_hash, entryIndex, info.Ignored));
-
 			if (info.Ignored) {
 				continue;
 			}
 
 			CopyData (info.SourceFile, fs, storePath);
-			CopyData (info.SymbolsFile, fs, storePath);
-			CopyData (info.ConfigFile, fs, storePath);
+			if (!trailingDebugData) {
+				CopyData (info.SymbolsFile, fs, storePath);
+				CopyData (info.ConfigFile, fs, storePath);
+			}
+		}
+
+		ulong debugDataRegionStart = curPos;
+		if (trailingDebugData) {
+			for (int i = 0; i < infos.Count; i++) {
+				AssemblyStoreAssemblyInfo info = infos[i];
+				if (info.Ignored) {
+					continue;
+				}
+
+				curPos = PlaceTrailingDebugData (info, descriptors[i], curPos);
+				CopyData (info.SymbolsFile, fs, storePath);
+				CopyData (info.ConfigFile, fs, storePath);
+			}
+
+			if ((ulong)fs.Position != curPos) {
+				throw new InvalidOperationException ($"Internal error: corrupted store '{storePath}' stream");
+			}
 		}
 		fs.Flush ();
 		fs.Seek (0, SeekOrigin.Begin);
 
-		uint storeVersion = GetAssemblyStoreFormatVersion (is64Bit);
-		var header = new AssemblyStoreHeader (storeVersion | abiFlag, infoCount, (uint)index.Count, (uint)(index.Count * indexEntrySize), content_id: 0);
+		uint storeVersion = GetAssemblyStoreFormatVersion (is64Bit, usesPerfectHashIndex: perfectHashDisplacements != null);
+		var header = new AssemblyStoreHeader (storeVersion | abiFlag | storeFlags, infoCount, (uint)index.Count, (uint)indexSize, content_id: 0);
 		using var writer = new BinaryWriter (fs);
 		WriteHeader (writer, header);
 
 		using var manifestFs = File.Open ($"{storePath}.manifest", FileMode.Create, FileAccess.Write, FileShare.Read);
 		using var mw = new StreamWriter (manifestFs, new System.Text.UTF8Encoding (false));
-		WriteIndex (writer, mw, index, descriptors, use64BitNameHashes);
+		WriteIndex (writer, mw, index, descriptors, use64BitNameHashes, sortByHash: perfectHashDisplacements == null);
 		mw.Flush ();
 
+		if (perfectHashDisplacements != null) {
+			WritePerfectHashDisplacements (writer, perfectHashDisplacements);
+		}
+
 		log.LogDebugMessage ($"Number of descriptors: {descriptors.Count}; index entries: {index.Count}");
-		log.LogDebugMessage ($"Header size: {AssemblyStoreHeader.NativeSize}; index entry size: {indexEntrySize}; descriptor size: {AssemblyStoreEntryDescriptor.NativeSize}");
+		log.LogDebugMessage ($"Header size: {AssemblyStoreHeader.NativeSize}; index entry size: {indexEntrySize}; descriptor size: {descriptorSize}");
 
-		WriteDescriptors (writer, descriptors);
+		WriteDescriptors (writer, descriptors, useNamedDescriptors);
 		WriteNames (writer, infos);
+		if (dictionary != null) {
+			WriteDictionary (writer, dictionary, storePath);
+		}
+		if (trailingDebugData) {
+			writer.Write ((uint)debugDataRegionStart);
+			writer.Write ((uint)(curPos - debugDataRegionStart));
+			log.LogDebugMessage ($"Debug and config data region: offset {debugDataRegionStart}; size {curPos - debugDataRegionStart}");
+		}
+		if (secondaryIndex != null) {
+			WriteSecondaryStores (writer, secondaryStores, secondaryIndex);
+		}
 		writer.Flush ();
 
 		if (fs.Position != (long)assemblyDataStart) {
@@ -188,13 +392,42 @@ partial class AssemblyStoreGenerator
 		}
 
 		ulong contentId = ComputeContentId (fs);
-		header = new AssemblyStoreHeader (storeVersion | abiFlag, infoCount, (uint)index.Count, (uint)(index.Count * indexEntrySize), contentId);
+		header = new AssemblyStoreHeader (storeVersion | abiFlag | storeFlags, infoCount, (uint)index.Count, (uint)indexSize, contentId);
 		fs.Seek (0, SeekOrigin.Begin);
 		WriteHeader (writer, header);
 		writer.Flush ();
 		log.LogDebugMessage ($"Assembly store content ID: 0x{contentId:x16}");
 
-		return storePath;
+		return (storePath, contentId, index);
+	}
+
+	static List<(uint nameHash, uint storeNumber)> BuildSecondaryIndex (List<SecondaryStore> secondaryStores)
+	{
+		var entries = new HashSet<(uint nameHash, uint storeNumber)> ();
+		foreach (SecondaryStore store in secondaryStores) {
+			foreach (AssemblyStoreIndexEntry entry in store.index) {
+				entries.Add (((uint)entry.name_hash, store.store_number));
+			}
+		}
+
+		var ret = new List<(uint nameHash, uint storeNumber)> (entries);
+		ret.Sort ();
+		return ret;
+	}
+
+	void WriteSecondaryStores (BinaryWriter writer, List<SecondaryStore> secondaryStores, List<(uint nameHash, uint storeNumber)> secondaryIndex)
+	{
+		writer.Write ((uint)secondaryStores.Count);
+		writer.Write ((uint)secondaryIndex.Count);
+		foreach (SecondaryStore store in secondaryStores) {
+			writer.Write (store.content_id);
+		}
+
+		foreach ((uint nameHash, uint storeNumber) in secondaryIndex) {
+			writer.Write (nameHash);
+			writer.Write (storeNumber);
+		}
+		log.LogDebugMessage ($"Secondary stores: {secondaryStores.Count}; secondary index entries: {secondaryIndex.Count}");
 	}
 
 	static ulong HashAssemblyName (byte[] assemblyNameBytes, bool useCrc32NameHashes, bool use64BitNameHashes)
@@ -206,9 +439,12 @@ partial class AssemblyStoreGenerator
 		return MonoAndroidHelper.GetXxHash (assemblyNameBytes, use64BitNameHashes);
 	}
 
-	uint GetAssemblyStoreFormatVersion (bool is64Bit)
+	uint GetAssemblyStoreFormatVersion (bool is64Bit, bool usesPerfectHashIndex)
 	{
 		if (targetRuntime == AndroidRuntime.CoreCLR) {
+			if (!usesPerfectHashIndex) {
+				return is64Bit ? ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_SORTED_INDEX_64BIT : ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_SORTED_INDEX_32BIT;
+			}
 			return is64Bit ? ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_64BIT : ASSEMBLY_STORE_FORMAT_VERSION_CORECLR_32BIT;
 		}
 
@@ -240,12 +476,19 @@ partial class AssemblyStoreGenerator
 		fs.CopyTo (dest);
 	}
 
-	static (AssemblyStoreEntryDescriptor desc, ulong newPos) MakeDescriptor (AssemblyStoreAssemblyInfo info, ulong curPos)
+	static (AssemblyStoreEntryDescriptor desc, ulong newPos) MakeDescriptor (AssemblyStoreAssemblyInfo info, ulong curPos, bool includeDebugAndConfigData)
 	{
 		var ret = new AssemblyStoreEntryDescriptor {
 			data_offset = info.Ignored ? 0 : (uint)curPos,
 			data_size = info.Ignored ? 0 : GetDataLength (info.SourceFile),
 		};
+		if (!includeDebugAndConfigData) {
+			if (!info.Ignored) {
+				curPos = CheckStorePosition (curPos + ret.data_size);
+			}
+			return (ret, curPos);
+		}
+
 		if (info.SymbolsFile != null) {
 			ret.debug_data_offset = ret.data_offset + ret.data_size;
 			ret.debug_data_size = GetDataLength (info.SymbolsFile);
@@ -257,25 +500,56 @@ partial class AssemblyStoreGenerator
 		}
 
 		if (!info.Ignored) {
-			curPos += ret.data_size + ret.debug_data_size + ret.config_data_size;
-			if (curPos > UInt32.MaxValue) {
-				throw new NotSupportedException ("Assembly store size exceeds the maximum supported value");
-			}
+			curPos = CheckStorePosition (curPos + ret.data_size + ret.debug_data_size + ret.config_data_size);
 		}
 
 		return (ret, curPos);
+	}
 
-		uint GetDataLength (FileInfo? info) {
-			if (info == null) {
-				return 0;
-			}
+	static ulong PlaceTrailingDebugData (AssemblyStoreAssemblyInfo info, AssemblyStoreEntryDescriptor desc, ulong curPos)
+	{
+		if (info.SymbolsFile != null) {
+			desc.debug_data_offset = (uint)curPos;
+			desc.debug_data_size = GetDataLength (info.SymbolsFile);
+			curPos = CheckStorePosition (curPos + desc.debug_data_size);
+		}
 
-			if (info.Length > UInt32.MaxValue) {
-				throw new NotSupportedException ($"File '{info.Name}' exceeds the maximum supported size");
-			}
+		if (info.ConfigFile != null) {
+			desc.config_data_offset = (uint)curPos;
+			desc.config_data_size = GetDataLength (info.ConfigFile);
+			curPos = CheckStorePosition (curPos + desc.config_data_size);
+		}
+
+		return curPos;
+	}
+
+	static ulong CheckStorePosition (ulong curPos)
+	{
+		if (curPos > UInt32.MaxValue) {
+			throw new NotSupportedException ("Assembly store size exceeds the maximum supported value");
+		}
+
+		return curPos;
+	}
+
+	static uint GetDataLength (FileInfo? info)
+	{
+		if (info == null) {
+			return 0;
+		}
 
-			return (uint)info.Length;
+		if (info.Length > UInt32.MaxValue) {
+			throw new NotSupportedException ($"File '{info.Name}' exceeds the maximum supported size");
 		}
+
+		return (uint)info.Length;
+	}
+
+	void WriteDictionary (BinaryWriter writer, FileInfo dictionary, string storePath)
+	{
+		writer.Write ((uint)dictionary.Length);
+		writer.Flush ();
+		CopyData (dictionary, writer.BaseStream, storePath);
 	}
 
 	void WriteHeader (BinaryWriter writer, AssemblyStoreHeader header)
@@ -302,9 +576,52 @@ partial class AssemblyStoreGenerator
 	}
 #endif
 
-	void WriteIndex (BinaryWriter writer, StreamWriter manifestWriter, List<AssemblyStoreIndexEntry> index, List<AssemblyStoreEntryDescriptor> descriptors, bool use64BitNameHashes)
+	/// <summary>
+	/// Reorders <paramref name="index"/> so that each entry is in its perfect hash table slot and returns the
+	/// table's displacements, or returns <c>null</c> (leaving the index alone) if the table can't be built.
+	/// </summary>
+	static uint[]? BuildPerfectHashIndex (List<AssemblyStoreIndexEntry> index)
+	{
+		// Names without an extension hash to the same value in both of their index entries, there's no
+		// point in keeping both of them.
+		var uniqueEntries = new List<AssemblyStoreIndexEntry> (index.Count);
+		var seen = new HashSet<(ulong, uint)> ();
+		foreach (AssemblyStoreIndexEntry entry in index) {
+			if (seen.Add ((entry.name_hash, entry.descriptor_index))) {
+				uniqueEntries.Add (entry);
+			}
+		}
+
+		var hashes = new uint [uniqueEntries.Count];
+		for (int i = 0; i < hashes.Length; i++) {
+			hashes[i] = (uint)uniqueEntries[i].name_hash;
+		}
+
+		if (!MinimalPerfectHash.TryBuild (hashes, out uint[] displacements, out int[] slots)) {
+			return null;
+		}
+
+		index.Clear ();
+		foreach (int entryIndex in slots) {
+			index.Add (uniqueEntries[entryIndex]);
+		}
+
+		return displacements;
+	}
+
+	void WritePerfectHashDisplacements (BinaryWriter writer, uint[] displacements)
+	{
+		writer.Write ((uint)displacements.Length);
+		foreach (uint displacement in displacements) {
+			writer.Write (displacement);
+		}
+	}
+
+	void WriteIndex (BinaryWriter writer, StreamWriter manifestWriter, List<AssemblyStoreIndexEntry> index, List<AssemblyStoreEntryDescriptor> descriptors, bool use64BitNameHashes, bool sortByHash)
 	{
-		index.Sort ((AssemblyStoreIndexEntry a, AssemblyStoreIndexEntry b) => a.name_hash.CompareTo (b.name_hash));
+		if (sortByHash) {
+			index.Sort ((AssemblyStoreIndexEntry a, AssemblyStoreIndexEntry b) => a.name_hash.CompareTo (b.name_hash));
+		}
 
 		foreach (AssemblyStoreIndexEntry entry in index) {
 			if (use64BitNameHashes) {
@@ -369,6 +686,12 @@ partial class AssemblyStoreGenerator
 			return 0;
 		}
 
+		// The v7 index also contains the perfect hash table. v6 and newer stores are CoreCLR-only and always
+		// use 32-bit hashes.
+		if ((header.version & 0xFFFF) >= 5) {
+			return AssemblyStoreIndexEntry.NativeSize32;
+		}
+
 		if (header.index_size % header.index_entry_count != 0) {
 			throw new InvalidOperationException ($"Assembly store index is corrupted: index size {header.index_size} is not evenly divisible by entry count {header.index_entry_count}.");
 		}
@@ -376,7 +699,9 @@ partial class AssemblyStoreGenerator
 		return header.index_size / header.index_entry_count;
 	}
 
-	void WriteDescriptors (BinaryWriter writer, List<AssemblyStoreEntryDescriptor> descriptors)
+	static bool UsesNamedDescriptors (AssemblyStoreHeader header) => (header.version & 0xFFFF) >= 6;
+
+	void WriteDescriptors (BinaryWriter writer, List<AssemblyStoreEntryDescriptor> descriptors, bool useNamedDescriptors)
 	{
 		foreach (AssemblyStoreEntryDescriptor desc in descriptors) {
 			writer.Write (desc.mapping_index);
@@ -386,6 +711,10 @@ partial class AssemblyStoreGenerator
 			writer.Write (desc.debug_data_size);
 			writer.Write (desc.config_data_offset);
 			writer.Write (desc.config_data_size);
+			if (useNamedDescriptors) {
+				writer.Write (desc.name_offset);
+				writer.Write (desc.name_length);
+			}
 		}
 	}
 
@@ -398,6 +727,7 @@ partial class AssemblyStoreGenerator
 		var descriptors = new List<AssemblyStoreEntryDescriptor> ();
 		reader.BaseStream.Seek (AssemblyStoreHeader.NativeSize + header.index_size, SeekOrigin.Begin);
 
+		bool hasNames = UsesNamedDescriptors (header);
 		for (int i = 0; i < (int)header.entry_count; i++) {
 			uint mapping_index      = reader.ReadUInt32 ();
 			uint data_offset        = reader.ReadUInt32 ();
@@ -406,6 +736,8 @@ partial class AssemblyStoreGenerator
 			uint debug_data_size    = reader.ReadUInt32 ();
 			uint config_data_offset = reader.ReadUInt32 ();
 			uint config_data_size   = reader.ReadUInt32 ();
+			uint name_offset        = hasNames ? reader.ReadUInt32 () : 0;
+			uint name_length        = hasNames ? reader.ReadUInt32 () : 0;
 
 			var desc = new AssemblyStoreEntryDescriptor {
 				mapping_index      = mapping_index,
@@ -415,6 +747,8 @@ partial class AssemblyStoreGenerator
 				debug_data_size    = debug_data_size,
 				config_data_offset = config_data_offset,
 				config_data_size   = config_data_size,
+				name_offset        = name_offset,
+				name_length        = name_length,
 			};
 			descriptors.Add (desc);
 		}
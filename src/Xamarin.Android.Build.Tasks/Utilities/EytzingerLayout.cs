@@ -0,0 +1,38 @@
+#nullable enable
+using System;
+using System.Collections.Generic;
+
+namespace Xamarin.Android.Tasks;
+
+//
+// Reorders a sorted table into the Eytzinger (BFS) order of the implicit binary search tree over it: the element at
+// 1-based position `k` has its children at positions `2k` and `2k + 1`. The runtime searches such tables with
+// `Search::eytzinger_lower_bound` (src/native/common/include/runtime-base/search.hh), which touches memory in a much
+// more predictable way than a binary search of the sorted table does.
+//
+static class EytzingerLayout
+{
+	// Smaller tables fit in a few cache lines, it makes no difference how they are searched
+	public const int MinimumEntryCount = 64;
+
+	public static void Apply<T> (IList<T> sorted)
+	{
+		var source = new T [sorted.Count];
+		sorted.CopyTo (source, 0);
+
+		int next = 0;
+		Place (1);
+
+		void Place (int k)
+		{
+			if (k > source.Length) {
+				return;
+			}
+
+			// In-order traversal of the tree visits the positions in the order of the sorted elements
+			Place (2 * k);
+			sorted[k - 1] = source[next++];
+			Place (2 * k + 1);
+		}
+	}
+}
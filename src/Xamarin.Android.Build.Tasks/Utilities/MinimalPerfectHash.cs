@@ -0,0 +1,170 @@
+#nullable enable
+using System;
+using System.Collections.Generic;
+
+namespace Xamarin.Android.Tasks;
+
+//
+// Minimal perfect hash over 32-bit name hashes (the assembly store index and the CoreCLR release
+// Java-to-managed type map), built using the "hash and displace" method: keys are first distributed
+// into buckets, then for each bucket (largest first) we look for a displacement value which places
+// all of the bucket's keys in still free slots of the table. At runtime a lookup is then a single
+// hash of the name, one displacement read and one slot read.
+//
+// The mixing, bucket and slot functions below MUST be kept in sync with their counterparts in
+// src/native/clr/include/runtime-base/minimal-perfect-hash.hh
+//
+static class MinimalPerfectHash
+{
+	// Average number of keys per bucket. Larger values make the displacement table smaller at the
+	// cost of (slightly) longer build time.
+	const uint KeysPerBucket = 4;
+
+	// Upper bound on displacement values tried for a single bucket, if it's reached the table can't
+	// be built and the caller should fall back to a sorted index.
+	const uint MaxDisplacement = 1u << 24;
+
+	public static ulong Mix (ulong x)
+	{
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdUL;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53UL;
+		x ^= x >> 33;
+		return x;
+	}
+
+	public static uint GetBucket (uint hash, uint bucketCount) => (uint)((Mix (hash) >> 32) % bucketCount);
+
+	public static uint GetSlot (uint hash, uint displacement, uint slotCount) => (uint)(Mix (((ulong)displacement << 32) | hash) % slotCount);
+
+	public static uint GetBucketCount (int keyCount) => keyCount == 0 ? 0 : (uint)Math.Max (1, (keyCount + KeysPerBucket - 1) / KeysPerBucket);
+
+	/// <summary>
+	/// Builds a minimal perfect hash table for the distinct values of the sorted <paramref name="sortedHashes"/>, which
+	/// may contain duplicates. Each slot in <paramref name="slots"/> holds the index of the first occurrence of the slot's
+	/// hash in <paramref name="sortedHashes"/>, the remaining occurrences (if any) immediately follow it.
+	/// </summary>
+	public static bool TryBuildForSortedHashes (IReadOnlyList<uint> sortedHashes, out uint[] displacements, out uint[] slots)
+	{
+		var uniqueHashes = new List<uint> ();
+		var firstIndexes = new List<uint> ();
+		for (int i = 0; i < sortedHashes.Count; i++) {
+			if (i > 0 && sortedHashes[i] < sortedHashes[i - 1]) {
+				throw new ArgumentException ("Hashes must be sorted", nameof (sortedHashes));
+			}
+
+			if (i > 0 && sortedHashes[i] == sortedHashes[i - 1]) {
+				continue;
+			}
+
+			uniqueHashes.Add (sortedHashes[i]);
+			firstIndexes.Add ((uint)i);
+		}
+
+		if (!TryBuild (uniqueHashes, out displacements, out int[] keySlots)) {
+			slots = Array.Empty<uint> ();
+			return false;
+		}
+
+		slots = new uint [keySlots.Length];
+		for (int i = 0; i < keySlots.Length; i++) {
+			slots[i] = firstIndexes[keySlots[i]];
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Builds a minimal perfect hash table for the given (unique) <paramref name="hashes"/>. On success,
+	/// <paramref name="displacements"/> contains one value per bucket and <paramref name="slots"/> maps
+	/// each table slot to the index of the key in <paramref name="hashes"/>. Returns <c>false</c> if the
+	/// hashes contain duplicates or no displacement could be found for some bucket.
+	/// </summary>
+	public static bool TryBuild (IReadOnlyList<uint> hashes, out uint[] displacements, out int[] slots)
+	{
+		int keyCount = hashes.Count;
+		uint bucketCount = GetBucketCount (keyCount);
+		displacements = new uint [bucketCount];
+		slots = new int [keyCount];
+
+		if (keyCount == 0) {
+			return true;
+		}
+
+		var seen = new HashSet<uint> ();
+		var buckets = new List<int>?[bucketCount];
+		for (int i = 0; i < keyCount; i++) {
+			if (!seen.Add (hashes[i])) {
+				return false;
+			}
+
+			uint bucket = GetBucket (hashes[i], bucketCount);
+			(buckets[bucket] ??= new List<int> ()).Add (i);
+		}
+
+		// Place the largest buckets first, while the table is still mostly empty. Ties are broken by
+		// bucket index to keep the output deterministic.
+		var order = new int [bucketCount];
+		for (int i = 0; i < order.Length; i++) {
+			order[i] = i;
+		}
+		Array.Sort (order, (int a, int b) => {
+			int sizeA = buckets[a]?.Count ?? 0;
+			int sizeB = buckets[b]?.Count ?? 0;
+			return sizeA != sizeB ? sizeB.CompareTo (sizeA) : a.CompareTo (b);
+		});
+
+		var occupied = new bool [keyCount];
+		var candidateSlots = new uint [KeysPerBucket * 8];
+		foreach (int bucket in order) {
+			List<int>? keys = buckets[bucket];
+			if (keys == null) {
+				// Buckets are sorted by size, so all the remaining ones are empty too
+				break;
+			}
+
+			if (candidateSlots.Length < keys.Count) {
+				candidateSlots = new uint [keys.Count];
+			}
+
+			bool placed = false;
+			for (uint displacement = 0; displacement < MaxDisplacement; displacement++) {
+				if (TryPlace (keys, displacement)) {
+					displacements[bucket] = displacement;
+					for (int i = 0; i < keys.Count; i++) {
+						occupied[candidateSlots[i]] = true;
+						slots[candidateSlots[i]] = keys[i];
+					}
+					placed = true;
+					break;
+				}
+			}
+
+			if (!placed) {
+				return false;
+			}
+		}
+
+		return true;
+
+		bool TryPlace (List<int> keys, uint displacement)
+		{
+			for (int i = 0; i < keys.Count; i++) {
+				uint slot = GetSlot (hashes[keys[i]], displacement, (uint)keyCount);
+				if (occupied[slot]) {
+					return false;
+				}
+
+				for (int j = 0; j < i; j++) {
+					if (candidateSlots[j] == slot) {
+						return false;
+					}
+				}
+				candidateSlots[i] = slot;
+			}
+
+			return true;
+		}
+	}
+}
@@ -44,6 +44,24 @@ static class TypeMapHelper
 		return Crc32.HashToUInt32 (buffer);
 	}
 
+	/// <summary>
+	/// Hash the given type name for use in CoreCLR native typemap arrays keyed on 64-bit hashes.
+	/// MUST produce the same values as <c>xxh3_hash</c> in src/native/clr/include/runtime-base/xxh3.hh
+	/// </summary>
+	public static ulong HashNameForCLR64 (string name)
+	{
+		if (name.Length == 0) {
+			return UInt64.MaxValue;
+		}
+
+		int byteCount = Encoding.UTF8.GetByteCount (name);
+		Span<byte> buffer = byteCount <= StackallocThresholdBytes
+			? stackalloc byte [byteCount]
+			: new byte [byteCount];
+		GetBytes (name, Encoding.UTF8, buffer);
+		return XxHash3.HashToUInt64 (buffer);
+	}
+
 	/// <summary>
 	/// Encodes <paramref name="value"/> into <paramref name="buffer"/>, which must be at least
 	/// <c>encoding.GetByteCount (value)</c> bytes long.  Callers allocate the buffer themselves so
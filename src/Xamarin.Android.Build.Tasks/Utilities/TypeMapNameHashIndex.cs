@@ -0,0 +1,53 @@
+#nullable enable
+using System;
+using System.Collections.Generic;
+
+namespace Xamarin.Android.Tasks;
+
+//
+// Open addressing (linear probing) hash table which maps type name hashes to indexes of the names' entries in a
+// CoreCLR Debug typemap array, so that the runtime doesn't have to binary search the array. The table is at most
+// half full, which makes most lookups look at a single slot. Empty slots contain 0, occupied ones the entry index + 1.
+//
+// GetHomeSlot MUST be kept in sync with `TypeMapper::name_index_home_slot` in src/native/clr/host/typemap.cc
+//
+static class TypeMapNameHashIndex
+{
+	public static uint GetSize (uint entryCount)
+	{
+		if (entryCount == 0) {
+			return 0;
+		}
+
+		uint size = 1;
+		while (size < entryCount * 2) {
+			size <<= 1;
+		}
+
+		return size;
+	}
+
+	public static uint GetHomeSlot (uint hash, uint indexSize) => (uint)(((ulong)hash * 0x9e3779b97f4a7c15UL) >> 32) & (indexSize - 1);
+
+	/// <summary>
+	/// Builds an index of <paramref name="indexSize"/> slots (as returned by <see cref="GetSize"/>) for the array entries
+	/// with the given name <paramref name="hashes"/>.
+	/// </summary>
+	public static uint[] Build (IReadOnlyList<uint> hashes, uint indexSize)
+	{
+		if ((ulong)hashes.Count * 2 > indexSize) {
+			throw new ArgumentOutOfRangeException (nameof (indexSize), $"Index of {indexSize} slots is too small for {hashes.Count} entries");
+		}
+
+		var index = new uint [indexSize];
+		for (int i = 0; i < hashes.Count; i++) {
+			uint slot = GetHomeSlot (hashes[i], indexSize);
+			while (index[slot] != 0) {
+				slot = (slot + 1) & (indexSize - 1);
+			}
+			index[slot] = (uint)i + 1;
+		}
+
+		return index;
+	}
+}
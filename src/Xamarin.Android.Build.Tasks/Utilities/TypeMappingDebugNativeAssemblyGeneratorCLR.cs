@@ -18,6 +18,9 @@ class TypeMappingDebugNativeAssemblyGeneratorCLR : LlvmIrComposer
 	const string ManagedTypeNamesBlobSymbol = "type_map_managed_type_names";
 	const string JavaTypeNamesBlobSymbol = "type_map_java_type_names";
 	const string TypeMapManagedTypeInfoSymbol = "type_map_managed_type_info";
+	const string NameIndexSizeSymbol = "type_map_name_index_size";
+	const string JavaToManagedNameIndexSymbol = "type_map_java_to_managed_index";
+	const string ManagedToJavaNameIndexSymbol = "type_map_managed_to_java_index";
 
 	sealed class TypeMapContextDataProvider : NativeAssemblerStructContextDataProvider
 	{
@@ -224,7 +227,7 @@ class TypeMappingDebugNativeAssemblyGeneratorCLR : LlvmIrComposer
 		}
 
 		var managedTypeInfos = new List<StructureInstance<TypeMapManagedTypeInfo>> ();
-		// Java-to-managed maps don't use hashes since many mappings have multiple instances
+		// Java-to-managed maps are sorted on name, the hashes are used only by the name index
 		foreach (TypeMapGenerator.TypeMapDebugEntry entry in data.JavaToManagedMap) {
 			TypeMapGenerator.TypeMapDebugEntry managedEntry = entry.DuplicateForJavaToManaged != null ? entry.DuplicateForJavaToManaged : entry;
 			(int managedTypeNameOffset, int _) = managedTypeNames.Add (managedEntry.ManagedName);
@@ -235,7 +238,7 @@ class TypeMappingDebugNativeAssemblyGeneratorCLR : LlvmIrComposer
 				To = managedEntry.SkipInJavaToManaged ? String.Empty : managedEntry.ManagedName,
 
 				from = (uint)javaTypeNameOffset,
-				from_hash = 0,
+				from_hash = TypeMapHelper.HashNameForCLR (entry.JavaName),
 				to = managedEntry.SkipInJavaToManaged ? uint.MaxValue : (uint)managedTypeNameOffset,
 			};
 			javaToManagedMap.Add (new StructureInstance<TypeMapEntry> (typeMapEntryStructureInfo, j2m));
@@ -263,7 +266,13 @@ class TypeMappingDebugNativeAssemblyGeneratorCLR : LlvmIrComposer
 		};
 		type_map = new StructureInstance<TypeMap> (typeMapStructureInfo, map);
 
+		// Both indexes share the size, so that the runtime needs to know just one
+		uint nameIndexSize = TypeMapNameHashIndex.GetSize ((uint)Math.Max (javaToManagedMap.Count, managedToJavaMap.Count));
+
 		module.AddGlobalVariable (TypeMapSymbol, type_map, LlvmIrVariableOptions.GlobalConstant);
+		module.AddGlobalVariable (NameIndexSizeSymbol, nameIndexSize, LlvmIrVariableOptions.GlobalConstant);
+		module.AddGlobalVariable (JavaToManagedNameIndexSymbol, BuildNameIndex (javaToManagedMap, nameIndexSize), LlvmIrVariableOptions.GlobalConstant, " Java type name hash to java_to_managed entry index + 1");
+		module.AddGlobalVariable (ManagedToJavaNameIndexSymbol, BuildNameIndex (managedToJavaMap, nameIndexSize), LlvmIrVariableOptions.GlobalConstant, " Managed type name hash to managed_to_java entry index + 1");
 		module.AddGlobalVariable (ManagedToJavaSymbol, managedToJavaMap, LlvmIrVariableOptions.LocalConstant);
 		module.AddGlobalVariable (JavaToManagedSymbol, javaToManagedMap, LlvmIrVariableOptions.LocalConstant);
 		module.AddGlobalVariable (TypeMapManagedTypeInfoSymbol, managedTypeInfos, LlvmIrVariableOptions.GlobalConstant);
@@ -272,6 +281,16 @@ class TypeMappingDebugNativeAssemblyGeneratorCLR : LlvmIrComposer
 		module.AddGlobalVariable (JavaTypeNamesBlobSymbol, javaTypeNames, LlvmIrVariableOptions.GlobalConstant);
 	}
 
+	static List<uint> BuildNameIndex (List<StructureInstance<TypeMapEntry>> map, uint indexSize)
+	{
+		var hashes = new List<uint> (map.Count);
+		foreach (StructureInstance<TypeMapEntry> entry in map) {
+			hashes.Add (entry.Instance?.from_hash ?? 0);
+		}
+
+		return new List<uint> (TypeMapNameHashIndex.Build (hashes, indexSize));
+	}
+
 	void MapStructures (LlvmIrModule module)
 	{
 		typeMapEntryStructureInfo = module.MapStructure<TypeMapEntry> ();
@@ -1,6 +1,7 @@
 #nullable disable
 
 using System;
+using System.Buffers.Binary;
 using System.Collections.Generic;
 
 using Microsoft.Build.Utilities;
@@ -11,6 +12,10 @@ namespace Xamarin.Android.Tasks
 {
 	partial class TypeMappingReleaseNativeAssemblyGeneratorCLR : LlvmIrComposer
 	{
+		// MUST match the TYPEMAP_MODULE_* flags in src/native/clr/include/xamarin-app.hh
+		const uint TYPEMAP_MODULE_EYTZINGER_MAP_FLAG = 0x01;
+		const uint TYPEMAP_MODULE_EYTZINGER_DUPLICATE_MAP_FLAG = 0x02;
+
 		sealed class TypeMapModuleContextDataProvider : NativeAssemblerStructContextDataProvider
 		{
 			public override string GetComment (object data, string fieldName)
@@ -68,7 +73,7 @@ namespace Xamarin.Android.Tasks
 			{
 				var module_map_entry = EnsureType<TypeMapModuleEntry> (data);
 
-				if (MonoAndroidHelper.StringEquals ("managed_type_name_hash", fieldName)) {
+				if (MonoAndroidHelper.StringEquals ("managed_type_name_index", fieldName)) {
 					return $" managed type name: {module_map_entry.ManagedTypeName}";
 				}
 
@@ -91,8 +96,9 @@ namespace Xamarin.Android.Tasks
 			[NativeAssembler (Ignore = true)]
 			public string ManagedTypeName;
 
-			[NativeAssembler (NumberFormat = LlvmIrVariableNumberFormat.Hexadecimal)]
-			public uint managed_type_name_hash;
+			// Output to the `modules_*_hashes` arrays, parallel to the entries
+			[NativeAssembler (Ignore = true)]
+			public ulong ManagedTypeNameHash;
 
 			[NativeAssembler (UsesDataProvider = true)]
 			public uint managed_type_name_index;
@@ -131,6 +137,9 @@ namespace Xamarin.Android.Tasks
 
 			[NativeAssembler (UsesDataProvider = true)]
 			public uint duplicate_map_index;
+
+			[NativeAssembler (NumberFormat = LlvmIrVariableNumberFormat.Hexadecimal)]
+			public uint flags;
 		}
 
 		// Order of fields and their type must correspond *exactly* to that in
@@ -145,7 +154,7 @@ namespace Xamarin.Android.Tasks
 			public string ManagedTypeName;
 
 			[NativeAssembler (Ignore = true)]
-			public uint JavaNameHash;
+			public ulong JavaNameHash;
 
 			public uint module_index;
 
@@ -195,6 +204,10 @@ namespace Xamarin.Android.Tasks
 			public LlvmIrStringBlob AssemblyNamesBlob;
 			public LlvmIrStringBlob JavaTypeNamesBlob;
 			public LlvmIrStringBlob ManagedTypeNamesBlob;
+			public List<uint> JavaHashesPerfectHashDisplacements;
+			public List<uint> JavaHashesPerfectHashSlots;
+			public HashSet<LlvmIrArraySectionBase> EytzingerSections;
+			public bool Use64BitHashes;
 		}
 
 		readonly NativeTypeMappingData mappingData;
@@ -230,11 +243,13 @@ namespace Xamarin.Android.Tasks
 			MapStructures (module);
 
 			var cs = new ConstructionState ();
+			cs.Use64BitHashes = CanUse64BitHashes ();
 			cs.JavaTypesByName = new Dictionary<string, TypeMapJava> (StringComparer.Ordinal);
 			InitJavaMap (cs);
 			InitMapModules (cs);
 			PrepareModules (cs);
 
+			module.AddGlobalVariable ("typemap_name_hash_bits", cs.Use64BitHashes ? 64u : 32u, LlvmIrVariableOptions.GlobalConstant, " Type name hashes are CRC32 (32) or xxh3 (64) ones");
 			module.AddGlobalVariable ("managed_to_java_map_module_count", mappingData.MapModuleCount);
 			module.AddGlobalVariable ("java_type_count", cs.JavaMap.Count);
 
@@ -243,6 +258,10 @@ namespace Xamarin.Android.Tasks
 			};
 			module.Add (managed_to_java_map);
 
+			List<uint> moduleIndex = BuildModuleIndex (cs);
+			module.AddGlobalVariable ("managed_to_java_module_index_size", (uint)moduleIndex.Count, LlvmIrVariableOptions.GlobalConstant);
+			module.AddGlobalVariable ("managed_to_java_module_index", moduleIndex, LlvmIrVariableOptions.GlobalConstant, " Managed modules MVID hash table, 1-based indexes into managed_to_java_map");
+
 			// Java hashes are output before Java type map **and** managed modules, because they will also sort the Java map for us.
 			// This is not strictly necessary, as we could do the sorting in the java map BeforeWriteCallback, but this way we save
 			// time sorting only once.
@@ -257,6 +276,56 @@ namespace Xamarin.Android.Tasks
 			java_to_managed_hashes.WriteOptions &= ~LlvmIrVariableWriteOptions.ArrayWriteIndexComments;
 			module.Add (java_to_managed_hashes);
 
+			var java_to_managed_hashes64 = new LlvmIrGlobalVariable (typeof(List<ulong>), "java_to_managed_hashes64") {
+				Comment = " Java types name 64-bit hashes",
+				BeforeWriteCallback = (LlvmIrVariable v, LlvmIrModuleTarget target, object? state) => {
+					ConstructionState cs = EnsureConstructionState (state);
+					EnsureGlobalVariable (v).OverrideTypeAndValue (typeof(List<ulong>), cs.Use64BitHashes ? GetJavaHashes (cs) : new List<ulong> ());
+				},
+				BeforeWriteCallbackCallerState = cs,
+				GetArrayItemCommentCallback = GetJavaHashesItemComment,
+				GetArrayItemCommentCallbackCallerState = cs,
+				NumberFormat = LlvmIrVariableNumberFormat.Hexadecimal,
+			};
+			java_to_managed_hashes64.WriteOptions &= ~LlvmIrVariableWriteOptions.ArrayWriteIndexComments;
+			module.Add (java_to_managed_hashes64);
+
+			// The perfect hash table is built over the hashes sorted above, so it must be output after them. Bucket count of 0 means the
+			// table couldn't be built and the runtime has to search the sorted hashes instead.
+			var java_to_managed_perfect_hash_bucket_count = new LlvmIrGlobalVariable (typeof(uint), "java_to_managed_perfect_hash_bucket_count", LlvmIrVariableOptions.GlobalConstant) {
+				Comment = " Java type name hashes perfect hash table bucket count",
+				BeforeWriteCallback = BuildJavaHashesPerfectHash,
+				BeforeWriteCallbackCallerState = cs,
+			};
+			module.Add (java_to_managed_perfect_hash_bucket_count);
+
+			var java_to_managed_perfect_hash_slot_count = new LlvmIrGlobalVariable (typeof(uint), "java_to_managed_perfect_hash_slot_count", LlvmIrVariableOptions.GlobalConstant) {
+				Comment = " Java type name hashes perfect hash table slot count",
+				BeforeWriteCallback = (LlvmIrVariable v, LlvmIrModuleTarget target, object? state) => {
+					EnsureGlobalVariable (v).OverrideTypeAndValue (typeof(uint), (uint)EnsureConstructionState (state).JavaHashesPerfectHashSlots.Count);
+				},
+				BeforeWriteCallbackCallerState = cs,
+			};
+			module.Add (java_to_managed_perfect_hash_slot_count);
+
+			var java_to_managed_perfect_hash_displacements = new LlvmIrGlobalVariable (typeof(List<uint>), "java_to_managed_perfect_hash_displacements", LlvmIrVariableOptions.GlobalConstant) {
+				Comment = " Java type name hashes perfect hash table displacements, one per bucket",
+				BeforeWriteCallback = (LlvmIrVariable v, LlvmIrModuleTarget target, object? state) => {
+					EnsureGlobalVariable (v).OverrideTypeAndValue (typeof(List<uint>), EnsureConstructionState (state).JavaHashesPerfectHashDisplacements);
+				},
+				BeforeWriteCallbackCallerState = cs,
+			};
+			module.Add (java_to_managed_perfect_hash_displacements);
+
+			var java_to_managed_perfect_hash_slots = new LlvmIrGlobalVariable (typeof(List<uint>), "java_to_managed_perfect_hash_slots", LlvmIrVariableOptions.GlobalConstant) {
+				Comment = " Java type name hashes perfect hash table slots, indexes into the Java type name hashes and java_to_managed_map",
+				BeforeWriteCallback = (LlvmIrVariable v, LlvmIrModuleTarget target, object? state) => {
+					EnsureGlobalVariable (v).OverrideTypeAndValue (typeof(List<uint>), EnsureConstructionState (state).JavaHashesPerfectHashSlots);
+				},
+				BeforeWriteCallbackCallerState = cs,
+			};
+			module.Add (java_to_managed_perfect_hash_slots);
+
 			var modulesMapData = new LlvmIrGlobalVariable (cs.AllModulesMaps, "modules_map_data", LlvmIrVariableOptions.GlobalConstant) {
 				BeforeWriteCallback = SortEntriesAndUpdateJavaIndexes,
 				BeforeWriteCallbackCallerState = cs,
@@ -269,6 +338,12 @@ namespace Xamarin.Android.Tasks
 			};
 			module.Add (modulesDuplicatesData);
 
+			// The hashes must be output after the entries, which get sorted when the latter are written
+			module.Add (CreateModuleEntryHashesVariable ("modules_map_hashes", cs.AllModulesMaps, is64Bit: false, cs));
+			module.Add (CreateModuleEntryHashesVariable ("modules_duplicates_hashes", cs.AllModulesDuplicates, is64Bit: false, cs));
+			module.Add (CreateModuleEntryHashesVariable ("modules_map_hashes64", cs.AllModulesMaps, is64Bit: true, cs));
+			module.Add (CreateModuleEntryHashesVariable ("modules_duplicates_hashes64", cs.AllModulesDuplicates, is64Bit: true, cs));
+
 			module.AddGlobalVariable ("java_to_managed_map", cs.JavaMap, LlvmIrVariableOptions.GlobalConstant, " Java to managed map");
 			module.AddGlobalVariable ("java_type_names", cs.JavaTypeNamesBlob, LlvmIrVariableOptions.GlobalConstant, " Java type names");
 			module.AddGlobalVariable ("java_type_names_size", (ulong)cs.JavaTypeNamesBlob.Size, LlvmIrVariableOptions.GlobalConstant, " Java type names blob size");
@@ -287,7 +362,7 @@ namespace Xamarin.Android.Tasks
 					(object a, object b) => {
 						var entryA = ((StructureInstance<TypeMapModuleEntry>)a).Instance;
 						var entryB = ((StructureInstance<TypeMapModuleEntry>)b).Instance;
-						int hashCompare = entryA.managed_type_name_hash.CompareTo (entryB.managed_type_name_hash);
+						int hashCompare = entryA.ManagedTypeNameHash.CompareTo (entryB.ManagedTypeNameHash);
 						if (hashCompare != 0) {
 							return hashCompare;
 						}
@@ -296,6 +371,10 @@ namespace Xamarin.Android.Tasks
 					}
 				);
 
+				if (cs.EytzingerSections.Contains (section)) {
+					EytzingerLayout.Apply (section.Data);
+				}
+
 				foreach (StructureInstance<TypeMapModuleEntry> entry in section.Data) {
 					entry.Instance.java_map_index = GetJavaEntryIndex (entry.Instance.JavaTypeMapEntry);
 				}
@@ -330,17 +409,129 @@ namespace Xamarin.Android.Tasks
 
 			for (int i = 0; i < cs.JavaMap.Count; i++) {
 				TypeMapJava entry = cs.JavaMap[i].Instance;
-				entry.JavaNameHash = TypeMapHelper.HashNameForCLR (entry.JavaName);
+				entry.JavaNameHash = HashName (entry.JavaName, cs);
 			}
 
 			cs.JavaMap.Sort (javaNameHashComparer);
 
 			var hashes = new List<uint> ();
+			if (!cs.Use64BitHashes) {
+				foreach (ulong hash in GetJavaHashes (cs)) {
+					hashes.Add ((uint)hash);
+				}
+			}
+
+			gv.OverrideTypeAndValue (typeof(List<uint>), hashes);
+		}
+
+		static List<ulong> GetJavaHashes (ConstructionState cs)
+		{
+			var hashes = new List<ulong> (cs.JavaMap.Count);
 			foreach (StructureInstance<TypeMapJava> si in cs.JavaMap) {
 				hashes.Add (si.Instance.JavaNameHash);
 			}
 
-			gv.OverrideTypeAndValue (typeof(List<uint>), hashes);
+			return hashes;
+		}
+
+		LlvmIrGlobalVariable CreateModuleEntryHashesVariable (string name, LlvmIrSectionedArray<StructureInstance<TypeMapModuleEntry>> entries, bool is64Bit, ConstructionState cs)
+		{
+			Type type = is64Bit ? typeof(List<ulong>) : typeof(List<uint>);
+			return new LlvmIrGlobalVariable (type, name, LlvmIrVariableOptions.GlobalConstant) {
+				BeforeWriteCallback = (LlvmIrVariable v, LlvmIrModuleTarget target, object? state) => {
+					var hashes32 = new List<uint> ();
+					var hashes64 = new List<ulong> ();
+
+					// Only the arrays matching the hash width have any entries
+					if (cs.Use64BitHashes == is64Bit) {
+						foreach (LlvmIrArraySection<StructureInstance<TypeMapModuleEntry>> section in entries.Sections) {
+							foreach (StructureInstance<TypeMapModuleEntry> entry in section.Data) {
+								if (is64Bit) {
+									hashes64.Add (entry.Instance.ManagedTypeNameHash);
+								} else {
+									hashes32.Add ((uint)entry.Instance.ManagedTypeNameHash);
+								}
+							}
+						}
+					}
+
+					EnsureGlobalVariable (v).OverrideTypeAndValue (type, is64Bit ? hashes64 : hashes32);
+				},
+				NumberFormat = LlvmIrVariableNumberFormat.Hexadecimal,
+			};
+		}
+
+		static ulong HashName (string name, ConstructionState cs) => cs.Use64BitHashes ? TypeMapHelper.HashNameForCLR64 (name) : TypeMapHelper.HashNameForCLR (name);
+
+		// The runtime compares only the 64-bit hashes, without the names, so none of them may be shared by two names. If that
+		// ever happens, the CRC32 hashes are used instead.
+		bool CanUse64BitHashes ()
+		{
+			var javaNames = new Dictionary<ulong, string> ();
+			var managedNames = new Dictionary<ulong, string> ();
+			foreach (TypeMapGenerator.TypeMapReleaseEntry entry in mappingData.JavaTypes) {
+				if (!TryAdd (javaNames, entry.JavaName)) {
+					return false;
+				}
+			}
+
+			foreach (TypeMapGenerator.ModuleReleaseData module in mappingData.Modules) {
+				foreach (TypeMapGenerator.TypeMapReleaseEntry entry in module.Types) {
+					if (!TryAdd (managedNames, entry.ManagedTypeName)) {
+						return false;
+					}
+				}
+
+				foreach (TypeMapGenerator.TypeMapReleaseEntry entry in module.DuplicateTypes) {
+					if (!TryAdd (managedNames, entry.ManagedTypeName)) {
+						return false;
+					}
+				}
+			}
+
+			return true;
+
+			bool TryAdd (Dictionary<ulong, string> seen, string name)
+			{
+				ulong hash = TypeMapHelper.HashNameForCLR64 (name);
+				if (!seen.TryGetValue (hash, out string seenName)) {
+					seen.Add (hash, name);
+					return true;
+				}
+
+				if (MonoAndroidHelper.StringEquals (seenName, name)) {
+					return true;
+				}
+
+				Log.LogDebugMessage ($"Type names '{seenName}' and '{name}' share the 64-bit hash 0x{hash:x}, the typemap will use CRC32 hashes");
+				return false;
+			}
+		}
+
+		void BuildJavaHashesPerfectHash (LlvmIrVariable variable, LlvmIrModuleTarget target, object? callerState)
+		{
+			ConstructionState cs = EnsureConstructionState (callerState);
+			LlvmIrGlobalVariable gv = EnsureGlobalVariable (variable);
+
+			// Different Java type names may share a hash, the runtime walks all the entries following the one found in the table,
+			// just as it does after a binary search of the sorted hashes. 64-bit hashes are keyed on their upper half, which keeps
+			// the keys sorted.
+			var hashes = new List<uint> (cs.JavaMap.Count);
+			foreach (StructureInstance<TypeMapJava> si in cs.JavaMap) {
+				ulong hash = si.Instance.JavaNameHash;
+				hashes.Add (cs.Use64BitHashes ? (uint)(hash >> 32) : (uint)hash);
+			}
+
+			cs.JavaHashesPerfectHashDisplacements = new List<uint> ();
+			cs.JavaHashesPerfectHashSlots = new List<uint> ();
+			if (MinimalPerfectHash.TryBuildForSortedHashes (hashes, out uint[] displacements, out uint[] slots)) {
+				cs.JavaHashesPerfectHashDisplacements.AddRange (displacements);
+				cs.JavaHashesPerfectHashSlots.AddRange (slots);
+			} else {
+				Log.LogDebugMessage ($"Unable to build a perfect hash table for {hashes.Count} Java type name hashes, the runtime will use binary search");
+			}
+
+			gv.OverrideTypeAndValue (typeof(uint), (uint)cs.JavaHashesPerfectHashDisplacements.Count);
 		}
 
 		ConstructionState EnsureConstructionState (object? callerState)
@@ -423,6 +614,15 @@ namespace Xamarin.Android.Tasks
 					duplicate_map_index = haveDuplicates ? duplicates_start_index : UInt32.MaxValue,
 				};
 
+				// Large maps are laid out for the cache-friendly Eytzinger search, small ones are left sorted
+				if (map_module.entry_count >= EytzingerLayout.MinimumEntryCount) {
+					map_module.flags |= TYPEMAP_MODULE_EYTZINGER_MAP_FLAG;
+				}
+
+				if (map_module.duplicate_count >= EytzingerLayout.MinimumEntryCount) {
+					map_module.flags |= TYPEMAP_MODULE_EYTZINGER_DUPLICATE_MAP_FLAG;
+				}
+
 				map_start_index += map_module.entry_count;
 				duplicates_start_index += map_module.duplicate_count;
 
@@ -430,6 +630,40 @@ namespace Xamarin.Android.Tasks
 			}
 		}
 
+		// MUST produce the same values as `TypeMapper::module_index_home_slot` in src/native/clr/host/typemap.cc
+		static uint GetModuleIndexHomeSlot (byte[] mvid, uint indexSize)
+		{
+			ulong key = BinaryPrimitives.ReadUInt64LittleEndian (mvid);
+			return (uint)((key * 0x9e3779b97f4a7c15UL) >> 32) & (indexSize - 1);
+		}
+
+		// Open addressing (linear probing) hash table keyed by the first 8 bytes of module MVID. The table is at most half full,
+		// so that most lookups need to look at a single slot. Empty slots are 0, occupied ones contain module index + 1.
+		static List<uint> BuildModuleIndex (ConstructionState cs)
+		{
+			var ret = new List<uint> ();
+			if (cs.MapModules.Count == 0) {
+				return ret;
+			}
+
+			uint indexSize = 1;
+			while (indexSize < (uint)cs.MapModules.Count * 2) {
+				indexSize <<= 1;
+			}
+
+			var slots = new uint[indexSize];
+			for (int i = 0; i < cs.MapModules.Count; i++) {
+				uint slot = GetModuleIndexHomeSlot (cs.MapModules[i].Instance.module_uuid, indexSize);
+				while (slots[slot] != 0) {
+					slot = (slot + 1) & (indexSize - 1);
+				}
+				slots[slot] = (uint)i + 1;
+			}
+
+			ret.AddRange (slots);
+			return ret;
+		}
+
 		void MapStructures (LlvmIrModule module)
 		{
 			typeMapJavaStructureInfo = module.MapStructure<TypeMapJava> ();
@@ -437,9 +671,12 @@ namespace Xamarin.Android.Tasks
 			typeMapModuleEntryStructureInfo = module.MapStructure<TypeMapModuleEntry> ();
 		}
 
-		void PrepareMapModuleData (IEnumerable<TypeMapGenerator.TypeMapReleaseEntry> moduleEntries, LlvmIrSectionedArray<StructureInstance<TypeMapModuleEntry>> destCollection, string sectionHeader, ConstructionState cs)
+		void PrepareMapModuleData (IEnumerable<TypeMapGenerator.TypeMapReleaseEntry> moduleEntries, LlvmIrSectionedArray<StructureInstance<TypeMapModuleEntry>> destCollection, string sectionHeader, bool eytzingerLayout, ConstructionState cs)
 		{
 			var moduleSection = new LlvmIrArraySection<StructureInstance<TypeMapModuleEntry>> (sectionHeader);
+			if (eytzingerLayout) {
+				cs.EytzingerSections.Add (moduleSection);
+			}
 			foreach (TypeMapGenerator.TypeMapReleaseEntry entry in moduleEntries) {
 				if (!cs.JavaTypesByName.TryGetValue (entry.JavaName, out TypeMapJava javaType)) {
 					throw new InvalidOperationException ($"Internal error: Java type '{entry.JavaName}' not found in cache");
@@ -450,7 +687,7 @@ namespace Xamarin.Android.Tasks
 					JavaTypeMapEntry = javaType,
 					ManagedTypeName = entry.ManagedTypeName,
 
-					managed_type_name_hash = TypeMapHelper.HashNameForCLR (entry.ManagedTypeName),
+					ManagedTypeNameHash = HashName (entry.ManagedTypeName, cs),
 					managed_type_name_index = (uint)managedTypeNameIndex,
 					managed_type_name_length = (uint)managedTypeNameLength,
 					java_map_index = UInt32.MaxValue, // will be set later, when the target is known
@@ -463,12 +700,14 @@ namespace Xamarin.Android.Tasks
 		void PrepareModules (ConstructionState cs)
 		{
 			cs.AllModulesData = new List<ModuleMapData> ();
+			cs.EytzingerSections = new HashSet<LlvmIrArraySectionBase> ();
 			foreach (StructureInstance<TypeMapModule> moduleInstance in cs.MapModules) {
 				TypeMapModule module = moduleInstance.Instance;
 				PrepareMapModuleData (
 					module.Data.Types,
 					cs.AllModulesMaps,
 					$" Module: {module.AssemblyName}; MVID: {module.MVID}; number of entries: {module.Data.Types.Length}",
+					(module.flags & TYPEMAP_MODULE_EYTZINGER_MAP_FLAG) != 0,
 					cs
 				);
 				if (module.Data.DuplicateTypes.Count > 0) {
@@ -476,6 +715,7 @@ namespace Xamarin.Android.Tasks
 						module.Data.DuplicateTypes,
 						cs.AllModulesDuplicates,
 						$" Module: {module.AssemblyName}; MVID: {module.MVID}; number of entries: {module.Data.DuplicateTypes.Count}",
+						(module.flags & TYPEMAP_MODULE_EYTZINGER_DUPLICATE_MAP_FLAG) != 0,
 						cs
 					);
 				}
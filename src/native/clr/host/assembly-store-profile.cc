@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <constants.hh>
+#include <xamarin-app.hh>
+#include <host/assembly-store-profile.hh>
+#include <runtime-base/android-system.hh>
+#include <runtime-base/logger.hh>
+
+using namespace xamarin::android;
+
+namespace {
+	constexpr std::string_view PROFILE_FILE_NAME = "assembly-store-startup-profile-v1.bin"sv;
+
+	std::chrono::steady_clock::time_point recording_deadline {};
+
+	bool read_fully (int fd, uint8_t *buf, size_t len) noexcept
+	{
+		size_t off = 0;
+		while (off < len) {
+			ssize_t n = read (fd, buf + off, len - off);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return false;
+			}
+			if (n == 0) {
+				errno = EIO;
+				return false;
+			}
+			off += static_cast<size_t>(n);
+		}
+		return true;
+	}
+
+	bool write_fully (int fd, const uint8_t *buf, size_t len) noexcept
+	{
+		size_t off = 0;
+		while (off < len) {
+			ssize_t n = write (fd, buf + off, len - off);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return false;
+			}
+			if (n == 0) {
+				errno = EIO;
+				return false;
+			}
+			off += static_cast<size_t>(n);
+		}
+		return true;
+	}
+}
+
+void AssemblyStoreProfile::initialize (const uint8_t *store_start, uint64_t content_id, uint32_t assembly_count) noexcept
+{
+	store_data_start = store_start;
+	store_content_id = content_id;
+	store_assembly_count = assembly_count;
+
+	if (assembly_count == 0) {
+		return;
+	}
+
+	// The startup gains haven't been measured yet, so recording and prefetching are opt-in for now:
+	//   adb shell setprop debug.net.asmprofile 1
+	dynamic_local_property_string prop_value;
+	if (AndroidSystem::monodroid_get_system_property (Constants::DEBUG_NET_ASMPROFILE_PROPERTY, prop_value) <= 0 || prop_value.get () == nullptr || prop_value.get ()[0] != '1') {
+		log_debug (LOG_ASSEMBLY, "Assembly store startup profile not enabled"sv);
+		return;
+	}
+
+	std::string const& code_cache_dir = AndroidSystem::get_app_code_cache_dir ();
+	if (code_cache_dir.empty ()) {
+		return;
+	}
+
+	profile_path.assign (code_cache_dir);
+	profile_path.append ("/"sv);
+	profile_path.append (PROFILE_FILE_NAME);
+
+	recorded_order.reset (new (std::nothrow) uint32_t[assembly_count]);
+	recorded_seen.reset (new (std::nothrow) uint8_t[assembly_count]());
+	if (recorded_order == nullptr || recorded_seen == nullptr) {
+		recorded_order.reset ();
+		recorded_seen.reset ();
+		return;
+	}
+	std::fill_n (recorded_order.get (), assembly_count, INVALID_DESCRIPTOR_INDEX);
+
+	load_saved_profile ();
+
+	recording_deadline = std::chrono::steady_clock::now () + std::chrono::milliseconds (RECORDING_WINDOW_MS);
+	__atomic_store_n (&recording, true, __ATOMIC_RELEASE);
+}
+
+void AssemblyStoreProfile::record (uint32_t descriptor_index) noexcept
+{
+	if (descriptor_index >= store_assembly_count) [[unlikely]] {
+		return;
+	}
+
+	// Each assembly is recorded only once, the first time it's requested.
+	if (__atomic_exchange_n (&recorded_seen[descriptor_index], 1, __ATOMIC_ACQ_REL) != 0) {
+		return;
+	}
+
+	uint32_t slot = __atomic_fetch_add (&recorded_count, 1, __ATOMIC_ACQ_REL);
+	if (slot >= store_assembly_count) [[unlikely]] {
+		return;
+	}
+
+	__atomic_store_n (&recorded_order[slot], descriptor_index, __ATOMIC_RELEASE);
+}
+
+void AssemblyStoreProfile::load_saved_profile () noexcept
+{
+	int fd = open (profile_path.c_str (), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+	if (fd < 0) {
+		log_debug (LOG_ASSEMBLY, "No assembly store startup profile found at '{}'"sv, profile_path);
+		return;
+	}
+
+	struct stat st {};
+	ProfileFileHeader header {};
+	bool valid = fstat (fd, &st) == 0 &&
+		S_ISREG (st.st_mode) &&
+		static_cast<size_t>(st.st_size) >= sizeof (header) &&
+		read_fully (fd, reinterpret_cast<uint8_t*>(&header), sizeof (header)) &&
+		header.magic == PROFILE_FILE_MAGIC &&
+		header.version == PROFILE_FILE_FORMAT_VERSION &&
+		header.content_id == store_content_id &&
+		header.entry_count <= store_assembly_count &&
+		static_cast<size_t>(st.st_size) == sizeof (header) + (static_cast<size_t>(header.entry_count) * sizeof (ProfileFileEntry));
+
+	std::unique_ptr<ProfileFileEntry[]> entries;
+	if (valid && header.entry_count > 0) {
+		entries.reset (new (std::nothrow) ProfileFileEntry[header.entry_count]);
+		valid = entries != nullptr &&
+			read_fully (fd, reinterpret_cast<uint8_t*>(entries.get ()), header.entry_count * sizeof (ProfileFileEntry));
+	}
+	close (fd);
+
+	if (!valid || header.entry_count == 0) {
+		log_debug (LOG_ASSEMBLY, "Ignoring stale or invalid assembly store startup profile '{}'"sv, profile_path);
+		return;
+	}
+
+	saved_order.reset (new (std::nothrow) uint32_t[header.entry_count]);
+	if (saved_order == nullptr) {
+		return;
+	}
+
+	// The content ID match means the store is the one the profile was recorded for, but verify the
+	// ranges anyway: we're going to hand them to the kernel.
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < header.entry_count; i++) {
+		ProfileFileEntry const& entry = entries[i];
+		if (entry.descriptor_index >= store_assembly_count) {
+			continue;
+		}
+
+		AssemblyStoreEntryDescriptor const& desc = assembly_store.assemblies[entry.descriptor_index];
+		if (desc.data_offset != entry.data_offset || desc.data_size != entry.data_size) {
+			continue;
+		}
+		saved_order[count++] = entry.descriptor_index;
+	}
+	saved_entry_count = count;
+
+	log_debug (LOG_ASSEMBLY, "Loaded assembly store startup profile with {} entries from '{}'"sv, saved_entry_count, profile_path);
+}
+
+void AssemblyStoreProfile::prefetch_saved_profile () noexcept
+{
+	if (saved_entry_count == 0) {
+		return;
+	}
+
+	const uintptr_t page_size = static_cast<uintptr_t>(sysconf (_SC_PAGESIZE));
+	uintptr_t range_start = 0;
+	uintptr_t range_end = 0;
+	size_t total_bytes = 0;
+
+	auto advise = [&total_bytes](uintptr_t start, uintptr_t end) {
+		if (end <= start) {
+			return;
+		}
+
+		if (madvise (reinterpret_cast<void*>(start), end - start, MADV_WILLNEED) != 0) {
+			log_debug (LOG_ASSEMBLY, "madvise (MADV_WILLNEED) failed for the assembly store range {:p}-{:p}: {}"sv, reinterpret_cast<void*>(start), reinterpret_cast<void*>(end), std::strerror (errno));
+			return;
+		}
+		total_bytes += end - start;
+	};
+
+	// Ranges are issued in the recorded load order, so that the pages needed first are requested
+	// first. Adjacent (or overlapping) ranges are coalesced to save on system calls.
+	for (uint32_t i = 0; i < saved_entry_count; i++) {
+		AssemblyStoreEntryDescriptor const& desc = assembly_store.assemblies[saved_order[i]];
+		if (desc.data_size == 0) {
+			continue;
+		}
+
+		uintptr_t start = reinterpret_cast<uintptr_t>(store_data_start + desc.data_offset) & ~(page_size - 1);
+		uintptr_t end = (reinterpret_cast<uintptr_t>(store_data_start + desc.data_offset + desc.data_size) + page_size - 1) & ~(page_size - 1);
+
+		if (range_end != 0 && start <= range_end && end >= range_start) {
+			range_start = std::min (range_start, start);
+			range_end = std::max (range_end, end);
+			continue;
+		}
+
+		advise (range_start, range_end);
+		range_start = start;
+		range_end = end;
+	}
+	advise (range_start, range_end);
+
+	log_debug (LOG_ASSEMBLY, "Prefetched {} bytes of the assembly store for {} assemblies from the startup profile"sv, total_bytes, saved_entry_count);
+}
+
+auto AssemblyStoreProfile::recorded_profile_differs () noexcept -> bool
+{
+	uint32_t count = std::min (__atomic_load_n (&recorded_count, __ATOMIC_ACQUIRE), store_assembly_count);
+	std::vector<uint32_t> recorded;
+	recorded.reserve (count);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t descriptor_index = __atomic_load_n (&recorded_order[i], __ATOMIC_ACQUIRE);
+		if (descriptor_index != INVALID_DESCRIPTOR_INDEX) {
+			recorded.push_back (descriptor_index);
+		}
+	}
+
+	if (recorded.empty ()) {
+		return false;
+	}
+
+	if (recorded.size () != saved_entry_count) {
+		return true;
+	}
+
+	// Threads racing to load assemblies may change the order slightly from launch to launch, that
+	// isn't worth rewriting the profile for. Only a change in the set of assemblies is.
+	std::vector<uint32_t> saved (saved_order.get (), saved_order.get () + saved_entry_count);
+	std::sort (recorded.begin (), recorded.end ());
+	std::sort (saved.begin (), saved.end ());
+	return recorded != saved;
+}
+
+void AssemblyStoreProfile::persist_recorded_profile () noexcept
+{
+	uint32_t count = std::min (__atomic_load_n (&recorded_count, __ATOMIC_ACQUIRE), store_assembly_count);
+	std::vector<ProfileFileEntry> entries;
+	entries.reserve (count);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t descriptor_index = __atomic_load_n (&recorded_order[i], __ATOMIC_ACQUIRE);
+		if (descriptor_index == INVALID_DESCRIPTOR_INDEX) {
+			continue;
+		}
+
+		AssemblyStoreEntryDescriptor const& desc = assembly_store.assemblies[descriptor_index];
+		entries.push_back ({
+			.descriptor_index = descriptor_index,
+			.data_offset = desc.data_offset,
+			.data_size = desc.data_size,
+		});
+	}
+
+	ProfileFileHeader header {
+		.magic = PROFILE_FILE_MAGIC,
+		.version = PROFILE_FILE_FORMAT_VERSION,
+		.content_id = store_content_id,
+		.entry_count = static_cast<uint32_t>(entries.size ()),
+		.recording_window_ms = RECORDING_WINDOW_MS,
+	};
+
+	std::string tmp_path = profile_path;
+	tmp_path.append (".tmp."sv);
+	tmp_path.append (std::to_string (getpid ()));
+
+	int fd;
+	do {
+		fd = open (tmp_path.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
+	} while (fd < 0 && errno == EINTR);
+	if (fd < 0) {
+		log_debug (LOG_ASSEMBLY, "Failed to create assembly store startup profile '{}': {}"sv, tmp_path, std::strerror (errno));
+		return;
+	}
+
+	bool ok = write_fully (fd, reinterpret_cast<const uint8_t*>(&header), sizeof (header)) &&
+		write_fully (fd, reinterpret_cast<const uint8_t*>(entries.data ()), entries.size () * sizeof (ProfileFileEntry));
+	int error = ok ? 0 : errno;
+	if (close (fd) != 0 && ok) {
+		ok = false;
+		error = errno;
+	}
+
+	if (ok && rename (tmp_path.c_str (), profile_path.c_str ()) != 0) {
+		ok = false;
+		error = errno;
+	}
+
+	if (!ok) {
+		log_debug (LOG_ASSEMBLY, "Failed to write assembly store startup profile '{}': {}"sv, profile_path, std::strerror (error));
+		unlink (tmp_path.c_str ());
+		return;
+	}
+
+	log_debug (LOG_ASSEMBLY, "Saved assembly store startup profile with {} entries to '{}'"sv, entries.size (), profile_path);
+}
+
+[[gnu::cold]]
+auto AssemblyStoreProfile::background_thread_entry ([[maybe_unused]] void *arg) noexcept -> void*
+{
+	prefetch_saved_profile ();
+
+	std::this_thread::sleep_until (recording_deadline);
+	__atomic_store_n (&recording, false, __ATOMIC_RELEASE);
+
+	if (recorded_profile_differs ()) {
+		persist_recorded_profile ();
+	}
+
+	return nullptr;
+}
+
+void AssemblyStoreProfile::start_background_work () noexcept
+{
+	if (!__atomic_load_n (&recording, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	pthread_attr_t attributes;
+	int result = pthread_attr_init (&attributes);
+	bool attributes_initialized = result == 0;
+	if (result == 0) {
+		result = pthread_attr_setdetachstate (&attributes, PTHREAD_CREATE_DETACHED);
+	}
+
+	pthread_t thread;
+	if (result == 0) {
+		result = pthread_create (&thread, &attributes, background_thread_entry, nullptr);
+	}
+
+	if (attributes_initialized) {
+		pthread_attr_destroy (&attributes);
+	}
+
+	if (result != 0) {
+		log_debug (LOG_ASSEMBLY, "Failed to start assembly store startup profile thread: {}"sv, std::strerror (result));
+		__atomic_store_n (&recording, false, __ATOMIC_RELEASE);
+	}
+}
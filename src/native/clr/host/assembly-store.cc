@@ -1,20 +1,35 @@
+#include <algorithm>
 #include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <deque>
+#include <ctime>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include <dirent.h>
 #include <fcntl.h>
+#include <ftw.h>
 #include <pthread.h>
+#include <sys/file.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <lz4.h>
+
+#include <constants.hh>
 #include <xamarin-app.hh>
 #include <host/assembly-store.hh>
+#include <host/assembly-store-profile.hh>
+#include <host/on-demand-decompression.hh>
+#include <host/parallel-decompression.hh>
 #include <runtime-base/android-system.hh>
 #include <runtime-base/crc32.hh>
 #include <runtime-base/util.hh>
@@ -48,28 +63,99 @@ namespace {
 	}
 
 	namespace asm_cache {
-		constexpr std::string_view CACHE_DIR_NAME = "decompressed-assembly-cache-v1"sv;
+		constexpr std::string_view CACHE_DIR_NAME = "decompressed-assembly-cache-v2"sv;
+		constexpr std::string_view LEGACY_CACHE_DIR_NAME = "decompressed-assembly-cache-v1"sv;
+		constexpr std::string_view PACK_FILE_EXTENSION = ".pack"sv;
+		constexpr std::string_view LOCK_FILE_EXTENSION = ".lock"sv;
 		constexpr uint32_t CACHE_FILE_MAGIC = 0x43434158; // 'XACC', little-endian
-		constexpr uint32_t CACHE_FILE_FORMAT_VERSION = 1;
-		constexpr size_t MAX_QUEUED_BYTES = 32uz * 1024uz * 1024uz;
-
-		struct [[gnu::packed]] CacheFileFooter final
+		constexpr uint32_t CACHE_FILE_FORMAT_VERSION = 4;
+		constexpr uint32_t VALIDATION_SAMPLE_INTERVAL = 16;
+		constexpr uint64_t TOC_SLOT_COUNT = 2;
+		constexpr uint64_t BYTES_PER_MB = 1024uz * 1024uz;
+
+		// Evicted entries are punched out of the pack, which frees their storage but not the file
+		// offsets they occupied. Once the (sparse) pack grows this much larger than the size limit, it's
+		// started from scratch.
+		constexpr uint64_t MAX_PACK_SPAN_TO_SIZE_RATIO = 4;
+
+		// Entries of the pack mapped by this process are claimed, with a compare-and-swap from
+		// `ENTRY_AVAILABLE`, either by `try_load` before they're handed to the runtime or by the
+		// evictor before they're removed from the pack. This guarantees that nothing the runtime uses
+		// is ever evicted.
+		constexpr uint8_t ENTRY_AVAILABLE = 0;
+		constexpr uint8_t ENTRY_IN_USE    = 1;
+		constexpr uint8_t ENTRY_EVICTED   = 2;
+
+		//
+		// All the decompressed assemblies of a store are kept in a single pack file, named after the
+		// store ID, so that a hot start needs just one `open` and one `mmap`. The pack starts with two
+		// page-aligned table of contents (TOC) slots, followed by the page-aligned payloads:
+		//
+		//   [TOC slot 0][TOC slot 1][payload][payload]...
+		//
+		// Each slot contains a `PackTocHeader` followed by one `PackTocEntry` per compressed assembly
+		// descriptor. New payloads are only ever appended past `data_end`, after which the updated TOC
+		// is written to the slot not used by the current one, with a higher sequence number. The
+		// reader picks the valid slot with the highest sequence number, so a torn write (e.g. the
+		// process being killed while it's in progress) leaves the previously published TOC intact.
+		//
+		// Assemblies missing from the pack are decompressed straight into a freshly reserved region at
+		// its end, through a shared mapping, and the runtime is given a private (copy-on-write) view
+		// of that region. Publishing the entry is then only a matter of the writer thread hashing the
+		// payload and updating the TOC, no copies of the data are made.
+		//
+		// Every process which maps the pack holds a shared `flock` on it, the right to append to the
+		// pack is granted by an exclusive lock on a separate `<store_id>.pack.lock` file. Evicting
+		// entries additionally requires converting the pack lock to an exclusive one, which fails if
+		// any other process has the pack mapped.
+		//
+		// `file_inode` is set by the writer, which lets the reader validate the pack using just the TOC
+		// and `fstat`, without reading any of the payloads. The modification time of the pack isn't part
+		// of the check: payloads are reserved, decompressed and evicted between the TOC updates, and all
+		// of that changes it. A launch which doesn't get to publish its TOC must leave the previously
+		// published one valid. The contents of the payloads are covered by their `payload_hash`, checked
+		// according to `ValidationMode`.
+		//
+		struct [[gnu::packed]] PackTocHeader final
 		{
 			uint32_t magic;
 			uint32_t version;
 			uint64_t store_id;
+			uint64_t sequence;
+			uint64_t file_inode;
+			uint64_t data_end;
+			uint32_t page_size;
+			uint32_t entry_count;
+			uint32_t toc_hash; // CRC32 of all the preceding fields and of the entries
+		};
+
+		static_assert (sizeof (PackTocHeader) == 52uz);
+
+		struct [[gnu::packed]] PackTocEntry final
+		{
+			uint64_t data_offset; // 0 if the assembly isn't in the pack
 			uint64_t payload_hash;
-			uint32_t descriptor_index;
 			uint32_t payload_size;
+			uint32_t reserved;
 		};
 
-		static_assert (sizeof (CacheFileFooter) == 32uz);
+		static_assert (sizeof (PackTocEntry) == 24uz);
+
+		// How much of a cache entry is checked before it's handed to the runtime. Hashing the payload
+		// touches every page of the entry, defeating the point of mapping it lazily, so by default
+		// only the TOC and the file metadata are checked.
+		enum class ValidationMode
+		{
+			Metadata,
+			Sampled,  // full content check of every VALIDATION_SAMPLE_INTERVAL-th cache hit
+			Full,
+		};
 
-		struct WriteRequest final
+		struct PendingEntry final
 		{
-			std::string                path;
-			std::unique_ptr<uint8_t[]> data;
-			size_t                     size;
+			uint32_t descriptor_index;
+			uint64_t data_offset;
+			uint32_t size;
 		};
 
 		enum class WriteResult
@@ -79,26 +165,71 @@ namespace {
 		};
 
 		std::mutex                        state_lock;
-		std::deque<WriteRequest>          write_queue;
+		std::vector<PendingEntry>         pending_entries;
 		std::string                       cache_dir;
+		std::string                       pack_file_name;
+		std::string                       pack_path;
 		std::unique_ptr<uint8_t*[]>       tracking;
-		size_t                            queued_bytes = 0;
 		uint64_t                          store_id = 0;
-		bool                              initialized = false;
+		std::once_flag                    init_flag;
+#if defined (DEBUG)
+		ValidationMode                    validation_mode = ValidationMode::Full;
+#else
+		ValidationMode                    validation_mode = ValidationMode::Metadata;
+#endif
+		uint32_t                          validation_counter = 0;
 		bool                              enabled = false;
 		bool                              writes_enabled = false;
 		bool                              writer_running = false;
 
+		// The TOC is modified only by the writer thread, which updates the entries of assemblies
+		// which weren't found in the pack and removes the evicted ones. Other threads read an entry
+		// only in `try_load`, after claiming it: the claim orders those reads after whatever the
+		// writer did to the entry before, and an entry claimed by `try_load` can't be claimed, and
+		// thus modified, by the evictor. `try_load` is never called for an assembly again once it
+		// has been decompressed, so updating the entry of such an assembly is safe too.
+		std::unique_ptr<PackTocEntry[]>   toc;
+		std::unique_ptr<uint8_t[]>        entry_states;
+		PackTocHeader                     toc_header {};
+		uint8_t                          *pack_data = nullptr;
+		size_t                            pack_data_size = 0;
+		size_t                            page_size = 0;
+		size_t                            toc_slot_size = 0;
+		int                               pack_fd = -1;
+		int                               lock_fd = -1;
+		bool                              pack_valid = false;
+		bool                              have_writer_role = false;
+		bool                              sweep_pending = false;
+		bool                              sweep_requested = false;
+		uint64_t                          reserved_end = 0;      // end of the last region reserved for a payload
+		uint64_t                          allocated_size = 0;    // storage used by the TOC slots and the payloads
+		uint64_t                          max_size = 0;          // 0 if there's no limit
+		uint64_t                          stale_bytes_removed = 0;
+		uint32_t                          stale_files_removed = 0;
+
 		auto hash_payload (const uint8_t *data, size_t size) noexcept -> uint64_t
 		{
 			return static_cast<uint64_t>(crc32_hash (reinterpret_cast<const char*>(data), size));
 		}
 
-		bool write_fully (int fd, const uint8_t *buf, size_t len) noexcept
+		auto hash_toc (PackTocHeader const& header, const PackTocEntry *entries) noexcept -> uint32_t
+		{
+			hash_t crc = Crc32::update (0xffffffff, reinterpret_cast<const char*>(&header), offsetof (PackTocHeader, toc_hash));
+			crc = Crc32::update (crc, reinterpret_cast<const char*>(entries), sizeof (PackTocEntry) * header.entry_count);
+			return ~crc;
+		}
+
+		[[gnu::always_inline]]
+		auto align_to_page (uint64_t value) noexcept -> uint64_t
+		{
+			return (value + page_size - 1) & ~static_cast<uint64_t>(page_size - 1);
+		}
+
+		bool pwrite_fully (int fd, const uint8_t *buf, size_t len, uint64_t offset) noexcept
 		{
 			size_t off = 0;
 			while (off < len) {
-				ssize_t n = write (fd, buf + off, len - off);
+				ssize_t n = pwrite (fd, buf + off, len - off, static_cast<off_t>(offset + off));
 				if (n < 0) {
 					if (errno == EINTR) {
 						continue;
@@ -119,89 +250,336 @@ namespace {
 			log_debug (LOG_ASSEMBLY, "Decompressed-assembly cache {} failed for '{}': {}"sv, operation, path, std::strerror (error));
 		}
 
-		auto write_cache_file (WriteRequest const& req) noexcept -> WriteResult
+		[[gnu::always_inline]]
+		auto claim_entry (uint32_t descriptor_index, uint8_t new_state) noexcept -> bool
 		{
-			std::string tmp_path = req.path;
-			tmp_path.append (".tmp."sv);
-			tmp_path.append (std::to_string (getpid ()));
+			uint8_t expected = ENTRY_AVAILABLE;
+			return __atomic_compare_exchange_n (&entry_states[descriptor_index], &expected, new_state, false /* weak */, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+		}
 
-			int fd;
+		void report_size () noexcept
+		{
+			if (FastTiming::enabled ()) [[unlikely]] {
+				internal_timing.set_counter (TimingCounterKind::AssemblyCacheSize, __atomic_load_n (&allocated_size, __ATOMIC_RELAXED));
+			}
+		}
+
+		// Acquires the right to append to the pack, starting a new pack if the existing one couldn't be
+		// used. Only one process at a time may write to the pack, should another one (e.g. a second
+		// process of the same application) hold the lock, this process won't write to the cache at
+		// all. Must be called with `state_lock` held.
+		auto acquire_writer_role_locked () noexcept -> bool
+		{
+			std::string lock_path = pack_path;
+			lock_path.append (LOCK_FILE_EXTENSION);
 			do {
-				fd = open (tmp_path.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
-			} while (fd < 0 && errno == EINTR);
-			if (fd < 0) {
-				log_file_error ("temporary-file creation"sv, req.path, errno);
+				lock_fd = open (lock_path.c_str (), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+			} while (lock_fd < 0 && errno == EINTR);
+			if (lock_fd < 0) {
+				log_file_error ("lock file creation"sv, lock_path, errno);
+				return false;
+			}
+
+			if (flock (lock_fd, LOCK_EX | LOCK_NB) != 0) {
+				log_file_error ("pack locking"sv, lock_path, errno);
+				close (lock_fd);
+				lock_fd = -1;
+				return false;
+			}
+
+			if (!pack_valid) {
+				// Never truncate the existing file, another process might still have it mapped
+				unlink (pack_path.c_str ());
+				toc_header = {
+					.magic = CACHE_FILE_MAGIC,
+					.version = CACHE_FILE_FORMAT_VERSION,
+					.store_id = store_id,
+					.sequence = 0,
+					.file_inode = 0,
+					.data_end = TOC_SLOT_COUNT * toc_slot_size,
+					.page_size = static_cast<uint32_t>(page_size),
+					.entry_count = compressed_assembly_count,
+					.toc_hash = 0,
+				};
+				std::fill_n (toc.get (), compressed_assembly_count, PackTocEntry {});
+				allocated_size = toc_header.data_end;
+
+				do {
+					pack_fd = open (pack_path.c_str (), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC | O_NOFOLLOW, 0600);
+				} while (pack_fd < 0 && errno == EINTR);
+				if (pack_fd < 0) {
+					log_file_error ("pack creation"sv, pack_path, errno);
+					close (lock_fd);
+					lock_fd = -1;
+					return false;
+				}
+
+				// Can't fail, nobody else knows about the file yet
+				flock (pack_fd, LOCK_SH);
+				pack_valid = true;
+			}
+
+			have_writer_role = true;
+			reserved_end = toc_header.data_end;
+			return true;
+		}
+
+		// The payload has been written through a shared mapping by the decompressing thread, read it
+		// back from the page cache in order to hash it.
+		auto record_entry (PendingEntry const& entry) noexcept -> WriteResult
+		{
+			void *mapped = mmap (nullptr, entry.size, PROT_READ, MAP_SHARED, pack_fd, static_cast<off_t>(entry.data_offset));
+			if (mapped == MAP_FAILED) {
+				log_file_error ("payload mapping"sv, pack_path, errno);
 				return WriteResult::Failed;
 			}
 
-			bool ok = write_fully (fd, req.data.get (), req.size);
-			int error = ok ? 0 : errno;
-			if (close (fd) != 0 && ok) {
-				ok = false;
-				error = errno;
+			toc[entry.descriptor_index] = {
+				.data_offset = entry.data_offset,
+				.payload_hash = hash_payload (static_cast<uint8_t*>(mapped), entry.size),
+				.payload_size = entry.size,
+				.reserved = 0,
+			};
+			munmap (mapped, entry.size);
+
+			toc_header.data_end = std::max (toc_header.data_end, entry.data_offset + entry.size);
+			return WriteResult::Succeeded;
+		}
+
+		// Makes all the entries appended so far visible to the next launch
+		auto publish_toc () noexcept -> WriteResult
+		{
+			struct stat st {};
+			if (fstat (pack_fd, &st) != 0) {
+				log_file_error ("TOC update"sv, pack_path, errno);
+				return WriteResult::Failed;
 			}
 
-			if (!ok) {
-				log_file_error ("write"sv, req.path, error);
-				unlink (tmp_path.c_str ());
+			// The payloads must hit the storage before the TOC which points to them does
+			if (fdatasync (pack_fd) != 0) {
+				log_file_error ("payload sync"sv, pack_path, errno);
 				return WriteResult::Failed;
 			}
 
-			int rename_result;
-			do {
-				rename_result = rename (tmp_path.c_str (), req.path.c_str ());
-			} while (rename_result != 0 && errno == EINTR);
+			toc_header.sequence++;
+			toc_header.file_inode = static_cast<uint64_t>(st.st_ino);
+			toc_header.toc_hash = hash_toc (toc_header, toc.get ());
 
-			if (rename_result != 0) {
-				error = errno;
-				log_file_error ("publish"sv, req.path, error);
-				unlink (tmp_path.c_str ());
+			uint64_t slot_offset = (toc_header.sequence % TOC_SLOT_COUNT) * toc_slot_size;
+			if (!pwrite_fully (pack_fd, reinterpret_cast<const uint8_t*>(&toc_header), sizeof (toc_header), slot_offset) ||
+			    !pwrite_fully (pack_fd, reinterpret_cast<const uint8_t*>(toc.get ()), sizeof (PackTocEntry) * compressed_assembly_count, slot_offset + sizeof (toc_header))) {
+				log_file_error ("TOC write"sv, pack_path, errno);
 				return WriteResult::Failed;
 			}
 
 			return WriteResult::Succeeded;
 		}
 
-		void clear_write_queue_locked () noexcept
+		// Removes files left behind by the previous versions of the application (each version comes with
+		// a different store ID) and by the earlier layout of the cache.
+		[[gnu::cold]]
+		void remove_stale_generations () noexcept
+		{
+			auto remove_file = [](const char *path, const struct stat *st, int type, [[maybe_unused]] FTW *ftw) -> int {
+				if (type == FTW_F || type == FTW_SL) {
+					if (unlink (path) == 0) {
+						stale_files_removed++;
+						stale_bytes_removed += static_cast<uint64_t>(st->st_blocks) * 512u;
+					}
+				} else {
+					rmdir (path);
+				}
+				return 0;
+			};
+
+			std::string legacy_dir { AndroidSystem::get_app_code_cache_dir () };
+			legacy_dir.append ("/");
+			legacy_dir.append (LEGACY_CACHE_DIR_NAME);
+			nftw (legacy_dir.c_str (), remove_file, 8, FTW_DEPTH | FTW_PHYS);
+
+			DIR *handle = opendir (cache_dir.c_str ());
+			if (handle == nullptr) {
+				return;
+			}
+
+			int dir_fd = dirfd (handle);
+			for (dirent *entry = readdir (handle); entry != nullptr; entry = readdir (handle)) {
+				std::string_view name { entry->d_name };
+				if (name == "."sv || name == ".."sv) {
+					continue;
+				}
+
+				// The current pack and its lock file
+				if (name.starts_with (pack_file_name)) {
+					std::string_view suffix = name.substr (pack_file_name.length ());
+					if (suffix.empty () || suffix == LOCK_FILE_EXTENSION) {
+						continue;
+					}
+				}
+
+				struct stat st {};
+				if (fstatat (dir_fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && !S_ISDIR (st.st_mode) && unlinkat (dir_fd, entry->d_name, 0) == 0) {
+					stale_files_removed++;
+					stale_bytes_removed += static_cast<uint64_t>(st.st_blocks) * 512u;
+				}
+			}
+			closedir (handle);
+		}
+
+		// Brings the pack down to the size limit, evicting the assemblies which weren't loaded during
+		// the startup of the previous launch first, followed by those that were, in reverse load order.
+		// Assemblies already loaded by this process are never evicted.
+		[[gnu::cold]]
+		auto evict_entries () noexcept -> WriteResult
 		{
-			for (WriteRequest const& request : write_queue) {
-				queued_bytes -= request.size;
+			if (pack_data == nullptr || max_size == 0) {
+				return WriteResult::Succeeded;
+			}
+
+			{
+				std::lock_guard lock (state_lock);
+				if (allocated_size <= max_size || !writes_enabled) {
+					return WriteResult::Succeeded;
+				}
+
+				// Some other process is writing to the pack, it will take care of the eviction
+				if (!have_writer_role && !acquire_writer_role_locked ()) {
+					writes_enabled = false;
+					return WriteResult::Succeeded;
+				}
+			}
+
+			// Punching holes in a pack which another process has mapped could corrupt the assemblies
+			// it loaded from it.
+			if (flock (pack_fd, LOCK_EX | LOCK_NB) != 0) {
+				log_debug (LOG_ASSEMBLY, "Not evicting decompressed-assembly cache entries, the pack is in use by another process"sv);
+				return WriteResult::Succeeded;
+			}
+
+			auto load_position = std::make_unique<uint32_t[]> (compressed_assembly_count);
+			std::fill_n (load_position.get (), compressed_assembly_count, UINT32_MAX);
+
+			std::span<const uint32_t> profile = AssemblyStoreProfile::get_predicted_load_order ();
+			for (uint32_t position = 0; position < profile.size (); position++) {
+				if (profile[position] >= assembly_store.assembly_count) {
+					continue;
+				}
+
+				AssemblyStoreEntryDescriptor const& store_entry = assembly_store.assemblies[profile[position]];
+				if (store_entry.data_size < sizeof (CompressedAssemblyHeader)) {
+					continue;
+				}
+
+				auto header = reinterpret_cast<const CompressedAssemblyHeader*>(assembly_store.data_start + store_entry.data_offset);
+				bool compressed = header->magic == COMPRESSED_DATA_MAGIC;
+				if (compressed && header->descriptor_index < compressed_assembly_count) {
+					load_position[header->descriptor_index] = position;
+				}
+			}
+
+			std::vector<uint32_t> candidates;
+			for (uint32_t i = 0; i < compressed_assembly_count; i++) {
+				if (toc[i].data_offset != 0) {
+					candidates.push_back (i);
+				}
+			}
+
+			// Not loaded during startup (`UINT32_MAX`) first, then in reverse load order. The larger
+			// entries go first among those never loaded, so that fewer of them need to be evicted.
+			std::sort (
+				candidates.begin (),
+				candidates.end (),
+				[&load_position](uint32_t a, uint32_t b) -> bool {
+					if (load_position[a] != load_position[b]) {
+						return load_position[a] > load_position[b];
+					}
+					return toc[a].payload_size > toc[b].payload_size;
+				}
+			);
+
+			uint32_t evicted = 0;
+			for (uint32_t descriptor_index : candidates) {
+				if (__atomic_load_n (&allocated_size, __ATOMIC_RELAXED) <= max_size) {
+					break;
+				}
+
+				if (!claim_entry (descriptor_index, ENTRY_EVICTED)) {
+					continue;
+				}
+
+				PackTocEntry const& entry = toc[descriptor_index];
+				uint64_t region_size = align_to_page (entry.payload_size);
+				if (fallocate (pack_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(entry.data_offset), static_cast<off_t>(region_size)) != 0) {
+					log_file_error ("eviction"sv, pack_path, errno);
+				}
+				toc[descriptor_index] = {};
+				evicted++;
+
+				std::lock_guard lock (state_lock);
+				allocated_size -= region_size;
+			}
+
+			// Downgrade, so that other processes may map the pack again
+			flock (pack_fd, LOCK_SH);
+
+			if (FastTiming::enabled ()) [[unlikely]] {
+				internal_timing.increment_counter (TimingCounterKind::AssemblyCacheEvictions, evicted);
 			}
-			write_queue.clear ();
+			log_debug (LOG_ASSEMBLY, "Evicted {} decompressed-assembly cache entries, {} bytes of {} allowed in use"sv, evicted, __atomic_load_n (&allocated_size, __ATOMIC_RELAXED), max_size);
+
+			return evicted > 0 ? publish_toc () : WriteResult::Succeeded;
 		}
 
 		[[gnu::cold]]
 		auto writer_loop ([[maybe_unused]] void *arg) noexcept -> void*
 		{
-			while (true) {
-				WriteRequest request;
+			WriteResult write_result = WriteResult::Succeeded;
+
+			// Whatever was decompressed while the previous batch was being published is published as a
+			// single batch, with a single TOC update.
+			while (write_result == WriteResult::Succeeded) {
+				std::vector<PendingEntry> batch;
+				bool sweep;
 				{
 					std::lock_guard lock (state_lock);
-					if (write_queue.empty ()) {
+					if (pending_entries.empty () && !sweep_pending) {
 						writer_running = false;
 						return nullptr;
 					}
 
-					request = std::move (write_queue.front ());
-					write_queue.pop_front ();
+					batch.swap (pending_entries);
+					sweep = sweep_pending;
+					sweep_pending = false;
 				}
 
-				size_t request_size = request.size;
-				WriteResult write_result = write_cache_file (request);
-				request.data.reset ();
-
-				{
-					std::lock_guard lock (state_lock);
-					queued_bytes -= request_size;
+				for (PendingEntry const& entry : batch) {
+					write_result = record_entry (entry);
 					if (write_result == WriteResult::Failed) {
-						writes_enabled = false;
-						clear_write_queue_locked ();
-						writer_running = false;
-						log_debug (LOG_ASSEMBLY, "Disabling decompressed-assembly cache writes after a persistence failure"sv);
-						return nullptr;
+						break;
+					}
+				}
+
+				if (write_result == WriteResult::Succeeded && !batch.empty ()) {
+					write_result = publish_toc ();
+				}
+
+				// Cleans up after the previous launches, requested by `request_sweep` once startup is done
+				if (write_result == WriteResult::Succeeded && sweep) {
+					remove_stale_generations ();
+					write_result = evict_entries ();
+					if (stale_files_removed > 0) {
+						log_debug (LOG_ASSEMBLY, "Removed {} stale decompressed-assembly cache files, {} bytes"sv, stale_files_removed, stale_bytes_removed);
 					}
 				}
+				report_size ();
 			}
+
+			std::lock_guard lock (state_lock);
+			writes_enabled = false;
+			pending_entries.clear ();
+			writer_running = false;
+			log_debug (LOG_ASSEMBLY, "Disabling decompressed-assembly cache writes after a persistence failure"sv);
+			return nullptr;
 		}
 
 		bool start_writer_locked () noexcept
@@ -229,6 +607,20 @@ namespace {
 			return true;
 		}
 
+		[[gnu::always_inline]]
+		void start_writer_if_needed_locked () noexcept
+		{
+			if (writer_running) {
+				return;
+			}
+
+			writer_running = start_writer_locked ();
+			if (!writer_running) {
+				writes_enabled = false;
+				pending_entries.clear ();
+			}
+		}
+
 		bool ensure_directory (std::string const& path) noexcept
 		{
 			if (mkdir (path.c_str (), 0700) == 0) {
@@ -254,39 +646,112 @@ namespace {
 			return true;
 		}
 
-		// Best-effort removal of staging files left behind by a previous process whose writer was
-		// killed (e.g. by Android) between creating a `.tmp.<pid>` file and renaming it into place.
-		// Such files are never reclaimed otherwise and would accumulate outside the queue bound.
-		void remove_stale_temp_files (std::string const& dir) noexcept
+		auto find_valid_toc_slot (const uint8_t *data, size_t size, struct stat const& st) noexcept -> const uint8_t*
 		{
-			DIR *handle = opendir (dir.c_str ());
-			if (handle == nullptr) {
-				return;
-			}
+			const uint8_t *best = nullptr;
+			uint64_t best_sequence = 0;
+
+			for (uint64_t slot = 0; slot < TOC_SLOT_COUNT; slot++) {
+				const uint8_t *slot_data = data + slot * toc_slot_size;
+				PackTocHeader header {};
+				memcpy (&header, slot_data, sizeof (header));
+
+				if (header.magic != CACHE_FILE_MAGIC ||
+				    header.version != CACHE_FILE_FORMAT_VERSION ||
+				    header.store_id != store_id ||
+				    header.page_size != page_size ||
+				    header.entry_count != compressed_assembly_count ||
+				    header.sequence % TOC_SLOT_COUNT != slot ||
+				    header.sequence <= best_sequence ||
+				    header.file_inode != static_cast<uint64_t>(st.st_ino) ||
+				    header.data_end < TOC_SLOT_COUNT * toc_slot_size ||
+				    header.data_end > size) {
+					continue;
+				}
 
-			std::string prefix = dir;
-			prefix.append ("/");
-			for (dirent *entry = readdir (handle); entry != nullptr; entry = readdir (handle)) {
-				std::string_view name { entry->d_name };
-				if (name.find (".tmp."sv) == std::string_view::npos) {
+				// The entries are only read from the mapping if the header is valid, so a rejected slot
+				// doesn't cost more than the page holding its header.
+				auto entries = reinterpret_cast<const PackTocEntry*>(slot_data + sizeof (PackTocHeader));
+				if (hash_toc (header, entries) != header.toc_hash) {
 					continue;
 				}
 
-				std::string path = prefix;
-				path.append (name);
-				unlink (path.c_str ());
+				best = slot_data;
+				best_sequence = header.sequence;
 			}
 
-			closedir (handle);
+			return best;
 		}
 
-		void ensure_initialized (uint64_t assembly_store_id) noexcept
+		// Maps the pack published by a previous launch, if there's one and it's valid
+		void load_pack () noexcept
 		{
-			if (initialized) {
+			int fd;
+			do {
+				fd = open (pack_path.c_str (), O_RDWR | O_CLOEXEC | O_NOFOLLOW);
+			} while (fd < 0 && errno == EINTR);
+			if (fd < 0) {
+				return;
+			}
+
+			// Fails only while another process evicts entries from the pack
+			if (flock (fd, LOCK_SH | LOCK_NB) != 0) {
+				log_file_error ("pack locking"sv, pack_path, errno);
+				close (fd);
+				return;
+			}
+
+			struct stat st {};
+			if (fstat (fd, &st) != 0 || !S_ISREG (st.st_mode) || static_cast<uint64_t>(st.st_size) < TOC_SLOT_COUNT * toc_slot_size) {
+				close (fd);
+				return;
+			}
+
+			auto size = static_cast<size_t>(st.st_size);
+			// The runtime may modify the images, so keep those changes private while retaining clean
+			// file-backed pages until they are actually written.
+			void *mapped = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (mapped == MAP_FAILED) {
+				log_file_error ("mapping"sv, pack_path, errno);
+				close (fd);
+				return;
+			}
+
+			auto data = static_cast<uint8_t*>(mapped);
+			const uint8_t *slot_data = find_valid_toc_slot (data, size, st);
+			if (slot_data == nullptr) {
+				munmap (mapped, size);
+				close (fd);
+				log_debug (LOG_ASSEMBLY, "Ignoring invalid decompressed-assembly cache pack '{}'"sv, pack_path);
+				return;
+			}
+
+			PackTocHeader header {};
+			memcpy (&header, slot_data, sizeof (header));
+			if (max_size > 0 && header.data_end > MAX_PACK_SPAN_TO_SIZE_RATIO * max_size) {
+				munmap (mapped, size);
+				close (fd);
+				log_debug (LOG_ASSEMBLY, "Starting a new decompressed-assembly cache pack, '{}' is too fragmented"sv, pack_path);
 				return;
 			}
-			initialized = true;
 
+			toc_header = header;
+			memcpy (toc.get (), slot_data + sizeof (PackTocHeader), sizeof (PackTocEntry) * compressed_assembly_count);
+			allocated_size = TOC_SLOT_COUNT * toc_slot_size;
+			for (uint32_t i = 0; i < compressed_assembly_count; i++) {
+				if (toc[i].data_offset != 0) {
+					allocated_size += align_to_page (toc[i].payload_size);
+				}
+			}
+
+			pack_fd = fd;
+			pack_data = data;
+			pack_data_size = static_cast<size_t>(toc_header.data_end);
+			pack_valid = true;
+		}
+
+		void initialize (uint64_t assembly_store_id) noexcept
+		{
 			bool cache_requested = application_config.assembly_store_decompression_cache_enabled;
 
 			// Allow overriding the build setting at runtime for A/B benchmarking:
@@ -297,7 +762,7 @@ namespace {
 			}
 			{
 				dynamic_local_property_string prop_value;
-				if (AndroidSystem::monodroid_get_system_property ("debug.net.asmcache"sv, prop_value) > 0 && prop_value.get () != nullptr) {
+				if (AndroidSystem::monodroid_get_system_property (Constants::DEBUG_NET_ASMCACHE_PROPERTY, prop_value) > 0 && prop_value.get () != nullptr) {
 					if (prop_value.get ()[0] == '0') {
 						cache_requested = false;
 					} else if (prop_value.get ()[0] == '1') {
@@ -306,61 +771,128 @@ namespace {
 				}
 			}
 
-			if (!cache_requested) {
+			if (!cache_requested || compressed_assembly_count == 0) {
 				return;
 			}
 
+			// Cache entry validation can be tightened (or relaxed, in Debug builds) the same way:
+			//   adb shell setprop debug.net.asmcache.verify metadata
+			//   adb shell setprop debug.net.asmcache.verify sampled
+			//   adb shell setprop debug.net.asmcache.verify full
+			{
+				dynamic_local_property_string prop_value;
+				if (AndroidSystem::monodroid_get_system_property (Constants::DEBUG_NET_ASMCACHE_VERIFY_PROPERTY, prop_value) > 0 && prop_value.get () != nullptr) {
+					std::string_view mode { prop_value.get () };
+					if (mode == "metadata"sv) {
+						validation_mode = ValidationMode::Metadata;
+					} else if (mode == "sampled"sv) {
+						validation_mode = ValidationMode::Sampled;
+					} else if (mode == "full"sv) {
+						validation_mode = ValidationMode::Full;
+					}
+				}
+			}
+
 			std::string const& code_cache_dir = AndroidSystem::get_app_code_cache_dir ();
 			if (code_cache_dir.empty ()) {
 				return;
 			}
 
-			cache_dir.assign (code_cache_dir);
-			cache_dir.append ("/");
-			cache_dir.append (CACHE_DIR_NAME);
-			if (!ensure_directory (cache_dir)) {
+			long sc_page_size = sysconf (_SC_PAGESIZE);
+			if (sc_page_size <= 0) {
 				return;
 			}
+			page_size = static_cast<size_t>(sc_page_size);
+			toc_slot_size = static_cast<size_t>(align_to_page (sizeof (PackTocHeader) + sizeof (PackTocEntry) * compressed_assembly_count));
 
-			store_id = assembly_store_id;
+			// As well as its size limit, in megabytes (0 for no limit):
+			//   adb shell setprop debug.net.asmcache.maxsize 64
+			max_size = static_cast<uint64_t>(application_config.assembly_store_decompression_cache_max_size_mb) * BYTES_PER_MB;
+			{
+				dynamic_local_property_string prop_value;
+				if (AndroidSystem::monodroid_get_system_property (Constants::DEBUG_NET_ASMCACHE_MAXSIZE_PROPERTY, prop_value) > 0 && prop_value.get () != nullptr) {
+					char *end = nullptr;
+					unsigned long long value = strtoull (prop_value.get (), &end, 10);
+					if (end != prop_value.get () && *end == '\0') {
+						max_size = static_cast<uint64_t>(value) * BYTES_PER_MB;
+					}
+				}
+			}
+
+			cache_dir.assign (code_cache_dir);
 			cache_dir.append ("/");
-			cache_dir.append (std::format ("{:x}", store_id));
+			cache_dir.append (CACHE_DIR_NAME);
 			if (!ensure_directory (cache_dir)) {
 				return;
 			}
 
-			remove_stale_temp_files (cache_dir);
-
-			if (compressed_assembly_count > 0) {
-				tracking.reset (new (std::nothrow) uint8_t*[compressed_assembly_count]());
-			}
-
-			enabled = (tracking != nullptr);
+			store_id = assembly_store_id;
+			pack_file_name = std::format ("{:x}", store_id);
+			pack_file_name.append (PACK_FILE_EXTENSION);
+			pack_path.assign (cache_dir);
+			pack_path.append ("/");
+			pack_path.append (pack_file_name);
+
+			toc.reset (new (std::nothrow) PackTocEntry[compressed_assembly_count]());
+			tracking.reset (new (std::nothrow) uint8_t*[compressed_assembly_count]());
+			entry_states.reset (new (std::nothrow) uint8_t[compressed_assembly_count]());
+			enabled = toc != nullptr && tracking != nullptr && entry_states != nullptr;
 			if (!enabled) {
 				return;
 			}
 
+			load_pack ();
+
 			{
 				std::lock_guard lock (state_lock);
 				writes_enabled = true;
+
+				// Startup was over before the first assembly was decompressed
+				if (sweep_requested) {
+					sweep_pending = true;
+					start_writer_if_needed_locked ();
+				}
 			}
 
 			log_debug (
 				LOG_ASSEMBLY,
-				"Enabled decompressed-assembly cache at '{}'; store ID 0x{:x}; write queue limit {} bytes"sv,
-				cache_dir,
+				"Enabled decompressed-assembly cache at '{}'; store ID 0x{:x}; {} pack bytes mapped; {} bytes in use, {} allowed; {} entry validation"sv,
+				pack_path,
 				store_id,
-				MAX_QUEUED_BYTES
+				pack_data_size,
+				allocated_size,
+				max_size,
+				validation_mode == ValidationMode::Full ? "full"sv : (validation_mode == ValidationMode::Sampled ? "sampled"sv : "metadata"sv)
 			);
 		}
 
-		auto build_path (uint32_t descriptor_index) noexcept -> std::string
+		// Assemblies may be decompressed by several threads at once, each holding only the lock of
+		// the assembly it works on.
+		void ensure_initialized (uint64_t assembly_store_id) noexcept
+		{
+			std::call_once (init_flag, initialize, assembly_store_id);
+		}
+
+		auto should_verify_content () noexcept -> bool
+		{
+			switch (validation_mode) {
+				case ValidationMode::Full:
+					return true;
+
+				case ValidationMode::Sampled:
+					return __atomic_fetch_add (&validation_counter, 1u, __ATOMIC_RELAXED) % VALIDATION_SAMPLE_INTERVAL == 0;
+
+				default:
+					return false;
+			}
+		}
+
+		[[gnu::always_inline]]
+		void count_lookup (TimingCounterKind kind) noexcept
 		{
-			std::string path = cache_dir;
-			path.append ("/");
-			path.append (std::to_string (descriptor_index));
-			path.append (".bin"sv);
-			return path;
+			if (FastTiming::enabled ()) [[unlikely]] {
+				internal_timing.increment_counter (kind);
+			}
 		}
 
 		auto try_load (uint32_t descriptor_index, std::string_view name, uint32_t expected_size) noexcept -> uint8_t*
@@ -369,137 +901,315 @@ namespace {
 				return nullptr;
 			}
 
-			std::string path = build_path (descriptor_index);
-			int fd = open (path.c_str (), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
-			if (fd < 0) {
+			if (pack_data == nullptr) {
+				count_lookup (TimingCounterKind::AssemblyCacheMisses);
 				return nullptr;
 			}
 
-			struct stat st {};
-			if (fstat (fd, &st) != 0 ||
-			    !S_ISREG (st.st_mode) ||
-			    static_cast<uint64_t>(st.st_size) != static_cast<uint64_t>(expected_size) + sizeof (CacheFileFooter)) {
-				close (fd);
+			// Lost the race against the evictor, the entry is gone. The entry mustn't be read before it's
+			// claimed, see the comment on `toc`.
+			if (!claim_entry (descriptor_index, ENTRY_IN_USE)) {
+				count_lookup (TimingCounterKind::AssemblyCacheMisses);
 				return nullptr;
 			}
 
-			size_t map_size = static_cast<size_t>(expected_size) + sizeof (CacheFileFooter);
-			// The runtime may modify the image, so keep those changes private while
-			// retaining clean file-backed pages until they are actually written.
-			void *mapped = mmap (nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
-			close (fd);
-			if (mapped == MAP_FAILED) {
+			PackTocEntry const& entry = toc[descriptor_index];
+			if (entry.data_offset == 0 ||
+			    entry.payload_size != expected_size ||
+			    entry.data_offset > pack_data_size ||
+			    expected_size > pack_data_size - entry.data_offset) {
+				count_lookup (TimingCounterKind::AssemblyCacheMisses);
 				return nullptr;
 			}
 
-			CacheFileFooter footer {};
-			memcpy (&footer, static_cast<uint8_t*>(mapped) + expected_size, sizeof (footer));
-			if (footer.magic != CACHE_FILE_MAGIC ||
-			    footer.version != CACHE_FILE_FORMAT_VERSION ||
-			    footer.store_id != store_id ||
-			    footer.descriptor_index != descriptor_index ||
-			    footer.payload_size != expected_size ||
-			    footer.payload_hash != hash_payload (static_cast<uint8_t*>(mapped), expected_size)) {
-				munmap (mapped, map_size);
+			if (should_verify_content () && entry.payload_hash != hash_payload (pack_data + entry.data_offset, expected_size)) {
 				log_debug (LOG_ASSEMBLY, "Ignoring invalid decompressed-assembly cache entry for '{}'"sv, name);
+				count_lookup (TimingCounterKind::AssemblyCacheMisses);
 				return nullptr;
 			}
 
-			return static_cast<uint8_t*>(mapped);
+			count_lookup (TimingCounterKind::AssemblyCacheHits);
+			return pack_data + entry.data_offset;
 		}
 
-		void enqueue_write (uint32_t descriptor_index, std::string_view name, const uint8_t *data, size_t size) noexcept
+		// Reserves a page-aligned region for the assembly at the end of the pack and returns a shared,
+		// writable mapping of it, to decompress the assembly into. Blocks are allocated for the region
+		// right away, as a write to a mapped hole on a full file system would raise `SIGBUS`. Returns
+		// `nullptr` if the assembly can't be written to the cache.
+		auto reserve_entry (std::string_view name, uint32_t size) noexcept -> std::tuple<uint8_t*, uint64_t>
 		{
-			if (!enabled) {
-				return;
-			}
-
-			if (size > SIZE_MAX - sizeof (CacheFileFooter)) {
-				return;
+			if (!enabled || size == 0) {
+				return {nullptr, 0};
 			}
-			size_t total = size + sizeof (CacheFileFooter);
 
-			size_t bytes_queued = 0;
-			bool queue_full = false;
+			uint64_t data_offset;
 			{
 				std::lock_guard lock (state_lock);
 				if (!writes_enabled) {
-					return;
+					return {nullptr, 0};
 				}
-				if (total > MAX_QUEUED_BYTES || queued_bytes > MAX_QUEUED_BYTES - total) {
-					queue_full = true;
-					bytes_queued = queued_bytes;
-				} else {
-					queued_bytes += total;
+
+				if (!have_writer_role && !acquire_writer_role_locked ()) {
+					writes_enabled = false;
+					return {nullptr, 0};
 				}
-			}
 
-			if (queue_full) {
-				if (total > MAX_QUEUED_BYTES) {
-					log_debug (
-						LOG_ASSEMBLY,
-						"Skipping decompressed-assembly cache write for '{}': {} bytes exceed the {}-byte queue limit"sv,
-						name,
-						total,
-						MAX_QUEUED_BYTES
-					);
-				} else {
-					log_debug (
-						LOG_ASSEMBLY,
-						"Skipping decompressed-assembly cache write for '{}': {} of {} queue bytes are in use"sv,
-						name,
-						bytes_queued,
-						MAX_QUEUED_BYTES
-					);
+				data_offset = align_to_page (reserved_end);
+				uint64_t region_size = align_to_page (size);
+				if (max_size > 0 && (allocated_size + region_size > max_size || data_offset + region_size > MAX_PACK_SPAN_TO_SIZE_RATIO * max_size)) {
+					log_debug (LOG_ASSEMBLY, "Not caching decompressed assembly '{}': the cache is full"sv, name);
+					return {nullptr, 0};
 				}
-				return;
+
+				reserved_end = data_offset + size;
+				allocated_size += region_size;
 			}
 
-			auto snapshot = std::unique_ptr<uint8_t[]> (new (std::nothrow) uint8_t[total]);
-			if (snapshot == nullptr) {
-				std::lock_guard lock (state_lock);
-				queued_bytes -= total;
-				return;
+			// Regions don't overlap, so they can be allocated and mapped without holding the lock. The
+			// reserved space is simply wasted if anything fails from here on.
+			int result;
+			do {
+				result = fallocate (pack_fd, 0, static_cast<off_t>(data_offset), static_cast<off_t>(size));
+			} while (result != 0 && errno == EINTR);
+			if (result != 0) {
+				log_debug (LOG_ASSEMBLY, "Not caching decompressed assembly '{}': space allocation failed: {}"sv, name, std::strerror (errno));
+				return {nullptr, 0};
 			}
-			// The runtime can modify the shared decompression buffer after this
-			// method returns, so the background writer needs an immutable copy.
-			memcpy (snapshot.get (), data, size);
-
-			CacheFileFooter footer {
-				.magic = CACHE_FILE_MAGIC,
-				.version = CACHE_FILE_FORMAT_VERSION,
-				.store_id = store_id,
-				.payload_hash = hash_payload (snapshot.get (), size),
-				.descriptor_index = descriptor_index,
-				.payload_size = static_cast<uint32_t>(size),
-			};
-			memcpy (snapshot.get () + size, &footer, sizeof (footer));
 
-			WriteRequest req {
-				.path = build_path (descriptor_index),
-				.data = std::move (snapshot),
-				.size = total,
-			};
+			void *area = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, pack_fd, static_cast<off_t>(data_offset));
+			if (area == MAP_FAILED) {
+				log_debug (LOG_ASSEMBLY, "Not caching decompressed assembly '{}': mapping failed: {}"sv, name, std::strerror (errno));
+				return {nullptr, 0};
+			}
 
-			{
-				std::lock_guard lock (state_lock);
-				if (!writes_enabled) {
-					queued_bytes -= total;
-					return;
-				}
+			return {static_cast<uint8_t*>(area), data_offset};
+		}
 
-				write_queue.push_back (std::move (req));
-				if (!writer_running) {
-					writer_running = true;
-					if (!start_writer_locked ()) {
-						writer_running = false;
-						writes_enabled = false;
-						clear_write_queue_locked ();
-					}
-				}
+		// Called once the assembly has been decompressed into the area returned by `reserve_entry`.
+		// Returns the data to hand over to the runtime: a private view of the region or, should that
+		// fail, `fallback_buffer` with a copy of the data. The entry is published by the writer thread.
+		auto commit_entry (uint32_t descriptor_index, uint8_t *area, uint64_t data_offset, uint32_t size, uint8_t *fallback_buffer) noexcept -> uint8_t*
+		{
+			// The runtime gets this view of the region, it must never be evicted while we run
+			__atomic_store_n (&entry_states[descriptor_index], ENTRY_IN_USE, __ATOMIC_RELEASE);
+
+			uint8_t *data = fallback_buffer;
+			void *view = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, pack_fd, static_cast<off_t>(data_offset));
+			if (view != MAP_FAILED) [[likely]] {
+				data = static_cast<uint8_t*>(view);
+			} else {
+				log_debug (LOG_ASSEMBLY, "Failed to map decompressed assembly copy-on-write: {}"sv, std::strerror (errno));
+				memcpy (fallback_buffer, area, size);
 			}
+			munmap (area, size);
+
+			std::lock_guard lock (state_lock);
+			if (!writes_enabled) {
+				return data;
+			}
+
+			pending_entries.push_back ({ .descriptor_index = descriptor_index, .data_offset = data_offset, .size = size });
+			start_writer_if_needed_locked ();
+
+			return data;
+		}
+
+		// Stale generations are removed, and the pack trimmed to size, by the writer thread once startup
+		// is done, so that neither competes with the startup for the storage. Until then, `reserve_entry`
+		// refuses to grow the pack past the size limit.
+		void request_sweep () noexcept
+		{
+			std::lock_guard lock (state_lock);
+			sweep_requested = true;
+			if (!writes_enabled) {
+				// Either the cache hasn't been initialized yet, in which case `initialize` starts the sweep,
+				// or it can't be written to
+				return;
+			}
+
+			sweep_pending = true;
+			start_writer_if_needed_locked ();
 		}
 	} // namespace asm_cache
+
+	// Uncompressed assemblies must be handed to the runtime in a writable memory area (see the note in
+	// `AssemblyStore::get_assembly_data`). Instead of copying each image to the heap, we map it again
+	// from the file backing the store (the store DSO or, in embedded mode, the APK it's stored in)
+	// as a private, copy-on-write view, so that only the pages the runtime actually writes to are
+	// duplicated.
+	namespace cow_images {
+		struct MappedImage final
+		{
+			uint8_t *area;
+			size_t   area_size;
+		};
+
+		std::once_flag              init_flag;
+		int                         store_fd = -1;
+		uintptr_t                   region_start = 0;
+		uintptr_t                   region_end = 0;
+		uint64_t                    region_file_offset = 0;
+		size_t                      page_size = 0;
+		std::mutex                  images_lock;
+		std::unique_ptr<MappedImage[]> images;
+
+		// Finds the file mapping which contains the store payload and opens the file it came from
+		void locate_backing_file (const uint8_t *payload, uint32_t assembly_count) noexcept
+		{
+			long sc_page_size = sysconf (_SC_PAGESIZE);
+			if (sc_page_size <= 0) {
+				return;
+			}
+			page_size = static_cast<size_t>(sc_page_size);
+
+			FILE *maps = fopen ("/proc/self/maps", "re");
+			if (maps == nullptr) {
+				return;
+			}
+
+			auto payload_address = reinterpret_cast<uintptr_t>(payload);
+			std::string path;
+			char line[PATH_MAX + 128];
+			while (fgets (line, sizeof (line), maps) != nullptr) {
+				unsigned long start;
+				unsigned long end;
+				unsigned long long offset;
+				int path_start = 0;
+
+				if (sscanf (line, "%lx-%lx %*s %llx %*s %*s %n", &start, &end, &offset, &path_start) < 3 || path_start == 0) {
+					continue;
+				}
+
+				if (payload_address < start || payload_address >= end) {
+					continue;
+				}
+
+				std::string_view file_path { line + path_start };
+				while (!file_path.empty () && (file_path.back () == '\n' || file_path.back () == ' ')) {
+					file_path.remove_suffix (1);
+				}
+
+				// Anonymous mappings, or ones named by the kernel/linker (e.g. `[anon:...]`), can't be re-mapped
+				if (file_path.empty () || file_path[0] != '/') {
+					break;
+				}
+
+				path.assign (file_path);
+				region_start = start;
+				region_end = end;
+				region_file_offset = offset;
+				break;
+			}
+			fclose (maps);
+
+			if (path.empty ()) {
+				log_debug (LOG_ASSEMBLY, "Assembly store payload isn't backed by a file, uncompressed assemblies will be copied"sv);
+				return;
+			}
+
+			images.reset (new (std::nothrow) MappedImage[assembly_count]());
+			if (images == nullptr) {
+				return;
+			}
+
+			store_fd = open (path.c_str (), O_RDONLY | O_CLOEXEC);
+			if (store_fd < 0) {
+				log_debug (LOG_ASSEMBLY, "Failed to open assembly store backing file '{}': {}"sv, path, std::strerror (errno));
+				images.reset ();
+				return;
+			}
+
+			log_debug (LOG_ASSEMBLY, "Uncompressed assemblies will be mapped copy-on-write from '{}'"sv, path);
+		}
+
+		auto map_image (uint32_t descriptor_index, const uint8_t *image, size_t size) noexcept -> uint8_t*
+		{
+			auto image_start = reinterpret_cast<uintptr_t>(image);
+			if (store_fd < 0 || size == 0 || image_start < region_start || size > region_end - image_start) {
+				return nullptr;
+			}
+
+			uint64_t file_offset = region_file_offset + (image_start - region_start);
+			uint64_t aligned_offset = file_offset & ~static_cast<uint64_t>(page_size - 1);
+			size_t delta = static_cast<size_t>(file_offset - aligned_offset);
+			size_t area_size = size + delta;
+
+			void *area = mmap (nullptr, area_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, store_fd, static_cast<off_t>(aligned_offset));
+			if (area == MAP_FAILED) {
+				log_debug (LOG_ASSEMBLY, "Failed to map assembly image copy-on-write: {}"sv, std::strerror (errno));
+				return nullptr;
+			}
+
+			uint8_t *mapped_image = static_cast<uint8_t*>(area) + delta;
+
+			// Paranoia: make sure the file hasn't been replaced under our feet since it was mapped by the
+			// dynamic linker. The first page is going to be read by the runtime right away anyway.
+			if (memcmp (mapped_image, image, std::min (size, page_size)) != 0) [[unlikely]] {
+				munmap (area, area_size);
+				log_debug (LOG_ASSEMBLY, "Assembly store backing file contents differ from the mapped store, disabling copy-on-write mappings"sv);
+				return nullptr;
+			}
+
+			{
+				// Only the first mapping of a given assembly is tracked for the statistics
+				std::lock_guard lock (images_lock);
+				if (images[descriptor_index].area == nullptr) {
+					images[descriptor_index] = { static_cast<uint8_t*>(area), area_size };
+				}
+			}
+			return mapped_image;
+		}
+
+		// Counts pages of the mapping which are no longer backed by the file, that is pages which
+		// the runtime wrote to and thus got copied.
+		auto count_dirty_pages (int pagemap_fd, MappedImage const& image, size_t &total_pages) noexcept -> size_t
+		{
+			constexpr uint64_t PAGE_PRESENT     = 1ull << 63;
+			constexpr uint64_t PAGE_SWAPPED     = 1ull << 62;
+			constexpr uint64_t PAGE_FILE_SHARED = 1ull << 61;
+			constexpr size_t   BATCH_SIZE       = 64uz;
+
+			uintptr_t first_page = reinterpret_cast<uintptr_t>(image.area) / page_size;
+			total_pages = (image.area_size + page_size - 1) / page_size;
+
+			size_t dirty = 0;
+			uint64_t entries[BATCH_SIZE];
+			for (size_t done = 0; done < total_pages;) {
+				size_t count = std::min (BATCH_SIZE, total_pages - done);
+				auto offset = static_cast<off_t>((first_page + done) * sizeof (uint64_t));
+				ssize_t nread = pread (pagemap_fd, entries, count * sizeof (uint64_t), offset);
+				if (nread <= 0) {
+					break;
+				}
+
+				size_t nentries = static_cast<size_t>(nread) / sizeof (uint64_t);
+				for (size_t i = 0; i < nentries; i++) {
+					if ((entries[i] & (PAGE_PRESENT | PAGE_SWAPPED)) != 0 && (entries[i] & PAGE_FILE_SHARED) == 0) {
+						dirty++;
+					}
+				}
+				done += nentries;
+			}
+
+			return dirty;
+		}
+	} // namespace cow_images
+
+	// `ZSTD_decompress` allocates (and frees) a fresh decompression context on each call. Instead, every
+	// thread which decompresses assemblies keeps its own context for as long as it lives.
+	struct ThreadDecompressionContext final
+	{
+		ZSTD_DCtx *dctx = nullptr;
+
+		~ThreadDecompressionContext () noexcept
+		{
+			if (dctx != nullptr) {
+				ZSTD_freeDCtx (dctx);
+			}
+		}
+	};
+
+	thread_local ThreadDecompressionContext thread_decompression_context;
 } // anonymous namespace
 [[gnu::always_inline]]
 void AssemblyStore::set_assembly_data_and_size (uint8_t* source_assembly_data, uint32_t source_assembly_data_size, uint8_t*& dest_assembly_data, uint32_t& dest_assembly_data_size) noexcept
@@ -508,165 +1218,502 @@ void AssemblyStore::set_assembly_data_and_size (uint8_t* source_assembly_data, u
 	dest_assembly_data_size = source_assembly_data_size;
 }
 
+#if defined (RELEASE)
 [[gnu::always_inline]]
-auto AssemblyStore::get_assembly_data (AssemblyStoreSingleAssemblyRuntimeData const& e, std::string_view const& name) noexcept -> std::tuple<uint8_t*, uint32_t>
+void AssemblyStore::lock_decompression (std::unique_lock<std::mutex> &lock) noexcept
 {
-	uint8_t *assembly_data = nullptr;
-	uint32_t assembly_data_size = 0;
+	if (lock.try_lock ()) [[likely]] {
+		return;
+	}
 
-#if defined (RELEASE)
-	auto header = reinterpret_cast<const CompressedAssemblyHeader*>(e.image_data);
-	if (header->magic == COMPRESSED_DATA_MAGIC) {
-		log_debug (LOG_ASSEMBLY, "Resolving compressed assembly '{}' from the assembly store"sv, name);
+	if (FastTiming::enabled ()) [[unlikely]] {
+		internal_timing.increment_counter (TimingCounterKind::AssemblyDecompressionLockContention);
+	}
+	lock.lock ();
+}
 
-		if (FastTiming::enabled ()) [[unlikely]] {
-			internal_timing.start_event (TimingEventKind::AssemblyDecompression);
+auto AssemblyStore::get_compressed_descriptor (const CompressedAssemblyHeader *header) noexcept -> CompressedAssemblyDescriptor&
+{
+	if (compressed_assembly_count == 0) [[unlikely]] {
+		Helpers::abort_application (LOG_ASSEMBLY, "Compressed assembly found but no descriptor defined"sv);
+	}
+	if (header->descriptor_index >= compressed_assembly_count) [[unlikely]] {
+		Helpers::abort_application (
+			LOG_ASSEMBLY,
+			std::format (
+				"Invalid compressed assembly descriptor index {}"sv,
+				header->descriptor_index
+			)
+		);
+	}
+
+	CompressedAssemblyDescriptor &cad = compressed_assembly_descriptors[header->descriptor_index];
+	if (cad.buffer_offset >= uncompressed_assemblies_data_size) [[unlikely]] {
+		Helpers::abort_application (
+			LOG_ASSEMBLY,
+			std::format (
+				"Invalid compressed assembly buffer offset {}. Must be smaller than {}",
+				cad.buffer_offset,
+				uncompressed_assemblies_data_size
+			)
+		);
+	}
+
+	// This is not a perfect check, since we might be still within the buffer size and yet
+	// have the tail end of this assembly's data overwritten by the next assembly's data, but
+	// that will cause the app to crash when one or the the other assembly is loaded, so it's
+	// OK to accept that risk. The whole situation is very, very unlikely.
+	if (cad.uncompressed_file_size > uncompressed_assemblies_data_size - cad.buffer_offset) [[unlikely]] {
+		Helpers::abort_application (
+			LOG_ASSEMBLY,
+			std::format (
+				"Invalid compressed assembly buffer size {} at offset {}. Must not exceed {}",
+				cad.uncompressed_file_size,
+				cad.buffer_offset,
+				uncompressed_assemblies_data_size - cad.buffer_offset
+			)
+		);
+	}
+
+	return cad;
+}
+
+auto AssemblyStore::get_thread_decompression_context () noexcept -> ZSTD_DCtx*
+{
+	if (thread_decompression_context.dctx == nullptr) [[unlikely]] {
+		thread_decompression_context.dctx = ZSTD_createDCtx ();
+		if (thread_decompression_context.dctx == nullptr) {
+			Helpers::abort_application (LOG_ASSEMBLY, "Failed to create a Zstandard decompression context"sv);
 		}
+	}
+
+	return thread_decompression_context.dctx;
+}
 
-		if (compressed_assembly_count == 0) [[unlikely]] {
-			Helpers::abort_application (LOG_ASSEMBLY, "Compressed assembly found but no descriptor defined"sv);
+auto AssemblyStore::decompress_data (const CompressedAssemblyHeader *header, uint8_t *dest, size_t dest_size, const void *compressed_data, size_t compressed_data_size, std::string_view const& name) noexcept -> size_t
+{
+	switch (header->codec) {
+		case CompressionCodec::Zstandard:
+			break;
+
+		case CompressionCodec::LZ4: {
+			// Assemblies are much smaller than 2GB, which is checked at build time
+			int ret = LZ4_decompress_safe (
+				static_cast<const char*>(compressed_data),
+				reinterpret_cast<char*>(dest),
+				static_cast<int>(compressed_data_size),
+				static_cast<int>(dest_size)
+			);
+
+			if (ret < 0) {
+				Helpers::abort_application (
+					LOG_ASSEMBLY,
+					std::format (
+						"Decompression of assembly {} failed: corrupt LZ4 data"sv,
+						name
+					)
+				);
+			}
+
+			return static_cast<size_t>(ret);
 		}
-		if (header->descriptor_index >= compressed_assembly_count) [[unlikely]] {
+
+		case CompressionCodec::Stored:
+			if (compressed_data_size > dest_size) [[unlikely]] {
+				Helpers::abort_application (
+					LOG_ASSEMBLY,
+					std::format (
+						"Stored assembly {} is larger than its buffer ({} > {})"sv,
+						name,
+						compressed_data_size,
+						dest_size
+					)
+				);
+			}
+
+			memcpy (dest, compressed_data, compressed_data_size);
+			return compressed_data_size;
+
+		default:
 			Helpers::abort_application (
 				LOG_ASSEMBLY,
 				std::format (
-					"Invalid compressed assembly descriptor index {}"sv,
-					header->descriptor_index
+					"Assembly {} is compressed with an unknown codec {}"sv,
+					name,
+					static_cast<uint32_t>(header->codec)
+				)
+			);
+	}
+
+	ZSTD_DCtx *dctx = get_thread_decompression_context ();
+	size_t ret;
+	if (header->dictionary_id == 0) {
+		ret = ZSTD_decompressDCtx (dctx, dest, dest_size, compressed_data, compressed_data_size);
+	} else {
+		if (assembly_store_dictionary == nullptr || header->dictionary_id != assembly_store_dictionary_id) [[unlikely]] {
+			Helpers::abort_application (
+				LOG_ASSEMBLY,
+				std::format (
+					"Assembly '{}' was compressed with dictionary {}, but the assembly store dictionary ID is {} (0 if absent)"sv,
+					name,
+					header->dictionary_id,
+					assembly_store_dictionary_id
 				)
 			);
 		}
 
-		CompressedAssemblyDescriptor &cad = compressed_assembly_descriptors[header->descriptor_index];
-		assembly_data_size = e.descriptor->data_size - sizeof(CompressedAssemblyHeader);
+		ret = ZSTD_decompress_usingDDict (dctx, dest, dest_size, compressed_data, compressed_data_size, assembly_store_dictionary);
+	}
 
-		if (cad.buffer_offset >= uncompressed_assemblies_data_size) [[unlikely]] {
+	if (ZSTD_isError (ret)) {
+		Helpers::abort_application (
+			LOG_ASSEMBLY,
+			std::format (
+				"Decompression of assembly {} failed: {}"sv,
+				name,
+				ZSTD_getErrorName (ret)
+			)
+		);
+	}
+
+	return ret;
+}
+
+void AssemblyStore::load_dictionary (const uint8_t *dictionary_section, const std::function<std::string()>& get_full_store_path) noexcept
+{
+	// The dictionary section consists of the dictionary size (uint32) followed by the dictionary itself,
+	// in the Zstandard dictionary format
+	uint32_t dictionary_size;
+	memcpy (&dictionary_size, dictionary_section, sizeof (dictionary_size));
+
+	ZSTD_DDict *dictionary = ZSTD_createDDict (dictionary_section + sizeof (dictionary_size), dictionary_size);
+	if (dictionary == nullptr) {
+		Helpers::abort_application (
+			LOG_ASSEMBLY,
+			std::format (
+				"Assembly store '{}' contains an invalid Zstandard dictionary"sv,
+				get_full_store_path ()
+			)
+		);
+	}
+
+	assembly_store_dictionary = dictionary;
+	assembly_store_dictionary_id = ZSTD_getDictID_fromDDict (dictionary);
+
+	// The thread mapping the store is the one which loads most of the assemblies during startup, get its
+	// decompression context ready while we're at it.
+	get_thread_decompression_context ();
+	log_debug (LOG_ASSEMBLY, "Assembly store dictionary ID {}, size {}"sv, assembly_store_dictionary_id, dictionary_size);
+}
+
+auto AssemblyStore::decompress_assembly_locked (const CompressedAssemblyHeader *header, uint32_t compressed_data_size, std::string_view const& name) noexcept -> bool
+{
+	uint32_t const descriptor_index = header->descriptor_index;
+	CompressedAssemblyDescriptor &cad = compressed_assembly_descriptors[descriptor_index];
+	uint8_t *data_buffer = uncompressed_assemblies_data_buffer + cad.buffer_offset;
+
+	asm_cache::ensure_initialized (primary_index.content_id);
+
+	if (header->uncompressed_length != cad.uncompressed_file_size) {
+		if (header->uncompressed_length > cad.uncompressed_file_size) {
 			Helpers::abort_application (
 				LOG_ASSEMBLY,
 				std::format (
-					"Invalid compressed assembly buffer offset {}. Must be smaller than {}",
-					cad.buffer_offset,
-					uncompressed_assemblies_data_size
+					"Compressed assembly '{}' is larger than when the application was built (expected at most {}, got {}). Assemblies don't grow just like that!"sv,
+					name,
+					cad.uncompressed_file_size,
+					header->uncompressed_length
 				)
 			);
+		} else {
+			log_debug (LOG_ASSEMBLY, "Compressed assembly '{}' is smaller than when the application was built. Adjusting accordingly."sv, name);
 		}
+		cad.uncompressed_file_size = header->uncompressed_length;
+	}
+
+	const char *data_start = pointer_add<const char*>(header, sizeof (CompressedAssemblyHeader));
+
+	// Assemblies compressed in chunks are materialized lazily, as the runtime touches their pages, if the app
+	// asked for it. They never end up in the decompressed-assembly cache, as they're never decompressed in
+	// their entirety. Only Zstandard data compressed without the store dictionary is ever chunked. Unless they're
+	// decompressed on demand, their chunks are decompressed in parallel.
+	bool chunkable = header->codec == CompressionCodec::Zstandard && header->dictionary_id == 0;
+	uint8_t *on_demand = !chunkable || !application_config.assembly_store_on_demand_decompression ? nullptr :
+		OnDemandDecompression::map_assembly (descriptor_index, name, reinterpret_cast<const uint8_t*>(data_start), compressed_data_size, cad.uncompressed_file_size);
+	if (on_demand != nullptr) {
+		__atomic_store_n (&cad.loaded, true, __ATOMIC_RELEASE);
+		return false;
+	}
 
-		// This is not a perfect check, since we might be still within the buffer size and yet
-		// have the tail end of this assembly's data overwritten by the next assembly's data, but
-		// that will cause the app to crash when one or the the other assembly is loaded, so it's
-		// OK to accept that risk. The whole situation is very, very unlikely.
-		if (cad.uncompressed_file_size > uncompressed_assemblies_data_size - cad.buffer_offset) [[unlikely]] {
+	bool loaded_from_cache = false;
+	uint8_t *cached = asm_cache::try_load (descriptor_index, name, cad.uncompressed_file_size);
+	if (cached != nullptr) {
+		loaded_from_cache = true;
+		log_debug (LOG_ASSEMBLY, "Loaded decompressed assembly '{}' from the on-device cache"sv, name);
+		if (asm_cache::tracking != nullptr) {
+			asm_cache::tracking[descriptor_index] = cached;
+		}
+	} else {
+		log_debug (LOG_ASSEMBLY, "Decompressing assembly '{}' from the assembly store"sv, name);
+
+		// When the cache is enabled, decompress straight into the cache pack instead of the shared
+		// buffer, so that persisting the assembly doesn't require any copies.
+		auto [cache_area, cache_offset] = asm_cache::reserve_entry (name, cad.uncompressed_file_size);
+		uint8_t *target = cache_area != nullptr ? cache_area : data_buffer;
+		size_t ret = !chunkable ? 0 :
+			ParallelDecompression::decompress (name, reinterpret_cast<const uint8_t*>(data_start), compressed_data_size, target, cad.uncompressed_file_size, get_thread_decompression_context ());
+		if (ret == 0) {
+			ret = decompress_data (header, target, cad.uncompressed_file_size, data_start, compressed_data_size, name);
+		}
+
+		if (ret != cad.uncompressed_file_size) {
 			Helpers::abort_application (
 				LOG_ASSEMBLY,
 				std::format (
-					"Invalid compressed assembly buffer size {} at offset {}. Must not exceed {}",
+					"Decompression of assembly {} yielded a different size (expected {}, got {})"sv,
+					name,
 					cad.uncompressed_file_size,
-					cad.buffer_offset,
-					uncompressed_assemblies_data_size - cad.buffer_offset
+					static_cast<uint32_t>(ret)
 				)
 			);
 		}
 
+		if (cache_area != nullptr) {
+			asm_cache::tracking[descriptor_index] = asm_cache::commit_entry (descriptor_index, cache_area, cache_offset, cad.uncompressed_file_size, data_buffer);
+		}
+	}
+
+	__atomic_store_n (&cad.loaded, true, __ATOMIC_RELEASE);
+	return loaded_from_cache;
+}
+
+void AssemblyStore::decompress_in_background (uint32_t descriptor_index) noexcept
+{
+	const AssemblyStoreEntryDescriptor &store_entry = assembly_store.assemblies[descriptor_index];
+	auto header = reinterpret_cast<const CompressedAssemblyHeader*>(assembly_store.data_start + store_entry.data_offset);
+	CompressedAssemblyDescriptor &cad = get_compressed_descriptor (header);
+
+	if (__atomic_load_n (&cad.loaded, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	std::unique_lock decompress_lock (get_decompression_lock (header->descriptor_index), std::defer_lock);
+	lock_decompression (decompress_lock);
+	if (__atomic_load_n (&cad.loaded, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	std::string_view const name = get_assembly_name (descriptor_index);
+	if (FastTiming::enabled ()) [[unlikely]] {
+		internal_timing.start_event (TimingEventKind::AssemblyDecompression);
+	}
+
+	bool loaded_from_cache = decompress_assembly_locked (header, static_cast<uint32_t>(store_entry.data_size - sizeof (CompressedAssemblyHeader)), name);
+
+	if (FastTiming::enabled ()) [[unlikely]] {
+		internal_timing.end_event (true /* uses_more_info */);
+
+		dynamic_local_string<SENSIBLE_TYPE_NAME_LENGTH> msg;
+		msg.append (name);
+		msg.append (loaded_from_cache ? " (background, decompressed cache hit)"sv : " (background)"sv);
+		internal_timing.add_more_info (msg);
+	}
+}
+
+auto AssemblyStore::background_decompression_worker ([[maybe_unused]] void *arg) noexcept -> void*
+{
+	// There's no point in continuing once startup is done, whatever is still left in the queue will
+	// be decompressed on demand, if at all.
+	while (MonodroidState::is_startup_in_progress ()) {
+		uint32_t item = __atomic_fetch_add (&background_decompression_next, 1, __ATOMIC_RELAXED);
+		if (item >= background_decompression_queue_length) {
+			break;
+		}
+
+		decompress_in_background (background_decompression_queue[item]);
+	}
+
+	__atomic_fetch_sub (&background_decompression_workers, 1, __ATOMIC_RELEASE);
+	return nullptr;
+}
+#endif // def RELEASE
+
+void AssemblyStore::start_background_decompression () noexcept
+{
+#if defined (RELEASE)
+	if (compressed_assembly_count == 0 || assembly_store.assembly_count == 0) {
+		return;
+	}
+
+	// Allow turning the workers off at runtime for A/B benchmarking:
+	//   adb shell setprop debug.net.asmdecompress 0
+	{
+		dynamic_local_property_string prop_value;
+		if (AndroidSystem::monodroid_get_system_property (Constants::DEBUG_NET_ASMDECOMPRESS_PROPERTY, prop_value) > 0 &&
+		    prop_value.get () != nullptr && prop_value.get ()[0] == '0') {
+			return;
+		}
+	}
+
+	long cpu_count = sysconf (_SC_NPROCESSORS_ONLN);
+	if (cpu_count < 2) {
+		// The main thread would only be competing with the workers for the single core
+		return;
+	}
+
+	auto is_compressed = [](uint32_t descriptor_index) noexcept -> bool {
+		const AssemblyStoreEntryDescriptor &store_entry = assembly_store.assemblies[descriptor_index];
+		if (store_entry.data_size < sizeof (CompressedAssemblyHeader)) {
+			return false;
+		}
+
+		return AssemblyStore::is_compressed (reinterpret_cast<const CompressedAssemblyHeader*>(assembly_store.data_start + store_entry.data_offset));
+	};
+
+	uint32_t queue_length = 0;
+	std::span<const uint32_t> predicted = AssemblyStoreProfile::get_predicted_load_order ();
+	if (!predicted.empty ()) {
+		background_decompression_queue.reset (new (std::nothrow) uint32_t[predicted.size ()]);
+		if (background_decompression_queue == nullptr) {
+			return;
+		}
+
+		for (uint32_t descriptor_index : predicted) {
+			if (is_compressed (descriptor_index)) {
+				background_decompression_queue[queue_length++] = descriptor_index;
+			}
+		}
+	} else {
+		// No startup profile yet, fall back to the order in which the assemblies were placed in the
+		// application's assembly list at build time.
+		background_decompression_queue.reset (new (std::nothrow) uint32_t[assembly_store.assembly_count]);
+		if (background_decompression_queue == nullptr) {
+			return;
+		}
+
+		for (uint32_t i = 0; i < assembly_store.assembly_count; i++) {
+			if (is_compressed (i)) {
+				background_decompression_queue[queue_length++] = i;
+			}
+		}
+
+		std::sort (
+			background_decompression_queue.get (),
+			background_decompression_queue.get () + queue_length,
+			[](uint32_t a, uint32_t b) -> bool {
+				return assembly_store.assemblies[a].mapping_index < assembly_store.assemblies[b].mapping_index;
+			}
+		);
+	}
+
+	if (queue_length == 0) {
+		background_decompression_queue.reset ();
+		return;
+	}
+	background_decompression_queue_length = queue_length;
+	background_decompression_next = 0;
+
+	uint32_t worker_count = std::min ({
+		MAX_BACKGROUND_DECOMPRESSION_WORKERS,
+		static_cast<uint32_t>(cpu_count - 1),
+		queue_length,
+	});
+
+	pthread_attr_t attributes;
+	if (pthread_attr_init (&attributes) != 0) {
+		return;
+	}
+	pthread_attr_setdetachstate (&attributes, PTHREAD_CREATE_DETACHED);
+
+	// Must be set before the first worker starts, so that `get_assembly_data` knows to lock.
+	__atomic_store_n (&background_decompression_workers, worker_count, __ATOMIC_RELEASE);
+	uint32_t started = 0;
+	for (; started < worker_count; started++) {
+		pthread_t worker;
+		int result = pthread_create (&worker, &attributes, background_decompression_worker, nullptr);
+		if (result != 0) {
+			log_debug (LOG_ASSEMBLY, "Failed to start background decompression worker: {}"sv, std::strerror (result));
+			break;
+		}
+	}
+	pthread_attr_destroy (&attributes);
+
+	if (started < worker_count) {
+		__atomic_fetch_sub (&background_decompression_workers, worker_count - started, __ATOMIC_RELEASE);
+	}
+
+	log_debug (
+		LOG_ASSEMBLY,
+		"Started {} background decompression worker(s) for {} compressed assemblies ({} order)"sv,
+		started,
+		queue_length,
+		predicted.empty () ? "mapping index"sv : "startup profile"sv
+	);
+#endif // def RELEASE
+}
+
+[[gnu::always_inline]]
+auto AssemblyStore::get_assembly_data (AssemblyStoreSingleAssemblyRuntimeData const& e, std::string_view const& name) noexcept -> std::tuple<uint8_t*, uint32_t>
+{
+	uint8_t *assembly_data = nullptr;
+	uint32_t assembly_data_size = 0;
+
+#if defined (RELEASE)
+	auto header = reinterpret_cast<const CompressedAssemblyHeader*>(e.image_data);
+	if (is_compressed (header)) {
+		log_debug (LOG_ASSEMBLY, "Resolving compressed assembly '{}' from the assembly store"sv, name);
+
+		if (FastTiming::enabled ()) [[unlikely]] {
+			internal_timing.start_event (TimingEventKind::AssemblyDecompression);
+		}
+
+		CompressedAssemblyDescriptor &cad = get_compressed_descriptor (header);
 		uint8_t *data_buffer = uncompressed_assemblies_data_buffer + cad.buffer_offset;
 		uint32_t const descriptor_index = header->descriptor_index;
 		auto is_loaded = [&cad]() noexcept -> bool {
 			return __atomic_load_n (&cad.loaded, __ATOMIC_ACQUIRE);
 		};
 
-		// Resolves to the mmap'd cache file when this assembly was loaded from
-		// the on-device cache, otherwise to the shared decompression buffer.
+		// Resolves to the on-demand decompression region or to the mmap'd cache file when this assembly
+		// was loaded from the on-device cache, otherwise to the shared decompression buffer.
 		auto resolve_data = [descriptor_index, data_buffer]() noexcept -> uint8_t* {
+			if (uint8_t *on_demand = OnDemandDecompression::get_image (descriptor_index); on_demand != nullptr) {
+				return on_demand;
+			}
 			if (asm_cache::tracking != nullptr && asm_cache::tracking[descriptor_index] != nullptr) {
 				return asm_cache::tracking[descriptor_index];
 			}
 			return data_buffer;
 		};
 
-		if (!is_loaded ()) {
-			StartupAwareLock decompress_lock (assembly_decompress_mutex);
-
-			if (is_loaded ()) {
-				set_assembly_data_and_size (resolve_data (), cad.uncompressed_file_size, assembly_data, assembly_data_size);
-
-				if (FastTiming::enabled ()) [[unlikely]] {
-					internal_timing.end_event (true /* uses_more_info */);
-
-					dynamic_local_string<SENSIBLE_TYPE_NAME_LENGTH> msg;
-					msg.append (name);
-					msg.append (" (decompressed in another thread)"sv);
-					internal_timing.add_more_info (msg);
-				}
-				return {assembly_data, assembly_data_size};
+		auto end_timing_event = [&name](std::string_view const& note) noexcept {
+			if (!FastTiming::enabled ()) [[likely]] {
+				return;
 			}
+			internal_timing.end_event (true /* uses_more_info */);
 
-			asm_cache::ensure_initialized (assembly_store_content_id);
+			dynamic_local_string<SENSIBLE_TYPE_NAME_LENGTH> msg;
+			msg.append (name);
+			msg.append (note);
+			internal_timing.add_more_info (msg);
+		};
 
-			if (header->uncompressed_length != cad.uncompressed_file_size) {
-				if (header->uncompressed_length > cad.uncompressed_file_size) {
-					Helpers::abort_application (
-						LOG_ASSEMBLY,
-						std::format (
-							"Compressed assembly '{}' is larger than when the application was built (expected at most {}, got {}). Assemblies don't grow just like that!"sv,
-							name,
-							cad.uncompressed_file_size,
-							header->uncompressed_length
-						)
-					);
-				} else {
-					log_debug (LOG_ASSEMBLY, "Compressed assembly '{}' is smaller than when the application was built. Adjusting accordingly."sv, name);
-				}
-				cad.uncompressed_file_size = header->uncompressed_length;
+		if (is_loaded ()) {
+			end_timing_event (" (decompressed ahead of time)"sv);
+		} else {
+			// `StartupAwareLock` doesn't lock anything while startup is in progress, since normally
+			// nothing else runs at that point. That's not true anymore once the background
+			// decompression workers have been started, so lock unconditionally while they're alive.
+			std::unique_lock decompress_lock (get_decompression_lock (descriptor_index), std::defer_lock);
+			if (__atomic_load_n (&background_decompression_workers, __ATOMIC_ACQUIRE) > 0 || !MonodroidState::is_startup_in_progress ()) {
+				lock_decompression (decompress_lock);
 			}
 
-			const char *data_start = pointer_add<const char*>(e.image_data, sizeof(CompressedAssemblyHeader));
-
-			bool loaded_from_cache = false;
-			uint8_t *cached = asm_cache::try_load (descriptor_index, name, cad.uncompressed_file_size);
-			if (cached != nullptr) {
-				loaded_from_cache = true;
-				log_debug (LOG_ASSEMBLY, "Loaded decompressed assembly '{}' from the on-device cache"sv, name);
-				if (asm_cache::tracking != nullptr) {
-					asm_cache::tracking[descriptor_index] = cached;
-				}
+			if (is_loaded ()) {
+				end_timing_event (" (decompressed in another thread)"sv);
 			} else {
-				log_debug (LOG_ASSEMBLY, "Decompressing assembly '{}' from the assembly store"sv, name);
-				size_t ret = ZSTD_decompress (data_buffer, cad.uncompressed_file_size, data_start, assembly_data_size);
-
-				if (ZSTD_isError (ret)) {
-					Helpers::abort_application (
-						LOG_ASSEMBLY,
-						std::format (
-							"Decompression of assembly {} failed: {}"sv,
-							name,
-							ZSTD_getErrorName (ret)
-						)
-					);
-				}
-
-				if (ret != cad.uncompressed_file_size) {
-					Helpers::abort_application (
-						LOG_ASSEMBLY,
-						std::format (
-							"Decompression of assembly {} yielded a different size (expected {}, got {})"sv,
-							name,
-							cad.uncompressed_file_size,
-							static_cast<uint32_t>(ret)
-						)
-					);
-				}
-
-				asm_cache::enqueue_write (descriptor_index, name, data_buffer, cad.uncompressed_file_size);
-			}
-
-			__atomic_store_n (&cad.loaded, true, __ATOMIC_RELEASE);
-			if (FastTiming::enabled ()) [[unlikely]] {
-				internal_timing.end_event (true /* uses_more_info */);
-
-				dynamic_local_string<SENSIBLE_TYPE_NAME_LENGTH> msg;
-				msg.append (name);
-				if (loaded_from_cache) {
-					msg.append (" (decompressed cache hit)"sv);
-				}
-				internal_timing.add_more_info (msg);
+				bool loaded_from_cache = decompress_assembly_locked (header, static_cast<uint32_t>(e.descriptor->data_size - sizeof (CompressedAssemblyHeader)), name);
+				end_timing_event (loaded_from_cache ? " (decompressed cache hit)"sv : ""sv);
 			}
 		}
 
@@ -676,48 +1723,63 @@ auto AssemblyStore::get_assembly_data (AssemblyStoreSingleAssemblyRuntimeData co
 	{
 		log_debug (LOG_ASSEMBLY, "Assembly '{}' is not compressed in the assembly store"sv, name);
 
-		// HACK! START
-		// Currently, MAUI crashes when we return a pointer to read-only data, so we must copy
-		// the assembly data to a read-write area.
-		log_debug (LOG_ASSEMBLY, "Copying assembly data to an r/w memory area"sv);
-
+		// Currently, MAUI crashes when we return a pointer to read-only data, so we must give the
+		// runtime a read-write view of the assembly data. Whenever possible, that's a copy-on-write
+		// mapping of the store file, falling back to a heap copy otherwise.
 		if (FastTiming::enabled ()) [[unlikely]] {
 			internal_timing.start_event (TimingEventKind::AssemblyLoad);
 		}
 
-		uint8_t *rw_pointer = static_cast<uint8_t*>(malloc (e.descriptor->data_size));
-		memcpy (rw_pointer, e.image_data, e.descriptor->data_size);
+		// Only the images of the primary store are mapped copy-on-write. The secondary stores are mounted after
+		// startup, if at all, and the assemblies they hold aren't likely to be loaded in bulk.
+		uint8_t *rw_pointer = nullptr;
+		if (e.descriptor >= assembly_store.assemblies && e.descriptor < assembly_store.assemblies + assembly_store.assembly_count) {
+			auto descriptor_index = static_cast<uint32_t>(e.descriptor - assembly_store.assemblies);
+			std::call_once (cow_images::init_flag, cow_images::locate_backing_file, assembly_store.data_start, assembly_store.assembly_count);
+			rw_pointer = cow_images::map_image (descriptor_index, e.image_data, e.descriptor->data_size);
+		}
+
+		bool copied = rw_pointer == nullptr;
+		if (copied) {
+			log_debug (LOG_ASSEMBLY, "Copying assembly data to an r/w memory area"sv);
+			rw_pointer = static_cast<uint8_t*>(malloc (e.descriptor->data_size));
+			memcpy (rw_pointer, e.image_data, e.descriptor->data_size);
+		}
 
 		if (FastTiming::enabled ()) [[unlikely]] {
 			internal_timing.end_event (true /* uses more info */);
 
 			dynamic_local_string<SENSIBLE_TYPE_NAME_LENGTH> msg;
 			msg.append (name);
-			msg.append (" (memcpy to r/w area, part of assembly load time)"sv);
+			if (copied) {
+				msg.append (" (memcpy to r/w area, part of assembly load time)"sv);
+			} else {
+				msg.append (" (copy-on-write mapping, part of assembly load time)"sv);
+			}
 			internal_timing.add_more_info (msg);
 		}
 
 		set_assembly_data_and_size (rw_pointer, e.descriptor->data_size, assembly_data, assembly_data_size);
-		// HACK! END
-		// 	set_assembly_data_and_size (e.image_data, e.descriptor->data_size, assembly_data, assembly_data_size);
 	}
 
 	return {assembly_data, assembly_data_size};
 }
 
 [[gnu::always_inline]]
-auto AssemblyStore::find_assembly_store_entry (std::string_view const& name, hash_t hash, const AssemblyStoreIndexEntry *entries, size_t entry_count) noexcept -> const AssemblyStoreIndexEntry*
+auto AssemblyStore::find_assembly_store_entry_sorted (std::string_view const& name, hash_t hash, AssemblyStoreRuntimeData const& store, StoreIndex const& index) noexcept -> const AssemblyStoreIndexEntry*
 {
 	// Entries are sorted by `name_hash`, so all entries sharing `hash` are contiguous. CRC32 is a
 	// 32-bit hash, so collisions are possible (though very unlikely); walk the entire run of entries
 	// with a matching hash and compare the actual assembly name to find the correct one.
+	const AssemblyStoreIndexEntry *entries = index.hashes;
+	size_t const entry_count = store.index_entry_count;
 	auto less_than = [](AssemblyStoreIndexEntry const& entry, hash_t key) -> bool { return entry.name_hash < key; };
 	size_t idx = Search::lower_bound<AssemblyStoreIndexEntry, hash_t, less_than> (hash, entries, entry_count);
 
 	while (idx < entry_count && entries[idx].name_hash == hash) {
 		AssemblyStoreIndexEntry const& entry = entries[idx];
-		if (entry.descriptor_index < assembly_store.assembly_count &&
-		    name_matches (name, assembly_store_names[entry.descriptor_index])) {
+		if (entry.descriptor_index < store.assembly_count &&
+		    name_matches (name, get_assembly_name (store, entry.descriptor_index))) {
 			return &entry;
 		}
 		idx++;
@@ -726,19 +1788,143 @@ auto AssemblyStore::find_assembly_store_entry (std::string_view const& name, has
 	return nullptr;
 }
 
+[[gnu::always_inline]]
+auto AssemblyStore::find_assembly_store_entry_perfect_hash (std::string_view const& name, hash_t hash, AssemblyStoreRuntimeData const& store, StoreIndex const& index) noexcept -> const AssemblyStoreIndexEntry*
+{
+	uint32_t const slot_count = store.index_entry_count;
+	if (slot_count == 0) [[unlikely]] {
+		return nullptr;
+	}
+
+	uint32_t bucket = MinimalPerfectHash::bucket (hash, index.perfect_hash_bucket_count);
+	uint32_t displacement;
+	memcpy (&displacement, index.perfect_hash_displacements + (static_cast<size_t>(bucket) * sizeof (uint32_t)), sizeof (displacement));
+
+	// The table is perfect only for the names it was built from, any other name will land in some
+	// slot too, so the entry must be verified.
+	AssemblyStoreIndexEntry const& entry = index.hashes[MinimalPerfectHash::slot (hash, displacement, slot_count)];
+	if (entry.name_hash != hash ||
+	    entry.descriptor_index >= store.assembly_count ||
+	    !name_matches (name, get_assembly_name (store, entry.descriptor_index))) {
+		return nullptr;
+	}
+
+	return &entry;
+}
+
+[[gnu::always_inline]]
+auto AssemblyStore::find_assembly_store_entry (std::string_view const& name, hash_t hash, AssemblyStoreRuntimeData const& store, StoreIndex const& index) noexcept -> const AssemblyStoreIndexEntry*
+{
+	if (index.perfect_hash_displacements != nullptr) [[likely]] {
+		return find_assembly_store_entry_perfect_hash (name, hash, store, index);
+	}
+
+	return find_assembly_store_entry_sorted (name, hash, store, index);
+}
+
+auto AssemblyStore::find_in_secondary_stores (std::string_view const& name, hash_t hash, const AssemblyStoreRuntimeData *&store) noexcept -> const AssemblyStoreIndexEntry*
+{
+	// The primary store lists the name hashes of all the secondary stores, so that names which can't be found
+	// anywhere (CoreCLR probes for quite a few of those) don't cause any of the secondary stores to be mounted.
+	// CRC32 collisions are possible, so more than one store may need to be looked at.
+	auto less_than = [](AssemblyStoreSecondaryIndexEntry const& entry, hash_t key) -> bool { return entry.name_hash < key; };
+	size_t idx = Search::lower_bound<AssemblyStoreSecondaryIndexEntry, hash_t, less_than> (hash, secondary_index, secondary_index_entry_count);
+
+	for (; idx < secondary_index_entry_count && secondary_index[idx].name_hash == hash; idx++) {
+		SecondaryStore &secondary = mount_secondary_store (secondary_index[idx].store_number);
+		const AssemblyStoreIndexEntry *entry = find_assembly_store_entry (name, hash, secondary.data, secondary.index);
+		if (entry != nullptr) {
+			store = &secondary.data;
+			return entry;
+		}
+	}
+
+	return nullptr;
+}
+
+auto AssemblyStore::mount_secondary_store (uint32_t store_number) noexcept -> SecondaryStore&
+{
+	if (store_number == 0 || store_number > secondary_store_count) [[unlikely]] {
+		Helpers::abort_application (
+			LOG_ASSEMBLY,
+			std::format (
+				"Invalid secondary assembly store number {}, the application has {} secondary store(s)"sv,
+				store_number,
+				secondary_store_count
+			)
+		);
+	}
+
+	SecondaryStore &secondary = secondary_stores[store_number - 1];
+	if (__atomic_load_n (&secondary.mounted, __ATOMIC_ACQUIRE)) [[likely]] {
+		return secondary;
+	}
+
+	std::lock_guard lock (secondary_stores_lock);
+	if (__atomic_load_n (&secondary.mounted, __ATOMIC_RELAXED)) {
+		return secondary;
+	}
+
+	auto get_store_path = [store_number]() -> std::string {
+		return std::format ("{}{}{}"sv, Constants::assembly_store_secondary_file_name_prefix, store_number, Constants::dso_suffix);
+	};
+
+	const uint8_t *optional_sections = map_store_index (secondary_store_loader (store_number), secondary.data, secondary.index, get_store_path);
+	if (secondary.index.content_id != secondary.expected_content_id) [[unlikely]] {
+		Helpers::abort_application (
+			LOG_ASSEMBLY,
+			std::format (
+				"Assembly store '{}' has content ID 0x{:x}, but the primary assembly store expects 0x{:x}"sv,
+				get_store_path (),
+				secondary.index.content_id,
+				secondary.expected_content_id
+			)
+		);
+	}
+
+	uint32_t const version = reinterpret_cast<const AssemblyStoreHeader*>(secondary.data.data_start)->version;
+	if ((version & ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG) != 0) {
+		// Assemblies are compressed with the dictionary of the primary store, a secondary store isn't supposed
+		// to have one of its own
+		uint32_t dictionary_size;
+		memcpy (&dictionary_size, optional_sections, sizeof (dictionary_size));
+		optional_sections += sizeof (dictionary_size) + dictionary_size;
+	}
+
+	if ((version & ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG) != 0) {
+		configure_debug_data_region (secondary.data.data_start, optional_sections);
+	}
+
+	__atomic_store_n (&secondary.mounted, true, __ATOMIC_RELEASE);
+	log_debug (
+		LOG_ASSEMBLY,
+		"Mounted secondary assembly store {}; {} assemblies; content ID 0x{:x}"sv,
+		get_store_path (),
+		secondary.data.assembly_count,
+		secondary.index.content_id
+	);
+
+	return secondary;
+}
+
 auto AssemblyStore::open_assembly (std::string_view const& name, int64_t &size) noexcept -> void*
 {
 	hash_t name_hash = crc32_hash (name);
 
 	if constexpr (Constants::is_debug_build) {
 		// In fastdev mode we might not have any assembly store.
-		if (assembly_store_hashes == nullptr) {
+		if (primary_index.hashes == nullptr) {
 			log_warn (LOG_ASSEMBLY, "Assembly store not registered. Unable to look up assembly '{}'"sv, name);
 			return nullptr;
 		}
 	}
 
-	const AssemblyStoreIndexEntry *hash_entry = find_assembly_store_entry (name, name_hash, assembly_store_hashes, assembly_store.index_entry_count);
+	const AssemblyStoreRuntimeData *store = &assembly_store;
+	const AssemblyStoreIndexEntry *hash_entry = find_assembly_store_entry (name, name_hash, assembly_store, primary_index);
+	if (hash_entry == nullptr && secondary_store_count > 0) {
+		hash_entry = find_in_secondary_stores (name, name_hash, store);
+	}
+
 	if (hash_entry == nullptr) [[unlikely]] {
 		size = 0;
 		log_warn (LOG_ASSEMBLY, "Assembly '{}' (hash 0x{:x}) not found"sv, name, name_hash);
@@ -751,27 +1937,32 @@ auto AssemblyStore::open_assembly (std::string_view const& name, int64_t &size)
 		return nullptr;
 	}
 
-	if (hash_entry->descriptor_index >= assembly_store.assembly_count) {
+	if (hash_entry->descriptor_index >= store->assembly_count) {
 		Helpers::abort_application (
 			LOG_ASSEMBLY,
 			std::format (
 				"Invalid assembly descriptor index {}, exceeds the maximum value of {}"sv,
 				hash_entry->descriptor_index,
-				assembly_store.assembly_count - 1
+				store->assembly_count - 1
 			)
 		);
 	}
 
-	const AssemblyStoreEntryDescriptor &store_entry = assembly_store.assemblies[hash_entry->descriptor_index];
+	// The profile is about startup, which only the assemblies in the primary store take part in
+	if (store == &assembly_store) {
+		AssemblyStoreProfile::record_assembly_load (hash_entry->descriptor_index);
+	}
+
+	const AssemblyStoreEntryDescriptor &store_entry = store->assemblies[hash_entry->descriptor_index];
 	AssemblyStoreSingleAssemblyRuntimeData &assembly_runtime_info = assembly_store_bundled_assemblies[store_entry.mapping_index];
 
 	if (assembly_runtime_info.image_data == nullptr) {
 		// The assignments here don't need to be atomic, the value will always be the same, so even if two threads
 		// arrive here at the same time, nothing bad will happen.
-		assembly_runtime_info.image_data = assembly_store.data_start + store_entry.data_offset;
+		assembly_runtime_info.image_data = store->data_start + store_entry.data_offset;
 		assembly_runtime_info.descriptor = &store_entry;
 		if (store_entry.debug_data_offset != 0) {
-			assembly_runtime_info.debug_info_data = assembly_store.data_start + store_entry.debug_data_offset;
+			assembly_runtime_info.debug_info_data = store->data_start + store_entry.debug_data_offset;
 		}
 
 		log_debug (
@@ -793,7 +1984,7 @@ auto AssemblyStore::open_assembly (std::string_view const& name, int64_t &size)
 	return assembly_data;
 }
 
-void AssemblyStore::configure_from_payload (const void *payload_start, const std::function<std::string()>& get_full_store_path) noexcept
+auto AssemblyStore::map_store_index (const void *payload_start, AssemblyStoreRuntimeData &store, StoreIndex &index, const std::function<std::string()>& get_full_store_path) noexcept -> const uint8_t*
 {
 	auto header = static_cast<const AssemblyStoreHeader*>(payload_start);
 
@@ -807,43 +1998,267 @@ void AssemblyStore::configure_from_payload (const void *payload_start, const std
 		);
 	}
 
-	if (header->version != ASSEMBLY_STORE_FORMAT_VERSION) {
+	uint32_t const version = header->version & ~(ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG | ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG | ASSEMBLY_STORE_SECONDARY_STORES_FLAG);
+	if (version != ASSEMBLY_STORE_FORMAT_VERSION && version != ASSEMBLY_STORE_FORMAT_VERSION_SORTED_INDEX) {
 		Helpers::abort_application (
 			LOG_ASSEMBLY,
 			std::format (
-				"Assembly store '{}' uses format version {:x}, instead of the expected {:x}"sv,
+				"Assembly store '{}' uses format version {:x}, instead of the expected {:x} or {:x}"sv,
 				get_full_store_path (),
 				header->version,
-				ASSEMBLY_STORE_FORMAT_VERSION
+				ASSEMBLY_STORE_FORMAT_VERSION,
+				ASSEMBLY_STORE_FORMAT_VERSION_SORTED_INDEX
 			)
 		);
 	}
 
 	constexpr size_t header_size = sizeof(AssemblyStoreHeader);
 
-	assembly_store_content_id = header->content_id;
-	assembly_store.data_start = static_cast<const uint8_t*>(payload_start);
-	assembly_store.assembly_count = header->entry_count;
-	assembly_store.index_entry_count = header->index_entry_count;
-	assembly_store.assemblies = reinterpret_cast<const AssemblyStoreEntryDescriptor*>(assembly_store.data_start + header_size + header->index_size);
-	assembly_store_hashes = reinterpret_cast<const AssemblyStoreIndexEntry*>(assembly_store.data_start + header_size);
-
-	// Build a lookup of assembly names indexed by descriptor index, used to disambiguate CRC32 hash
-	// collisions during lookup. The names section follows the descriptor table and consists of
-	// `entry_count` length-prefixed (uint32 length followed by the UTF-8 bytes) records, stored in
-	// descriptor-index order. `delete[]` guards against a leak should the (single) store ever be
-	// re-mapped; `assembly_store_names` is nullptr on first call, for which it is a no-op.
-	const uint8_t *names_cursor = assembly_store.data_start + header_size + header->index_size +
-		(static_cast<size_t>(header->entry_count) * sizeof (AssemblyStoreEntryDescriptor));
-	delete[] assembly_store_names;
-	assembly_store_names = new std::string_view[header->entry_count];
-	for (uint32_t i = 0; i < header->entry_count; i++) {
-		uint32_t name_length;
-		memcpy (&name_length, names_cursor, sizeof (name_length));
-		names_cursor += sizeof (name_length);
-		assembly_store_names[i] = std::string_view (reinterpret_cast<const char*>(names_cursor), name_length);
-		names_cursor += name_length;
-	}
-
-	log_debug (LOG_ASSEMBLY, "Mapped assembly store {}; content ID 0x{:x}"sv, get_full_store_path (), assembly_store_content_id);
+	index.content_id = header->content_id;
+	store.data_start = static_cast<const uint8_t*>(payload_start);
+	store.assembly_count = header->entry_count;
+	store.index_entry_count = header->index_entry_count;
+	store.assemblies = reinterpret_cast<const AssemblyStoreEntryDescriptor*>(store.data_start + header_size + header->index_size);
+	index.hashes = reinterpret_cast<const AssemblyStoreIndexEntry*>(store.data_start + header_size);
+
+	index.perfect_hash_displacements = nullptr;
+	index.perfect_hash_bucket_count = 0;
+	if (version == ASSEMBLY_STORE_FORMAT_VERSION) {
+		const uint8_t *perfect_hash_start = store.data_start + header_size +
+			(static_cast<size_t>(header->index_entry_count) * sizeof (AssemblyStoreIndexEntry));
+		memcpy (&index.perfect_hash_bucket_count, perfect_hash_start, sizeof (index.perfect_hash_bucket_count));
+
+		size_t perfect_hash_size = sizeof (uint32_t) + (static_cast<size_t>(index.perfect_hash_bucket_count) * sizeof (uint32_t));
+		if ((header->index_entry_count > 0 && index.perfect_hash_bucket_count == 0) ||
+		    static_cast<size_t>(header->index_entry_count) * sizeof (AssemblyStoreIndexEntry) + perfect_hash_size != header->index_size) {
+			Helpers::abort_application (
+				LOG_ASSEMBLY,
+				std::format (
+					"Assembly store '{}' perfect hash index is corrupted"sv,
+					get_full_store_path ()
+				)
+			);
+		}
+		index.perfect_hash_displacements = perfect_hash_start + sizeof (uint32_t);
+	}
+
+	// The optional sections follow the names section which, being in descriptor order, ends with the name of
+	// the last assembly. The names themselves are sliced out of the section only when needed (see
+	// `get_assembly_name`).
+	if (header->entry_count > 0) {
+		AssemblyStoreEntryDescriptor const& last = store.assemblies[header->entry_count - 1];
+		return store.data_start + last.name_offset + last.name_length;
+	}
+
+	return store.data_start + header_size + header->index_size;
+}
+
+void AssemblyStore::configure_from_payload (const void *payload_start, const std::function<std::string()>& get_full_store_path, secondary_store_loader_fn load_secondary_store) noexcept
+{
+	const uint8_t *optional_sections = map_store_index (payload_start, assembly_store, primary_index, get_full_store_path);
+	uint32_t const version = static_cast<const AssemblyStoreHeader*>(payload_start)->version;
+
+	if ((version & ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG) != 0) {
+#if defined (RELEASE)
+		// Only Release builds compress assemblies
+		load_dictionary (optional_sections, get_full_store_path);
+#endif // def RELEASE
+		uint32_t dictionary_size;
+		memcpy (&dictionary_size, optional_sections, sizeof (dictionary_size));
+		optional_sections += sizeof (dictionary_size) + dictionary_size;
+	}
+
+	if ((version & ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG) != 0) {
+		configure_debug_data_region (assembly_store.data_start, optional_sections);
+		optional_sections += 2 * sizeof (uint32_t);
+	}
+
+	if ((version & ASSEMBLY_STORE_SECONDARY_STORES_FLAG) != 0) {
+		configure_secondary_stores (optional_sections, load_secondary_store);
+	}
+
+	AssemblyStoreProfile::initialize (assembly_store.data_start, primary_index.content_id, assembly_store.assembly_count);
+
+	log_debug (LOG_ASSEMBLY, "Mapped assembly store {}; content ID 0x{:x}"sv, get_full_store_path (), primary_index.content_id);
+}
+
+void AssemblyStore::configure_secondary_stores (const uint8_t *secondary_stores_section, secondary_store_loader_fn load_secondary_store) noexcept
+{
+	uint32_t store_count;
+	uint32_t entry_count;
+	memcpy (&store_count, secondary_stores_section, sizeof (store_count));
+	memcpy (&entry_count, secondary_stores_section + sizeof (store_count), sizeof (entry_count));
+	if (store_count == 0) {
+		return;
+	}
+
+	secondary_stores.reset (new (std::nothrow) SecondaryStore[store_count]());
+	if (secondary_stores == nullptr) [[unlikely]] {
+		Helpers::abort_application (LOG_ASSEMBLY, "Failed to allocate memory for the secondary assembly stores"sv);
+	}
+
+	const uint8_t *content_ids = secondary_stores_section + 2 * sizeof (uint32_t);
+	for (uint32_t i = 0; i < store_count; i++) {
+		memcpy (&secondary_stores[i].expected_content_id, content_ids + (static_cast<size_t>(i) * sizeof (uint64_t)), sizeof (uint64_t));
+	}
+
+	secondary_index = reinterpret_cast<const AssemblyStoreSecondaryIndexEntry*>(content_ids + (static_cast<size_t>(store_count) * sizeof (uint64_t)));
+	secondary_index_entry_count = entry_count;
+	secondary_store_loader = load_secondary_store;
+	secondary_store_count = store_count;
+
+	log_debug (LOG_ASSEMBLY, "Assembly store has {} secondary store(s), holding {} index entries"sv, store_count, entry_count);
+}
+
+void AssemblyStore::configure_debug_data_region (const uint8_t *data_start, const uint8_t *region_section) noexcept
+{
+	uint32_t region_offset;
+	uint32_t region_size;
+	memcpy (&region_offset, region_section, sizeof (region_offset));
+	memcpy (&region_size, region_section + sizeof (region_offset), sizeof (region_size));
+	if (region_size == 0) {
+		return;
+	}
+
+	// The debug and config data is read only when CoreCLR asks for it, which most launches never do. Tell the
+	// kernel not to read ahead into the region, neither when faulting in its pages nor when faulting in the
+	// pages of the images preceding it. Only the pages fully within the region are advised, the first one
+	// may still contain the tail of the last image.
+	auto const page_size = static_cast<uintptr_t>(sysconf (_SC_PAGESIZE));
+	uintptr_t start = (reinterpret_cast<uintptr_t>(data_start + region_offset) + page_size - 1) & ~(page_size - 1);
+	uintptr_t end = reinterpret_cast<uintptr_t>(data_start + region_offset + region_size) & ~(page_size - 1);
+	if (end > start && madvise (reinterpret_cast<void*>(start), end - start, MADV_RANDOM) != 0) {
+		log_debug (LOG_ASSEMBLY, "madvise (MADV_RANDOM) failed for the assembly store debug data region {:p}-{:p}: {}"sv, reinterpret_cast<void*>(start), reinterpret_cast<void*>(end), std::strerror (errno));
+		return;
+	}
+
+	log_debug (LOG_ASSEMBLY, "Assembly store debug and config data region: offset {}, size {}"sv, region_offset, region_size);
+}
+
+void AssemblyStore::start_cache_maintenance () noexcept
+{
+	asm_cache::request_sweep ();
+}
+
+void AssemblyStore::log_residency_stats () noexcept
+{
+	if (assembly_store.data_start == nullptr || assembly_store.assembly_count == 0) {
+		return;
+	}
+
+	// Page flags, for pages which contain image data and pages which contain debug or config data
+	constexpr uint8_t IMAGE_PAGE = 0x01;
+	constexpr uint8_t DEBUG_PAGE = 0x02;
+
+	auto const page_size = static_cast<uintptr_t>(sysconf (_SC_PAGESIZE));
+	uintptr_t const store_start = reinterpret_cast<uintptr_t>(assembly_store.data_start) & ~(page_size - 1);
+	size_t const store_start_slack = reinterpret_cast<uintptr_t>(assembly_store.data_start) - store_start;
+
+	size_t data_end = 0;
+	for (uint32_t i = 0; i < assembly_store.assembly_count; i++) {
+		AssemblyStoreEntryDescriptor const& desc = assembly_store.assemblies[i];
+		data_end = std::max ({
+			data_end,
+			static_cast<size_t>(desc.data_offset) + desc.data_size,
+			static_cast<size_t>(desc.debug_data_offset) + desc.debug_data_size,
+			static_cast<size_t>(desc.config_data_offset) + desc.config_data_size,
+		});
+	}
+
+	size_t const page_count = (store_start_slack + data_end + page_size - 1) / page_size;
+	std::vector<unsigned char> residency (page_count);
+	if (mincore (reinterpret_cast<void*>(store_start), page_count * page_size, residency.data ()) != 0) {
+		log_debug (LOG_ASSEMBLY, "mincore failed for the assembly store: {}"sv, std::strerror (errno));
+		return;
+	}
+
+	std::vector<uint8_t> page_kinds (page_count);
+	auto mark = [&] (uint32_t offset, uint32_t size, uint8_t kind) {
+		if (offset == 0 || size == 0) {
+			return;
+		}
+
+		size_t first = (store_start_slack + offset) / page_size;
+		size_t last = (store_start_slack + offset + size - 1) / page_size;
+		for (size_t page = first; page <= last; page++) {
+			page_kinds[page] |= kind;
+		}
+	};
+
+	for (uint32_t i = 0; i < assembly_store.assembly_count; i++) {
+		AssemblyStoreEntryDescriptor const& desc = assembly_store.assemblies[i];
+		mark (desc.data_offset, desc.data_size, IMAGE_PAGE);
+		mark (desc.debug_data_offset, desc.debug_data_size, DEBUG_PAGE);
+		mark (desc.config_data_offset, desc.config_data_size, DEBUG_PAGE);
+	}
+
+	size_t store_resident = 0;
+	size_t image_pages = 0;
+	size_t image_resident = 0;
+	size_t debug_pages = 0;
+	size_t debug_resident = 0;
+	for (size_t page = 0; page < page_count; page++) {
+		bool const resident = (residency[page] & 0x01) != 0;
+		store_resident += resident ? 1 : 0;
+		if ((page_kinds[page] & IMAGE_PAGE) != 0) {
+			image_pages++;
+			image_resident += resident ? 1 : 0;
+		}
+
+		if ((page_kinds[page] & DEBUG_PAGE) != 0) {
+			debug_pages++;
+			debug_resident += resident ? 1 : 0;
+		}
+	}
+
+	// Pages shared by an image and debug or config data are counted in both categories
+	log_info (
+		LOG_ASSEMBLY,
+		"Assembly store residency: {} of {} pages resident; image data: {} of {} pages; debug and config data: {} of {} pages"sv,
+		store_resident,
+		page_count,
+		image_resident,
+		image_pages,
+		debug_resident,
+		debug_pages
+	);
+}
+
+void AssemblyStore::log_copy_on_write_stats () noexcept
+{
+	if (cow_images::images == nullptr) {
+		return;
+	}
+
+	int pagemap_fd = open ("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+	if (pagemap_fd < 0) {
+		log_debug (LOG_ASSEMBLY, "Unable to open /proc/self/pagemap: {}"sv, std::strerror (errno));
+		return;
+	}
+
+	size_t total_mapped_pages = 0;
+	size_t total_dirty_pages = 0;
+	std::lock_guard lock (cow_images::images_lock);
+	for (uint32_t i = 0; i < assembly_store.assembly_count; i++) {
+		cow_images::MappedImage const& image = cow_images::images[i];
+		if (image.area == nullptr) {
+			continue;
+		}
+
+		size_t mapped_pages = 0;
+		size_t dirty_pages = cow_images::count_dirty_pages (pagemap_fd, image, mapped_pages);
+		total_mapped_pages += mapped_pages;
+		total_dirty_pages += dirty_pages;
+		log_info (LOG_ASSEMBLY, "Copy-on-write assembly '{}': {} of {} pages dirtied"sv, get_assembly_name (i), dirty_pages, mapped_pages);
+	}
+	close (pagemap_fd);
+
+	log_info (
+		LOG_ASSEMBLY,
+		"Copy-on-write assemblies: {} of {} pages dirtied ({} bytes copied instead of {})"sv,
+		total_dirty_pages,
+		total_mapped_pages,
+		total_dirty_pages * cow_images::page_size,
+		total_mapped_pages * cow_images::page_size
+	);
 }
@@ -1,3 +1,4 @@
+#include <host/assembly-store.hh>
 #include <host/host.hh>
 #include <host/host-jni.hh>
 #include <shared/log_types.hh>
@@ -16,6 +17,8 @@ JNICALL Java_mono_android_Runtime_dumpTimingData ([[maybe_unused]] JNIEnv *env,
 {
 	if (FastTiming::enabled ()) [[unlikely]] {
 		internal_timing.dump ();
+		AssemblyStore::log_copy_on_write_stats ();
+		AssemblyStore::log_residency_stats ();
 	}
 }
 
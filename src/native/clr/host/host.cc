@@ -15,6 +15,7 @@
 
 #include <xamarin-app.hh>
 #include <host/assembly-store.hh>
+#include <host/assembly-store-profile.hh>
 #include <host/gc-bridge.hh>
 #include <host/fastdev-assemblies.hh>
 #include <host/host.hh>
@@ -170,7 +171,7 @@ void Host::gather_assemblies_and_libraries ([[maybe_unused]] jstring_array_wrapp
 	map_assembly_store_via_dlopen (Constants::assembly_store_file_name.data ());
 }
 
-void Host::map_assembly_store_via_dlopen (const char *store_path) noexcept
+auto Host::dlopen_assembly_store (const char *store_path) noexcept -> const void*
 {
 	// RTLD_LOCAL: we only dlsym() our own handle, so there's no need to add the store's symbols to
 	// the global lookup scope (RTLD_GLOBAL would just add linker bookkeeping).
@@ -192,8 +193,41 @@ void Host::map_assembly_store_via_dlopen (const char *store_path) noexcept
 	}
 
 	log_debug (LOG_ASSEMBLY, "Assembly store payload via dynamic symbol: {:p} ({})"sv, payload, optional_string (store_path));
-	AssemblyStore::configure_from_payload (payload, [store_path]() -> std::string { return std::string { store_path }; });
+	return payload;
+}
+
+// Secondary stores live next to the primary one, they're loaded the same way it was: by their full path if the
+// primary store was found in the native library directory, by their name alone if the dynamic linker found it
+// in the APK.
+auto Host::load_secondary_assembly_store (uint32_t store_number) noexcept -> const void*
+{
+	std::string store_path { assembly_store_dir };
+	store_path.append (Constants::assembly_store_secondary_file_name_prefix);
+	store_path.append (std::to_string (store_number));
+	store_path.append (Constants::dso_suffix);
+
+	return dlopen_assembly_store (store_path.c_str ());
+}
+
+void Host::map_assembly_store_via_dlopen (const char *store_path) noexcept
+{
+	const void *payload = dlopen_assembly_store (store_path);
+
+	std::string_view const path { store_path };
+	size_t const last_slash = path.rfind ('/');
+	if (last_slash != std::string_view::npos) {
+		assembly_store_dir.assign (path.substr (0, last_slash + 1));
+	}
+
+	AssemblyStore::configure_from_payload (payload, [store_path]() -> std::string { return std::string { store_path }; }, load_secondary_assembly_store);
 	found_assembly_store = true;
+
+	// Warm up the store pages the previous launch needed during startup, before CoreCLR starts
+	// asking for them. Does nothing on the first launch of a given store.
+	AssemblyStoreProfile::start_background_work ();
+
+	// Likewise, start decompressing the assemblies we expect to need before CoreCLR gets to them.
+	AssemblyStore::start_background_decompression ();
 }
 
 [[gnu::always_inline]]
@@ -511,6 +545,7 @@ void Host::Java_mono_android_Runtime_initInternal (
 	}
 
 	MonodroidState::mark_startup_done ();
+	AssemblyStore::start_cache_maintenance ();
 }
 
 void Host::Java_mono_android_Runtime_register (JNIEnv *env, jstring managedType, jclass nativeClass, jstring methods) noexcept
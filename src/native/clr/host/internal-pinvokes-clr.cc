@@ -9,6 +9,13 @@
 
 using namespace xamarin::android;
 
+// The hash the typemap uses to look `name` up, for `clr_typemap_managed_to_java_hashed` below. Managed code calls it once
+// per type name and keeps the result.
+uint64_t clr_typemap_hash_name (const char *name, uint32_t name_length) noexcept
+{
+	return TypeMapper::hash_name (name, name_length);
+}
+
 const char* clr_typemap_managed_to_java (
 	const char *typeName,
 	[[maybe_unused]] const char *assemblyFullName,
@@ -22,6 +29,23 @@ const char* clr_typemap_managed_to_java (
 #endif
 }
 
+// `typeNameHash` is the `clr_typemap_hash_name` of the `typeNameLength` bytes of `typeName`, obtained by managed code once
+// per type. The Debug typemap is keyed on the type and assembly names combined, so it has no use for either.
+const char* clr_typemap_managed_to_java_hashed (
+	const char *typeName,
+	[[maybe_unused]] uint32_t typeNameLength,
+	[[maybe_unused]] uint64_t typeNameHash,
+	[[maybe_unused]] const char *assemblyFullName,
+	[[maybe_unused]] const uint8_t *mvid
+) noexcept
+{
+#if defined(RELEASE)
+	return TypeMapper::managed_to_java (typeName, typeNameLength, typeNameHash, mvid);
+#else
+	return TypeMapper::managed_to_java (typeName, assemblyFullName);
+#endif
+}
+
 bool clr_typemap_java_to_managed (const char *java_type_name, char const** assembly_name, uint32_t *managed_type_token_id) noexcept
 {
 	return TypeMapper::java_to_managed (java_type_name, assembly_name, managed_type_token_id);
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include <fcntl.h>
+#include <linux/userfaultfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <xamarin-app.hh>
+#include <host/on-demand-decompression.hh>
+#include <runtime-base/timing-internal.hh>
+#include <runtime-base/util.hh>
+#include <runtime-base/zstd.hh>
+
+using namespace xamarin::android;
+
+namespace {
+	std::once_flag init_flag;
+	std::mutex registration_lock;
+
+	// Used only by the handler thread
+	ZSTD_DCtx *dctx = nullptr;
+	std::unique_ptr<uint8_t[]> fill_buffer;
+	size_t fill_buffer_size = 0;
+	std::unique_ptr<uint8_t[]> frame_buffer;
+	size_t frame_buffer_size = 0;
+
+	auto ensure_capacity (std::unique_ptr<uint8_t[]> &buffer, size_t &buffer_size, size_t needed) noexcept -> uint8_t*
+	{
+		if (buffer_size < needed) {
+			buffer.reset (new (std::nothrow) uint8_t[needed]);
+			if (buffer == nullptr) {
+				Helpers::abort_application (LOG_ASSEMBLY, std::format ("Failed to allocate {} bytes for on-demand assembly decompression"sv, needed));
+			}
+			buffer_size = needed;
+		}
+
+		return buffer.get ();
+	}
+
+	[[gnu::always_inline]]
+	auto read_u32 (const uint8_t *data) noexcept -> uint32_t
+	{
+		uint32_t value;
+		memcpy (&value, data, sizeof (value));
+		return value;
+	}
+}
+
+void OnDemandDecompression::initialize () noexcept
+{
+	long sc_page_size = sysconf (_SC_PAGESIZE);
+	if (sc_page_size <= 0) {
+		return;
+	}
+	page_size = static_cast<size_t>(sc_page_size);
+
+	auto fd = static_cast<int>(syscall (__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK));
+#if defined (UFFD_USER_MODE_ONLY)
+	if (fd < 0 && (errno == EPERM || errno == EACCES)) {
+		// Unprivileged processes may be allowed to handle only the faults raised in user mode. The
+		// runtime reads the images directly, never passing them to the kernel, so that's enough.
+		fd = static_cast<int>(syscall (__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY));
+	}
+#endif
+	if (fd < 0) {
+		log_debug (LOG_ASSEMBLY, "userfaultfd unavailable, assemblies will be decompressed eagerly: {}"sv, std::strerror (errno));
+		return;
+	}
+
+	uffdio_api api {
+		.api = UFFD_API,
+		.features = 0,
+		.ioctls = 0,
+	};
+	if (ioctl (fd, UFFDIO_API, &api) != 0) {
+		log_debug (LOG_ASSEMBLY, "userfaultfd API handshake failed, assemblies will be decompressed eagerly: {}"sv, std::strerror (errno));
+		close (fd);
+		return;
+	}
+
+	dctx = ZSTD_createDCtx ();
+	images.reset (new (std::nothrow) uint8_t*[compressed_assembly_count]());
+	regions.reset (new (std::nothrow) Region[compressed_assembly_count]());
+	if (dctx == nullptr || images == nullptr || regions == nullptr) {
+		close (fd);
+		return;
+	}
+
+	pthread_attr_t attributes;
+	int result = pthread_attr_init (&attributes);
+	bool attributes_initialized = result == 0;
+	if (result == 0) {
+		result = pthread_attr_setdetachstate (&attributes, PTHREAD_CREATE_DETACHED);
+	}
+
+	uffd = fd;
+	pthread_t thread;
+	if (result == 0) {
+		result = pthread_create (&thread, &attributes, handler_thread_entry, nullptr);
+	}
+
+	if (attributes_initialized) {
+		pthread_attr_destroy (&attributes);
+	}
+	if (result != 0) {
+		log_debug (LOG_ASSEMBLY, "Failed to start the on-demand decompression thread: {}"sv, std::strerror (result));
+		uffd = -1;
+		close (fd);
+		return;
+	}
+
+	log_debug (LOG_ASSEMBLY, "On-demand assembly decompression enabled"sv);
+}
+
+auto OnDemandDecompression::is_seekable (const uint8_t *compressed_data, uint32_t compressed_size) noexcept -> bool
+{
+	return compressed_size >= sizeof (SeekTableFooter) && read_u32 (compressed_data + compressed_size - sizeof (uint32_t)) == SEEKABLE_MAGIC;
+}
+
+auto OnDemandDecompression::read_seek_table (SeekTable &seek_table, const uint8_t *compressed_data, uint32_t compressed_size, uint32_t uncompressed_size) noexcept -> bool
+{
+	SeekTableFooter footer;
+	memcpy (&footer, compressed_data + compressed_size - sizeof (footer), sizeof (footer));
+
+	size_t entry_size = (footer.descriptor & SEEK_TABLE_CHECKSUM_FLAG) != 0 ? 3 * sizeof (uint32_t) : 2 * sizeof (uint32_t);
+	uint64_t table_size = static_cast<uint64_t>(footer.frame_count) * entry_size + sizeof (footer);
+	if (footer.frame_count == 0 || table_size + 2 * sizeof (uint32_t) > compressed_size) {
+		return false;
+	}
+
+	const uint8_t *table = compressed_data + compressed_size - table_size - 2 * sizeof (uint32_t);
+	if (read_u32 (table) != SKIPPABLE_FRAME_MAGIC || read_u32 (table + sizeof (uint32_t)) != table_size) {
+		return false;
+	}
+	table += 2 * sizeof (uint32_t);
+
+	// We find the frame containing an offset by dividing it by the chunk size, which requires all the
+	// frames but the last one to have the same decompressed size.
+	uint32_t chunk_size = read_u32 (table + sizeof (uint32_t));
+	if (chunk_size == 0) {
+		return false;
+	}
+
+	std::unique_ptr<uint32_t[]> frame_offsets { new (std::nothrow) uint32_t[footer.frame_count + 1] };
+	if (frame_offsets == nullptr) {
+		return false;
+	}
+
+	uint64_t compressed_offset = 0;
+	uint64_t decompressed_offset = 0;
+	for (uint32_t i = 0; i < footer.frame_count; i++, table += entry_size) {
+		uint32_t frame_compressed_size = read_u32 (table);
+		uint32_t frame_decompressed_size = read_u32 (table + sizeof (uint32_t));
+		bool last = i == footer.frame_count - 1;
+		if ((!last && frame_decompressed_size != chunk_size) || frame_decompressed_size == 0 || frame_decompressed_size > chunk_size) {
+			return false;
+		}
+
+		frame_offsets[i] = static_cast<uint32_t>(compressed_offset);
+		compressed_offset += frame_compressed_size;
+		decompressed_offset += frame_decompressed_size;
+	}
+	frame_offsets[footer.frame_count] = static_cast<uint32_t>(compressed_offset);
+
+	if (compressed_offset != compressed_size - table_size - 2 * sizeof (uint32_t) || decompressed_offset != uncompressed_size) {
+		return false;
+	}
+
+	seek_table.image_size = uncompressed_size;
+	seek_table.chunk_size = chunk_size;
+	seek_table.frame_count = footer.frame_count;
+	seek_table.frames = compressed_data;
+	seek_table.frame_offsets = std::move (frame_offsets);
+	return true;
+}
+
+auto OnDemandDecompression::map_assembly (uint32_t descriptor_index, std::string_view const& name, const uint8_t *compressed_data, uint32_t compressed_size, uint32_t uncompressed_size) noexcept -> uint8_t*
+{
+	// Only assemblies compressed in the seekable format can be decompressed on demand, don't bother
+	// setting anything up for any other ones.
+	if (uncompressed_size == 0 || !is_seekable (compressed_data, compressed_size)) {
+		return nullptr;
+	}
+
+	std::call_once (init_flag, initialize);
+	if (uffd < 0 || descriptor_index >= compressed_assembly_count) {
+		return nullptr;
+	}
+
+	std::lock_guard lock (registration_lock);
+	Region &region = regions[region_count];
+	if (!read_seek_table (region, compressed_data, compressed_size, uncompressed_size)) {
+		log_debug (LOG_ASSEMBLY, "Assembly '{}' has an invalid seek table, decompressing it eagerly"sv, name);
+		return nullptr;
+	}
+
+	size_t size = (static_cast<size_t>(uncompressed_size) + page_size - 1) & ~(page_size - 1);
+	void *area = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (area == MAP_FAILED) {
+		log_debug (LOG_ASSEMBLY, "Failed to reserve memory for on-demand decompression of '{}': {}"sv, name, std::strerror (errno));
+		return nullptr;
+	}
+
+	uffdio_register registration {
+		.range = {
+			.start = reinterpret_cast<uintptr_t>(area),
+			.len = size,
+		},
+		.mode = UFFDIO_REGISTER_MODE_MISSING,
+		.ioctls = 0,
+	};
+	if (ioctl (uffd, UFFDIO_REGISTER, &registration) != 0 || (registration.ioctls & (1ull << _UFFDIO_COPY)) == 0) {
+		log_debug (LOG_ASSEMBLY, "Failed to register '{}' for on-demand decompression: {}"sv, name, std::strerror (errno));
+		munmap (area, size);
+		return nullptr;
+	}
+
+	region.start = reinterpret_cast<uintptr_t>(area);
+	region.size = size;
+
+	// The region must be visible to the handler thread before anything touches it
+	__atomic_store_n (&region_count, region_count + 1, __ATOMIC_RELEASE);
+	__atomic_store_n (&images[descriptor_index], static_cast<uint8_t*>(area), __ATOMIC_RELEASE);
+
+	if (FastTiming::enabled ()) [[unlikely]] {
+		internal_timing.increment_counter (TimingCounterKind::OnDemandImagePages, size / page_size);
+	}
+
+	log_debug (LOG_ASSEMBLY, "Assembly '{}' will be decompressed on demand, in {} chunks of {} bytes"sv, name, region.frame_count, region.chunk_size);
+	return static_cast<uint8_t*>(area);
+}
+
+auto OnDemandDecompression::find_region (uintptr_t address) noexcept -> Region*
+{
+	uint32_t count = __atomic_load_n (&region_count, __ATOMIC_ACQUIRE);
+	for (uint32_t i = 0; i < count; i++) {
+		Region &region = regions[i];
+		if (address >= region.start && address - region.start < region.size) {
+			return &region;
+		}
+	}
+
+	return nullptr;
+}
+
+// Fills the pages covering the chunk which contains `fault_address`. Should the chunk size not be a
+// multiple of the page size, the first and the last page of the range also contain data of the
+// neighbouring chunks, which are decompressed as well.
+void OnDemandDecompression::materialize (Region &region, uintptr_t fault_address) noexcept
+{
+	uint64_t fault_offset = (fault_address - region.start) & ~static_cast<uint64_t>(page_size - 1);
+	uint64_t chunk_start = (fault_offset / region.chunk_size) * region.chunk_size;
+	uint64_t chunk_end = std::min<uint64_t> (chunk_start + region.chunk_size, region.image_size);
+
+	uint64_t fill_start = chunk_start & ~static_cast<uint64_t>(page_size - 1);
+	uint64_t fill_end = std::min<uint64_t> ((chunk_end + page_size - 1) & ~static_cast<uint64_t>(page_size - 1), region.size);
+	uint64_t data_end = std::min<uint64_t> (fill_end, region.image_size);
+	auto fill_size = static_cast<size_t>(fill_end - fill_start);
+
+	uint8_t *fill = ensure_capacity (fill_buffer, fill_buffer_size, fill_size);
+	if (fill_end > data_end) {
+		memset (fill + (data_end - fill_start), 0, static_cast<size_t>(fill_end - data_end));
+	}
+
+	uint32_t first_frame = static_cast<uint32_t>(fill_start / region.chunk_size);
+	uint32_t last_frame = static_cast<uint32_t>((data_end - 1) / region.chunk_size);
+	for (uint32_t frame = first_frame; frame <= last_frame; frame++) {
+		uint64_t frame_start = static_cast<uint64_t>(frame) * region.chunk_size;
+		auto frame_size = static_cast<size_t>(std::min<uint64_t> (region.chunk_size, region.image_size - frame_start));
+		bool within_fill = frame_start >= fill_start && frame_start + frame_size <= fill_end;
+		uint8_t *target = within_fill ? fill + (frame_start - fill_start) : ensure_capacity (frame_buffer, frame_buffer_size, region.chunk_size);
+
+		size_t ret = ZSTD_decompressDCtx (
+			dctx,
+			target,
+			frame_size,
+			region.frames + region.frame_offsets[frame],
+			region.frame_offsets[frame + 1] - region.frame_offsets[frame]
+		);
+		if (ZSTD_isError (ret) || ret != frame_size) {
+			Helpers::abort_application (
+				LOG_ASSEMBLY,
+				std::format (
+					"On-demand decompression of chunk {} failed: {}"sv,
+					frame,
+					ZSTD_isError (ret) ? ZSTD_getErrorName (ret) : "size mismatch"
+				)
+			);
+		}
+
+		if (!within_fill) {
+			uint64_t copy_start = std::max (frame_start, fill_start);
+			uint64_t copy_end = std::min (frame_start + frame_size, fill_end);
+			memcpy (fill + (copy_start - fill_start), target + (copy_start - frame_start), static_cast<size_t>(copy_end - copy_start));
+		}
+	}
+
+	uffdio_copy copy {
+		.dst = region.start + fill_start,
+		.src = reinterpret_cast<uintptr_t>(fill),
+		.len = fill_size,
+		.mode = 0,
+		.copy = 0,
+	};
+
+	size_t pages_materialized = fill_size / page_size;
+	if (ioctl (uffd, UFFDIO_COPY, &copy) != 0) {
+		// Some of the pages were already materialized along with a neighbouring chunk. The kernel fails
+		// with `EEXIST` if it's the first page of the range, otherwise it copies the pages up to the
+		// existing one, reports how many bytes it copied in `copy.copy` and fails with `EAGAIN`. `EAGAIN`
+		// with nothing copied means that the address space was being changed, the copy must be retried.
+		if (errno != EEXIST && errno != EAGAIN) {
+			Helpers::abort_application (LOG_ASSEMBLY, std::format ("Failed to materialize decompressed assembly pages: {}"sv, std::strerror (errno)));
+		}
+
+		// Go page by page from where the kernel stopped
+		pages_materialized = copy.copy > 0 ? static_cast<size_t>(copy.copy) / page_size : 0;
+		for (size_t offset = pages_materialized * page_size; offset < fill_size; offset += page_size) {
+			int result;
+			do {
+				copy = {
+					.dst = region.start + fill_start + offset,
+					.src = reinterpret_cast<uintptr_t>(fill + offset),
+					.len = page_size,
+					.mode = UFFDIO_COPY_MODE_DONTWAKE,
+					.copy = 0,
+				};
+				result = ioctl (uffd, UFFDIO_COPY, &copy);
+			} while (result != 0 && errno == EAGAIN);
+
+			if (result == 0) {
+				pages_materialized++;
+			} else if (errno != EEXIST) {
+				Helpers::abort_application (LOG_ASSEMBLY, std::format ("Failed to materialize decompressed assembly page: {}"sv, std::strerror (errno)));
+			}
+		}
+
+		uffdio_range range {
+			.start = region.start + fill_start,
+			.len = fill_size,
+		};
+		ioctl (uffd, UFFDIO_WAKE, &range);
+	}
+
+	if (FastTiming::enabled ()) [[unlikely]] {
+		internal_timing.increment_counter (TimingCounterKind::OnDemandPagesMaterialized, pages_materialized);
+	}
+}
+
+auto OnDemandDecompression::handler_thread_entry ([[maybe_unused]] void *arg) noexcept -> void*
+{
+	pollfd poll_fd {
+		.fd = uffd,
+		.events = POLLIN,
+		.revents = 0,
+	};
+
+	while (true) {
+		int result = poll (&poll_fd, 1, -1);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			Helpers::abort_application (LOG_ASSEMBLY, std::format ("Polling userfaultfd failed: {}"sv, std::strerror (errno)));
+		}
+
+		uffd_msg message;
+		ssize_t nread = read (uffd, &message, sizeof (message));
+		if (nread < 0) {
+			if (errno == EAGAIN || errno == EINTR) {
+				continue;
+			}
+			Helpers::abort_application (LOG_ASSEMBLY, std::format ("Reading userfaultfd failed: {}"sv, std::strerror (errno)));
+		}
+
+		if (nread != sizeof (message) || message.event != UFFD_EVENT_PAGEFAULT) {
+			continue;
+		}
+
+		auto address = static_cast<uintptr_t>(message.arg.pagefault.address);
+		Region *region = find_region (address);
+		if (region == nullptr) [[unlikely]] {
+			Helpers::abort_application (LOG_ASSEMBLY, std::format ("Page fault at {:#x} outside of any on-demand decompression region"sv, address));
+		}
+
+		materialize (*region, address);
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <host/on-demand-decompression.hh>
+#include <host/parallel-decompression.hh>
+#include <runtime-base/util.hh>
+
+using namespace xamarin::android;
+
+struct ParallelDecompression::Job
+{
+	OnDemandDecompression::SeekTable const& table;
+	std::string_view const& name;
+	uint8_t *dest;
+	uint32_t next_frame;
+};
+
+namespace {
+	std::once_flag init_flag;
+
+	std::mutex pool_lock;
+	std::condition_variable job_posted;
+	std::condition_variable job_released;
+}
+
+void ParallelDecompression::initialize () noexcept
+{
+	long cpu_count = sysconf (_SC_NPROCESSORS_ONLN);
+	if (cpu_count < 2) {
+		// The calling thread would only be competing with the workers for the single core
+		return;
+	}
+
+	pthread_attr_t attributes;
+	if (pthread_attr_init (&attributes) != 0) {
+		return;
+	}
+	pthread_attr_setdetachstate (&attributes, PTHREAD_CREATE_DETACHED);
+
+	uint32_t wanted = std::min (MAX_WORKERS, static_cast<uint32_t>(cpu_count - 1));
+	uint32_t started = 0;
+	for (; started < wanted; started++) {
+		pthread_t worker;
+		int result = pthread_create (&worker, &attributes, worker_entry, nullptr);
+		if (result != 0) {
+			log_debug (LOG_ASSEMBLY, "Failed to start parallel decompression worker: {}"sv, std::strerror (result));
+			break;
+		}
+	}
+	pthread_attr_destroy (&attributes);
+
+	worker_count = started;
+	log_debug (LOG_ASSEMBLY, "Started {} parallel decompression worker(s)"sv, started);
+}
+
+// Decompresses frames until there are none left. The frames are claimed one at a time, so that a thread
+// which gets descheduled holds up at most one of them.
+void ParallelDecompression::decompress_frames (Job &job, ZSTD_DCtx *dctx) noexcept
+{
+	OnDemandDecompression::SeekTable const& table = job.table;
+	uint32_t frame;
+	while ((frame = __atomic_fetch_add (&job.next_frame, 1, __ATOMIC_RELAXED)) < table.frame_count) {
+		uint64_t frame_start = static_cast<uint64_t>(frame) * table.chunk_size;
+		auto frame_size = static_cast<size_t>(std::min<uint64_t> (table.chunk_size, table.image_size - frame_start));
+
+		size_t ret = ZSTD_decompressDCtx (
+			dctx,
+			job.dest + frame_start,
+			frame_size,
+			table.frames + table.frame_offsets[frame],
+			table.frame_offsets[frame + 1] - table.frame_offsets[frame]
+		);
+		if (ZSTD_isError (ret) || ret != frame_size) {
+			Helpers::abort_application (
+				LOG_ASSEMBLY,
+				std::format (
+					"Decompression of chunk {} of assembly {} failed: {}"sv,
+					frame,
+					job.name,
+					ZSTD_isError (ret) ? ZSTD_getErrorName (ret) : "size mismatch"
+				)
+			);
+		}
+	}
+}
+
+auto ParallelDecompression::worker_entry ([[maybe_unused]] void *arg) noexcept -> void*
+{
+	ZSTD_DCtx *dctx = ZSTD_createDCtx ();
+	if (dctx == nullptr) {
+		Helpers::abort_application (LOG_ASSEMBLY, "Failed to create a Zstandard decompression context"sv);
+	}
+
+	uint64_t seen_generation = 0;
+	while (true) {
+		Job *job;
+		{
+			std::unique_lock lock (pool_lock);
+			job_posted.wait (lock, [&seen_generation] { return current_job != nullptr && job_generation != seen_generation; });
+			job = current_job;
+			seen_generation = job_generation;
+			busy_workers++;
+		}
+
+		decompress_frames (*job, dctx);
+
+		{
+			std::lock_guard lock (pool_lock);
+			busy_workers--;
+		}
+		job_released.notify_all ();
+	}
+
+	return nullptr;
+}
+
+auto ParallelDecompression::decompress (std::string_view const& name, const uint8_t *compressed_data, uint32_t compressed_size, uint8_t *dest, uint32_t dest_size, ZSTD_DCtx *dctx) noexcept -> size_t
+{
+	if (!OnDemandDecompression::is_seekable (compressed_data, compressed_size)) {
+		return 0;
+	}
+
+	OnDemandDecompression::SeekTable table {};
+	if (!OnDemandDecompression::read_seek_table (table, compressed_data, compressed_size, dest_size)) {
+		log_debug (LOG_ASSEMBLY, "Assembly '{}' has an invalid seek table, decompressing it in one go"sv, name);
+		return 0;
+	}
+
+	std::call_once (init_flag, initialize);
+
+	Job job {
+		.table = table,
+		.name = name,
+		.dest = dest,
+		.next_frame = 0,
+	};
+
+	bool posted = false;
+	if (worker_count > 0) {
+		std::lock_guard lock (pool_lock);
+		if (current_job == nullptr) {
+			current_job = &job;
+			job_generation++;
+			posted = true;
+		}
+	}
+
+	if (posted) {
+		job_posted.notify_all ();
+	}
+
+	decompress_frames (job, dctx);
+
+	if (posted) {
+		// Workers which haven't picked the job up yet won't touch it anymore, the ones which did must be
+		// done with their last frame before `job` goes out of scope.
+		std::unique_lock lock (pool_lock);
+		current_job = nullptr;
+		job_released.wait (lock, [] { return busy_workers == 0; });
+	}
+
+	log_debug (LOG_ASSEMBLY, "Decompressed assembly '{}' in {} chunks of {} bytes"sv, name, table.frame_count, table.chunk_size);
+	return table.image_size;
+}
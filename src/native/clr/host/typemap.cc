@@ -4,9 +4,11 @@
 
 #include <host/typemap.hh>
 #include <runtime-base/crc32.hh>
+#include <runtime-base/minimal-perfect-hash.hh>
 #include <runtime-base/timing-internal.hh>
 #include <runtime-base/search.hh>
 #include <runtime-base/util.hh>
+#include <runtime-base/xxh3.hh>
 #include <xamarin-app.hh>
 
 using namespace xamarin::android;
@@ -69,6 +71,110 @@ namespace {
 	private:
 		std::array<char, BUF_SIZE> _ascii_form;
 	};
+
+#if defined(RELEASE)
+	// Everything that differs between the Release typemaps keyed on CRC32 type name hashes and those keyed on xxh3 ones
+	// (see `typemap_name_hash_bits`). The `TypeMapper` lookups are templates over the hash type and use the traits below.
+	template<typename THash>
+	struct TypeMapNameHash;
+
+	template<>
+	struct TypeMapNameHash<hash_t>
+	{
+		[[gnu::always_inline]]
+		static auto hash (const char *name, size_t name_length) noexcept -> hash_t
+		{
+			return crc32_hash (name, name_length);
+		}
+
+		[[gnu::always_inline]]
+		static auto java_to_managed () noexcept -> const hash_t*
+		{
+			return java_to_managed_hashes;
+		}
+
+		[[gnu::always_inline]]
+		static auto modules_map () noexcept -> const hash_t*
+		{
+			return modules_map_hashes;
+		}
+
+		[[gnu::always_inline]]
+		static auto modules_duplicates () noexcept -> const hash_t*
+		{
+			return modules_duplicates_hashes;
+		}
+
+		[[gnu::always_inline]]
+		static constexpr auto perfect_hash_key (hash_t hash) noexcept -> hash_t
+		{
+			return hash;
+		}
+
+		[[gnu::always_inline]]
+		static constexpr auto cache_key (hash_t hash) noexcept -> uint64_t
+		{
+			return (static_cast<uint64_t>(hash) << 32) | hash;
+		}
+
+		// Different type names share CRC32 hashes often enough, the names themselves must be compared
+		[[gnu::always_inline]]
+		static auto names_match (const char *mapped_name, size_t mapped_name_length, const char *name, size_t name_length) noexcept -> bool
+		{
+			return same_string (mapped_name, mapped_name_length, name, name_length);
+		}
+	};
+
+	template<>
+	struct TypeMapNameHash<uint64_t>
+	{
+		[[gnu::always_inline]]
+		static auto hash (const char *name, size_t name_length) noexcept -> uint64_t
+		{
+			return xxh3_hash (name, name_length);
+		}
+
+		[[gnu::always_inline]]
+		static auto java_to_managed () noexcept -> const uint64_t*
+		{
+			return java_to_managed_hashes64;
+		}
+
+		[[gnu::always_inline]]
+		static auto modules_map () noexcept -> const uint64_t*
+		{
+			return modules_map_hashes64;
+		}
+
+		[[gnu::always_inline]]
+		static auto modules_duplicates () noexcept -> const uint64_t*
+		{
+			return modules_duplicates_hashes64;
+		}
+
+		// The perfect hash table is built over the upper halves of the hashes. Entries which share the upper half are next
+		// to each other, because the hashes are sorted.
+		[[gnu::always_inline]]
+		static constexpr auto perfect_hash_key (uint64_t hash) noexcept -> hash_t
+		{
+			return static_cast<hash_t>(hash >> 32);
+		}
+
+		[[gnu::always_inline]]
+		static constexpr auto cache_key (uint64_t hash) noexcept -> uint64_t
+		{
+			return hash;
+		}
+
+		// The build tasks use the 64-bit hashes only if no two type names in the typemap share one, so a matching hash
+		// identifies the name. Only the lengths, which are at hand anyway, are compared as well.
+		[[gnu::always_inline]]
+		static auto names_match ([[maybe_unused]] const char *mapped_name, size_t mapped_name_length, [[maybe_unused]] const char *name, size_t name_length) noexcept -> bool
+		{
+			return mapped_name_length == name_length;
+		}
+	};
+#endif
 }
 
 #if defined(DEBUG)
@@ -127,6 +233,41 @@ auto TypeMapper::find_index_by_hash (const char *typeName, const TypeMapEntry *m
 	return -1z;
 }
 
+// MUST produce the same values as `TypeMapNameHashIndex.GetHomeSlot` in
+// src/Xamarin.Android.Build.Tasks/Utilities/TypeMapNameHashIndex.cs
+[[gnu::always_inline]]
+auto TypeMapper::name_index_home_slot (hash_t name_hash) noexcept -> uint32_t
+{
+	return static_cast<uint32_t>((static_cast<uint64_t>(name_hash) * 0x9e3779b97f4a7c15ull) >> 32) & (type_map_name_index_size - 1u);
+}
+
+[[gnu::always_inline, gnu::flatten]]
+auto TypeMapper::find_index_by_name_index (const char *typeName, const TypeMapEntry *map, const uint32_t *name_index, const char (&name_map)[], std::string_view const& from_name, std::string_view const& to_name) noexcept -> ssize_t
+{
+	log_debug (LOG_ASSEMBLY, "typemap: map {} -> {} uses name index"sv, from_name, to_name);
+
+	size_t type_name_length = strlen (typeName);
+	hash_t type_name_hash = crc32_hash (typeName, type_name_length);
+
+	// The index is at most half full, so there's always an empty slot to stop at
+	uint32_t const mask = type_map_name_index_size - 1u;
+	for (uint32_t slot = name_index_home_slot (type_name_hash);; slot = (slot + 1u) & mask) {
+		uint32_t const entry_index = name_index[slot];
+		if (entry_index == 0u) {
+			return -1z;
+		}
+
+		TypeMapEntry const& entry = map[entry_index - 1u];
+		if (entry.from_hash != type_name_hash || entry.from == std::numeric_limits<uint32_t>::max ()) {
+			continue;
+		}
+
+		if (strcmp (&name_map[entry.from], typeName) == 0) {
+			return static_cast<ssize_t>(entry_index - 1u);
+		}
+	}
+}
+
 [[gnu::always_inline, gnu::flatten]]
 auto TypeMapper::index_to_name (ssize_t idx, const char* typeName, const TypeMapEntry *map, const char (&name_map)[], std::string_view const& from_name, std::string_view const& to_name) -> const char*
 {
@@ -157,7 +298,9 @@ auto TypeMapper::managed_to_java_debug (const char *typeName, const char *assemb
 	full_type_name.append (", "sv);
 	full_type_name.append (assemblyFullName);
 
-	ssize_t idx = find_index_by_hash (full_type_name.get (), type_map.managed_to_java, type_map_managed_type_names, MANAGED, JAVA);
+	ssize_t idx = type_map_name_index_size > 0u
+		? find_index_by_name_index (full_type_name.get (), type_map.managed_to_java, type_map_managed_to_java_index, type_map_managed_type_names, MANAGED, JAVA)
+		: find_index_by_hash (full_type_name.get (), type_map.managed_to_java, type_map_managed_type_names, MANAGED, JAVA);
 
 	return index_to_name (idx, full_type_name.get (), type_map.managed_to_java, type_map_java_type_names, MANAGED, JAVA);
 }
@@ -171,9 +314,9 @@ auto TypeMapper::compare_mvid (const uint8_t *mvid, TypeMapModule const& module)
 }
 
 [[gnu::always_inline]]
-auto TypeMapper::find_module_entry (const uint8_t *mvid, const TypeMapModule *entries, size_t entry_count) noexcept -> const TypeMapModule*
+auto TypeMapper::find_module_entry_sorted (const uint8_t *mvid, const TypeMapModule *entries, size_t entry_count) noexcept -> const TypeMapModule*
 {
-	if (entries == nullptr || mvid == nullptr) [[unlikely]] {
+	if (entries == nullptr) [[unlikely]] {
 		return nullptr;
 	}
 
@@ -187,23 +330,95 @@ auto TypeMapper::find_module_entry (const uint8_t *mvid, const TypeMapModule *en
 	return nullptr;
 }
 
+// MUST produce the same values as `GetModuleIndexHomeSlot` in
+// src/Xamarin.Android.Build.Tasks/Utilities/TypeMappingReleaseNativeAssemblyGeneratorCLR.cs
+[[gnu::always_inline]]
+auto TypeMapper::module_index_home_slot (const uint8_t *mvid) noexcept -> uint32_t
+{
+	uint64_t key;
+	memcpy (&key, mvid, sizeof (key));
+
+	return static_cast<uint32_t>((key * 0x9e3779b97f4a7c15ull) >> 32) & (managed_to_java_module_index_size - 1u);
+}
+
+[[gnu::always_inline]]
+auto TypeMapper::find_module_entry_hashed (const uint8_t *mvid) noexcept -> const TypeMapModule*
+{
+	// The index is at most half full, so there's always an empty slot to stop at
+	uint32_t const mask = managed_to_java_module_index_size - 1u;
+	for (uint32_t slot = module_index_home_slot (mvid);; slot = (slot + 1u) & mask) {
+		uint32_t const module_index = managed_to_java_module_index[slot];
+		if (module_index == 0u) {
+			return nullptr;
+		}
+
+		// Only the first 8 bytes of the MVID were hashed, make sure it's the right module
+		TypeMapModule const& module = managed_to_java_map[module_index - 1u];
+		if (compare_mvid (mvid, module) == 0) [[likely]] {
+			return &module;
+		}
+	}
+}
+
 [[gnu::always_inline]]
-auto TypeMapper::find_managed_to_java_map_entry (hash_t name_hash, const char *type_name, size_t type_name_length, const TypeMapModuleEntry *map, size_t entry_count) noexcept -> const TypeMapModuleEntry*
+auto TypeMapper::find_module_entry (const uint8_t *mvid) noexcept -> const TypeMapModule*
 {
-	if (map == nullptr) {
+	const TypeMapModule *module = last_module;
+	if (module != nullptr && compare_mvid (mvid, *module) == 0) {
+		return module;
+	}
+
+	if (managed_to_java_module_index_size > 0u) [[likely]] {
+		module = find_module_entry_hashed (mvid);
+	} else {
+		module = find_module_entry_sorted (mvid, managed_to_java_map, managed_to_java_map_module_count);
+	}
+
+	if (module != nullptr) [[likely]] {
+		last_module = module;
+	}
+
+	return module;
+}
+
+[[gnu::always_inline]]
+auto TypeMapper::uses_64bit_name_hashes () noexcept -> bool
+{
+	return typemap_name_hash_bits == 64u;
+}
+
+template<typename THash> [[gnu::always_inline]]
+auto TypeMapper::find_managed_to_java_map_entry (THash name_hash, const char *type_name, size_t type_name_length, const TypeMapModuleEntry *map, const THash *hashes, size_t entry_count, bool eytzinger_layout) noexcept -> const TypeMapModuleEntry*
+{
+	if (map == nullptr || hashes == nullptr) {
 		return nullptr;
 	};
 
-	auto less_than = [](TypeMapModuleEntry const& entry, hash_t key) -> bool {
-		return entry.managed_type_name_hash < key;
+	auto less_than = [](THash const& entry, THash key) -> bool {
+		return entry < key;
 	};
 
-	size_t idx = Search::lower_bound<TypeMapModuleEntry, hash_t, less_than> (name_hash, map, entry_count);
-	while (idx < entry_count && map[idx].managed_type_name_hash == name_hash) {
+	auto matches = [&](size_t idx) -> bool {
 		TypeMapModuleEntry const& entry = map[idx];
 		const char *managed_type_name = &managed_type_names[entry.managed_type_name_index];
-		if (same_string (managed_type_name, entry.managed_type_name_length, type_name, type_name_length)) {
-			return &entry;
+		return TypeMapNameHash<THash>::names_match (managed_type_name, entry.managed_type_name_length, type_name, type_name_length);
+	};
+
+	if (eytzinger_layout) {
+		size_t idx = Search::eytzinger_lower_bound<THash, THash, less_than> (name_hash, hashes, entry_count);
+		for (; idx < entry_count && hashes[idx] == name_hash; idx = Search::eytzinger_next (idx, entry_count)) {
+			if (matches (idx)) {
+				return &map[idx];
+			}
+		}
+
+		return nullptr;
+	}
+
+	size_t idx = Search::lower_bound<THash, THash, less_than> (name_hash, hashes, entry_count);
+	while (idx < entry_count && hashes[idx] == name_hash) {
+		if (matches (idx)) {
+			return &map[idx];
 		}
 		idx++;
 	}
@@ -211,27 +426,130 @@ auto TypeMapper::find_managed_to_java_map_entry (hash_t name_hash, const char *t
 	return nullptr;
 }
 
-[[gnu::always_inline]]
-auto TypeMapper::managed_to_java_release (const char *typeName, const uint8_t *mvid) noexcept -> const char*
+// The MVID is random, so its first 8 bytes are as good a source of entropy as any
+template<typename THash> [[gnu::always_inline]]
+auto TypeMapper::managed_to_java_cache_slot (const uint8_t *mvid, THash name_hash) noexcept -> size_t
 {
-	const TypeMapModule *match = find_module_entry (mvid, managed_to_java_map, managed_to_java_map_module_count);
-	if (match == nullptr) {
-		if (mvid == nullptr) {
-			log_warn (LOG_ASSEMBLY, "typemap: no mvid specified in call to typemap_managed_to_java"sv);
-		} else {
-			log_info (LOG_ASSEMBLY, "typemap: module matching MVID [{}] not found."sv, MonoGuidString (mvid).c_str ());
+	uint64_t mvid_bits;
+	memcpy (&mvid_bits, mvid, sizeof (mvid_bits));
+
+	uint64_t key = mvid_bits ^ TypeMapNameHash<THash>::cache_key (name_hash);
+	return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> (64 - MANAGED_TO_JAVA_CACHE_SIZE_BITS));
+}
+
+// Neither the MVID nor the type name pointers passed from managed code are stable (the former points to a reused buffer,
+// the latter to a marshaled copy of the name), so the cache is keyed on their contents. A slot is a hit only if both the
+// module MVID and the managed type name recorded in libxamarin-app.so match those being looked up.
+template<typename THash> [[gnu::always_inline]]
+auto TypeMapper::managed_to_java_cache_lookup (const uint8_t *mvid, THash name_hash, const char *type_name, size_t type_name_length) noexcept -> const char*
+{
+	using Hash = TypeMapNameHash<THash>;
+
+	size_t const home_slot = managed_to_java_cache_slot (mvid, name_hash);
+	for (size_t i = 0uz; i < MANAGED_TO_JAVA_CACHE_PROBE_LIMIT; i++) {
+		// Relaxed ordering is enough, the slot refers only to the immutable data in libxamarin-app.so
+		uint64_t slot = __atomic_load_n (&managed_to_java_cache[(home_slot + i) & (MANAGED_TO_JAVA_CACHE_SIZE - 1uz)], __ATOMIC_RELAXED);
+		if (slot == 0u) {
+			// Slots are never cleared, so the entry can't be any further
+			return nullptr;
+		}
+
+		TypeMapModule const& module = managed_to_java_map[static_cast<uint32_t>(slot >> 32) - 1u];
+		auto entry_index = static_cast<uint32_t>(slot);
+		bool const is_duplicate = (entry_index & MANAGED_TO_JAVA_CACHE_DUPLICATE_FLAG) != 0u;
+		entry_index &= ~MANAGED_TO_JAVA_CACHE_DUPLICATE_FLAG;
+
+		TypeMapModuleEntry const& entry = is_duplicate ? modules_duplicates_data[entry_index] : modules_map_data[entry_index];
+		THash const entry_hash = is_duplicate ? Hash::modules_duplicates ()[entry_index] : Hash::modules_map ()[entry_index];
+		if (entry_hash != name_hash || compare_mvid (mvid, module) != 0) {
+			continue;
 		}
+
+		if (!Hash::names_match (&managed_type_names[entry.managed_type_name_index], entry.managed_type_name_length, type_name, type_name_length)) {
+			continue;
+		}
+
+		// Only entries which passed validation in `managed_to_java_release` are ever stored
+		return &java_type_names[java_to_managed_map[entry.java_map_index].java_name_index];
+	}
+
+	return nullptr;
+}
+
+template<typename THash> [[gnu::always_inline]]
+void TypeMapper::managed_to_java_cache_store (const uint8_t *mvid, THash name_hash, const TypeMapModule *module, const TypeMapModuleEntry *entry, bool is_duplicate) noexcept
+{
+	auto entry_index = static_cast<uint32_t>(entry - (is_duplicate ? modules_duplicates_data : modules_map_data));
+	if (is_duplicate) {
+		entry_index |= MANAGED_TO_JAVA_CACHE_DUPLICATE_FLAG;
+	}
+
+	uint64_t const value = (static_cast<uint64_t>(module - managed_to_java_map + 1) << 32) | entry_index;
+	size_t const home_slot = managed_to_java_cache_slot (mvid, name_hash);
+	for (size_t i = 0uz; i < MANAGED_TO_JAVA_CACHE_PROBE_LIMIT; i++) {
+		uint64_t expected = 0u;
+		uint64_t *slot = &managed_to_java_cache[(home_slot + i) & (MANAGED_TO_JAVA_CACHE_SIZE - 1uz)];
+		if (__atomic_compare_exchange_n (slot, &expected, value, false /* weak */, __ATOMIC_RELAXED, __ATOMIC_RELAXED) || expected == value) {
+			return;
+		}
+	}
+
+	// All the probed slots are taken, evict whatever was in the first one. Readers validate every slot they look at,
+	// so it doesn't matter if they see the old or the new value.
+	__atomic_store_n (&managed_to_java_cache[home_slot], value, __ATOMIC_RELAXED);
+}
+
+template<typename THash> [[gnu::always_inline]]
+auto TypeMapper::managed_to_java_release (const char *typeName, size_t type_name_length, THash name_hash, const uint8_t *mvid) noexcept -> const char*
+{
+	using Hash = TypeMapNameHash<THash>;
+
+	if (mvid == nullptr) [[unlikely]] {
+		log_warn (LOG_ASSEMBLY, "typemap: no mvid specified in call to typemap_managed_to_java"sv);
+		return nullptr;
+	}
+
+	if (const char *cached = managed_to_java_cache_lookup (mvid, name_hash, typeName, type_name_length); cached != nullptr) {
+		if (FastTiming::enabled ()) [[unlikely]] {
+			internal_timing.increment_counter (TimingCounterKind::ManagedToJavaCacheHits);
+		}
+
+		log_debug (
+			LOG_ASSEMBLY,
+			"typemap: managed type '{}' (hash {:x}) in module [{}] corresponds to Java type '{}' (cached)"sv,
+			optional_string (typeName),
+			name_hash,
+			MonoGuidString (mvid).c_str (),
+			cached
+		);
+		return cached;
+	}
+
+	if (FastTiming::enabled ()) [[unlikely]] {
+		internal_timing.increment_counter (TimingCounterKind::ManagedToJavaCacheMisses);
+	}
+
+	const TypeMapModule *match = find_module_entry (mvid);
+	if (match == nullptr) {
+		log_info (LOG_ASSEMBLY, "typemap: module matching MVID [{}] not found."sv, MonoGuidString (mvid).c_str ());
 		return nullptr;
 	}
 
 	log_debug (LOG_ASSEMBLY, "typemap: found module matching MVID [{}]"sv, MonoGuidString (mvid).c_str ());
-	size_t type_name_length = strlen (typeName);
-	hash_t name_hash = crc32_hash (typeName, type_name_length);
 
 	// We implicitly trust the build process that the indexes are correct. This is by design, the libxamarin-app.so built
 	// with the application is immutable and the build process made sure that the data in it matches the application.
 	const TypeMapModuleEntry *const map = &modules_map_data[match->map_index];
-	const TypeMapModuleEntry *entry = find_managed_to_java_map_entry (name_hash, typeName, type_name_length, map, match->entry_count);
+	const TypeMapModuleEntry *entry = find_managed_to_java_map_entry (
+		name_hash,
+		typeName,
+		type_name_length,
+		map,
+		&Hash::modules_map ()[match->map_index],
+		match->entry_count,
+		(match->flags & TYPEMAP_MODULE_EYTZINGER_MAP_FLAG) != 0u
+	);
+	bool found_in_duplicates = false;
 	if (entry == nullptr) [[unlikely]] {
 		if (match->duplicate_count > 0 && match->duplicate_map_index < std::numeric_limits<decltype (match->duplicate_map_index)>::max ()) {
 			log_debug (
@@ -243,7 +561,16 @@ auto TypeMapper::managed_to_java_release (const char *typeName, const uint8_t *m
 			);
 
 			const TypeMapModuleEntry *const duplicate_map = &modules_duplicates_data[match->duplicate_map_index];
-			entry = find_managed_to_java_map_entry (name_hash, typeName, type_name_length, duplicate_map, match->duplicate_count);
+			entry = find_managed_to_java_map_entry (
+				name_hash,
+				typeName,
+				type_name_length,
+				duplicate_map,
+				&Hash::modules_duplicates ()[match->duplicate_map_index],
+				match->duplicate_count,
+				(match->flags & TYPEMAP_MODULE_EYTZINGER_DUPLICATE_MAP_FLAG) != 0u
+			);
+			found_in_duplicates = entry != nullptr;
 		}
 
 		if (entry == nullptr) {
@@ -303,13 +630,38 @@ auto TypeMapper::managed_to_java_release (const char *typeName, const uint8_t *m
 		ret
 	);
 
+	managed_to_java_cache_store (mvid, name_hash, match, entry, found_in_duplicates);
 	return ret;
 }
 #endif // def RELEASE
 
-[[gnu::flatten]]
+auto TypeMapper::hash_name (const char *name, size_t name_length) noexcept -> uint64_t
+{
 #if defined(RELEASE)
+	if (uses_64bit_name_hashes ()) {
+		return xxh3_hash (name, name_length);
+	}
+#endif
+
+	return crc32_hash (name, name_length);
+}
+
+#if defined(RELEASE)
+[[gnu::flatten]]
 auto TypeMapper::managed_to_java (const char *typeName, const uint8_t *mvid) noexcept -> const char*
+{
+	if (typeName == nullptr) [[unlikely]] {
+		return managed_to_java (nullptr, 0uz, 0u, mvid);
+	}
+
+	size_t type_name_length = strlen (typeName);
+	return managed_to_java (typeName, type_name_length, hash_name (typeName, type_name_length), mvid);
+}
+#endif
+
+[[gnu::flatten]]
+#if defined(RELEASE)
+auto TypeMapper::managed_to_java (const char *typeName, size_t type_name_length, uint64_t type_name_hash, const uint8_t *mvid) noexcept -> const char*
 #else
 auto TypeMapper::managed_to_java (const char *typeName, const char *assemblyFullName) noexcept -> const char*
 #endif
@@ -325,7 +677,9 @@ auto TypeMapper::managed_to_java (const char *typeName, const char *assemblyFull
 	}
 
 #if defined(RELEASE)
-	const char *ret = managed_to_java_release (typeName, mvid);
+	const char *ret = uses_64bit_name_hashes ()
+		? managed_to_java_release (typeName, type_name_length, type_name_hash, mvid)
+		: managed_to_java_release (typeName, type_name_length, static_cast<hash_t>(type_name_hash), mvid);
 #else
 	if (assemblyFullName == nullptr) [[unlikely]] {
 		log_warnf (LOG_ASSEMBLY, "typemap: assembly full name not specified in typemap_managed_to_java");
@@ -351,7 +705,9 @@ auto TypeMapper::java_to_managed_debug (const char *java_type_name, char const**
 	}
 
 	// We need to find entry matching the Java type name, which will then...
-	ssize_t idx = find_index_by_name (java_type_name, type_map.java_to_managed, type_map_java_type_names, JAVA, MANAGED);
+	ssize_t idx = type_map_name_index_size > 0u
+		? find_index_by_name_index (java_type_name, type_map.java_to_managed, type_map_java_to_managed_index, type_map_java_type_names, JAVA, MANAGED)
+		: find_index_by_name (java_type_name, type_map.java_to_managed, type_map_java_type_names, JAVA, MANAGED);
 
 	// ..provide us with the managed type name index
 	const char *name = index_to_name (idx, java_type_name, type_map.java_to_managed, type_map_managed_type_names, JAVA, MANAGED);
@@ -379,18 +735,22 @@ auto TypeMapper::java_to_managed_debug (const char *java_type_name, char const**
 }
 #else // def DEBUG
 
-[[gnu::always_inline]]
-auto TypeMapper::find_java_to_managed_entry (hash_t name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*
+template<typename THash> [[gnu::always_inline]]
+auto TypeMapper::match_java_to_managed_entry (size_t idx, THash name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*
 {
-	auto less_than = [](hash_t const& entry, hash_t key) -> bool {
-		return entry < key;
-	};
+	using Hash = TypeMapNameHash<THash>;
+	const THash *hashes = Hash::java_to_managed ();
+
+	// The perfect hash table leads to the first entry with the key of `name_hash`, which for the 64-bit hashes is just their
+	// upper half. Skip the entries with the same key but smaller hashes, those with the same hash follow.
+	while (idx < java_type_count && hashes[idx] < name_hash && Hash::perfect_hash_key (hashes[idx]) == Hash::perfect_hash_key (name_hash)) {
+		idx++;
+	}
 
-	size_t idx = Search::lower_bound<hash_t, hash_t, less_than> (name_hash, java_to_managed_hashes, java_type_count);
-	while (idx < java_type_count && java_to_managed_hashes[idx] == name_hash) {
+	while (idx < java_type_count && hashes[idx] == name_hash) {
 		TypeMapJava const& entry = java_to_managed_map[idx];
 		const char *mapped_java_type_name = &java_type_names[entry.java_name_index];
-		if (same_string (mapped_java_type_name, entry.java_name_length, java_type_name, java_type_name_length)) {
+		if (Hash::names_match (mapped_java_type_name, entry.java_name_length, java_type_name, java_type_name_length)) {
 			return &entry;
 		}
 		idx++;
@@ -399,8 +759,41 @@ auto TypeMapper::find_java_to_managed_entry (hash_t name_hash, const char *java_
 	return nullptr;
 }
 
-[[gnu::flatten]]
-auto TypeMapper::java_to_managed_release (const char *java_type_name, char const** assembly_name, uint32_t *managed_type_token_id) noexcept -> bool
+template<typename THash> [[gnu::always_inline]]
+auto TypeMapper::find_java_to_managed_entry_perfect_hash (THash name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*
+{
+	hash_t key = TypeMapNameHash<THash>::perfect_hash_key (name_hash);
+	uint32_t bucket = MinimalPerfectHash::bucket (key, java_to_managed_perfect_hash_bucket_count);
+	uint32_t slot = MinimalPerfectHash::slot (key, java_to_managed_perfect_hash_displacements[bucket], java_to_managed_perfect_hash_slot_count);
+
+	// Names which aren't in the map land in some slot as well, the hash check in `match_java_to_managed_entry` rejects them
+	return match_java_to_managed_entry (java_to_managed_perfect_hash_slots[slot], name_hash, java_type_name, java_type_name_length);
+}
+
+template<typename THash> [[gnu::always_inline]]
+auto TypeMapper::find_java_to_managed_entry_sorted (THash name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*
+{
+	auto less_than = [](THash const& entry, THash key) -> bool {
+		return entry < key;
+	};
+
+	size_t idx = Search::lower_bound<THash, THash, less_than> (name_hash, TypeMapNameHash<THash>::java_to_managed (), java_type_count);
+	return match_java_to_managed_entry (idx, name_hash, java_type_name, java_type_name_length);
+}
+
+template<typename THash>
+auto TypeMapper::find_java_to_managed_entry (THash name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*
+{
+	// The build tasks leave the perfect hash table empty if they couldn't build it, the sorted hashes are always there
+	if (java_to_managed_perfect_hash_bucket_count > 0 && java_to_managed_perfect_hash_slot_count > 0) [[likely]] {
+		return find_java_to_managed_entry_perfect_hash (name_hash, java_type_name, java_type_name_length);
+	}
+
+	return find_java_to_managed_entry_sorted (name_hash, java_type_name, java_type_name_length);
+}
+
+template<typename THash> [[gnu::flatten]]
+auto TypeMapper::java_to_managed_release (const char *java_type_name, size_t java_type_name_length, THash name_hash, char const** assembly_name, uint32_t *managed_type_token_id) noexcept -> bool
 {
 	if (java_type_name == nullptr || assembly_name == nullptr || managed_type_token_id == nullptr) [[unlikely]] {
 		if (java_type_name == nullptr) {
@@ -433,8 +826,6 @@ auto TypeMapper::java_to_managed_release (const char *java_type_name, char const
 		return false;
 	}
 
-	size_t java_type_name_length = strlen (java_type_name);
-	hash_t name_hash = crc32_hash (java_type_name, java_type_name_length);
 	TypeMapJava const* java_entry = find_java_to_managed_entry (name_hash, java_type_name, java_type_name_length);
 	if (java_entry == nullptr) {
 		log_info (
@@ -466,6 +857,19 @@ auto TypeMapper::java_to_managed_release (const char *java_type_name, char const
 
 [[gnu::flatten]]
 auto TypeMapper::java_to_managed (const char *java_type_name, char const** assembly_name, uint32_t *managed_type_token_id) noexcept -> bool
+{
+#if defined(RELEASE)
+	if (java_type_name != nullptr) [[likely]] {
+		size_t java_type_name_length = strlen (java_type_name);
+		return java_to_managed (java_type_name, java_type_name_length, hash_name (java_type_name, java_type_name_length), assembly_name, managed_type_token_id);
+	}
+#endif
+
+	return java_to_managed (java_type_name, 0uz, 0u, assembly_name, managed_type_token_id);
+}
+
+[[gnu::flatten]]
+auto TypeMapper::java_to_managed (const char *java_type_name, [[maybe_unused]] size_t java_type_name_length, [[maybe_unused]] uint64_t java_type_name_hash, char const** assembly_name, uint32_t *managed_type_token_id) noexcept -> bool
 {
 	log_debug (LOG_ASSEMBLY, "java_to_managed: looking up type '{}'"sv, optional_string (java_type_name));
 	if (FastTiming::enabled ()) [[unlikely]] {
@@ -479,7 +883,9 @@ auto TypeMapper::java_to_managed (const char *java_type_name, char const** assem
 
 	bool ret;
 #if defined(RELEASE)
-	ret = java_to_managed_release (java_type_name, assembly_name, managed_type_token_id);
+	ret = uses_64bit_name_hashes ()
+		? java_to_managed_release (java_type_name, java_type_name_length, java_type_name_hash, assembly_name, managed_type_token_id)
+		: java_to_managed_release (java_type_name, java_type_name_length, static_cast<hash_t>(java_type_name_hash), assembly_name, managed_type_token_id);
 #else
 	ret = java_to_managed_debug (java_type_name, assembly_name, managed_type_token_id);
 #endif
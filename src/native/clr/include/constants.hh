@@ -65,6 +65,13 @@ namespace xamarin::android {
 		static inline constexpr std::string_view DEBUG_MONO_WREF_PROPERTY         { "debug.mono.wref" };
 		static constexpr std::string_view DEBUG_MONO_TIMING                       { "debug.mono.timing" };
 
+		/* Android properties overriding the assembly store settings at runtime, for A/B benchmarking */
+		static constexpr std::string_view DEBUG_NET_ASMCACHE_PROPERTY             { "debug.net.asmcache" };
+		static constexpr std::string_view DEBUG_NET_ASMCACHE_MAXSIZE_PROPERTY     { "debug.net.asmcache.maxsize" };
+		static constexpr std::string_view DEBUG_NET_ASMCACHE_VERIFY_PROPERTY      { "debug.net.asmcache.verify" };
+		static constexpr std::string_view DEBUG_NET_ASMDECOMPRESS_PROPERTY        { "debug.net.asmdecompress" };
+		static constexpr std::string_view DEBUG_NET_ASMPROFILE_PROPERTY           { "debug.net.asmprofile" };
+
 		static constexpr std::string_view LOG_CATEGORY_NAME_NONE                  { "*none*" };
 		static constexpr std::string_view LOG_CATEGORY_NAME_MONODROID             { "monodroid" };
 		static constexpr std::string_view LOG_CATEGORY_NAME_MONODROID_ASSEMBLY    { "monodroid-assembly" };
@@ -104,6 +111,8 @@ namespace xamarin::android {
 
 	public:
 		static constexpr std::string_view assembly_store_file_name { "libassembly-store.so" };
+		// Followed by the store number and `dso_suffix`
+		static constexpr std::string_view assembly_store_secondary_file_name_prefix { "libassembly-store-" };
 
 		static constexpr auto split_config_abi_apk_name = concat_string_views<split_config_abi_apk_name_size> (split_config_prefix, android_abi, split_config_extension);
 		static constexpr std::string_view base_apk_name = { "/base.apk" };
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace xamarin::android {
+	// Records which assemblies (and which byte ranges of the assembly store) are touched during the
+	// first moments of an application launch and persists the list in the app's code-cache
+	// directory. Subsequent launches of the same store (identified by its content ID) replay the
+	// list on a background thread with `madvise (MADV_WILLNEED)`, so that the store pages are
+	// (mostly) resident by the time CoreCLR asks for the assemblies. Disabled unless the
+	// `debug.net.asmprofile` system property is set to 1.
+	class AssemblyStoreProfile
+	{
+		static constexpr uint32_t PROFILE_FILE_MAGIC = 0x50534158; // 'XASP', little-endian
+		static constexpr uint32_t PROFILE_FILE_FORMAT_VERSION = 1;
+		static constexpr uint32_t RECORDING_WINDOW_MS = 2000;
+		static constexpr uint32_t INVALID_DESCRIPTOR_INDEX = UINT32_MAX;
+
+	public:
+		// Called by `AssemblyStore::configure_from_payload` once the store payload is known. Loads the
+		// profile recorded by a previous launch (if any) and arms the recorder.
+		static void initialize (const uint8_t *store_start, uint64_t content_id, uint32_t assembly_count) noexcept;
+
+		// Starts the background thread which prefetches pages of the previously recorded assemblies and,
+		// once the recording window expires, persists the profile of the current launch.
+		static void start_background_work () noexcept;
+
+		[[gnu::always_inline]]
+		static void record_assembly_load (uint32_t descriptor_index) noexcept
+		{
+			if (!__atomic_load_n (&recording, __ATOMIC_ACQUIRE)) [[likely]] {
+				return;
+			}
+
+			record (descriptor_index);
+		}
+
+		// Store descriptor indices of the assemblies loaded during startup of the previous launch, in the
+		// order in which they were loaded. Empty if there's no valid profile.
+		static auto get_predicted_load_order () noexcept -> std::span<const uint32_t>
+		{
+			return { saved_order.get (), saved_entry_count };
+		}
+
+	private:
+		struct [[gnu::packed]] ProfileFileHeader final
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t content_id;
+			uint32_t entry_count;
+			uint32_t recording_window_ms;
+		};
+
+		struct [[gnu::packed]] ProfileFileEntry final
+		{
+			uint32_t descriptor_index;
+			uint32_t data_offset;
+			uint32_t data_size;
+		};
+
+		static void record (uint32_t descriptor_index) noexcept;
+		static void load_saved_profile () noexcept;
+		static void prefetch_saved_profile () noexcept;
+		static void persist_recorded_profile () noexcept;
+		static auto recorded_profile_differs () noexcept -> bool;
+		static auto background_thread_entry (void *arg) noexcept -> void*;
+
+	private:
+		static inline const uint8_t *store_data_start = nullptr;
+		static inline uint64_t store_content_id = 0;
+		static inline uint32_t store_assembly_count = 0;
+		static inline std::string profile_path {};
+
+		static inline std::unique_ptr<uint32_t[]> saved_order {};
+		static inline uint32_t saved_entry_count = 0;
+
+		static inline bool recording = false;
+		static inline std::unique_ptr<uint32_t[]> recorded_order {};
+		static inline std::unique_ptr<uint8_t[]> recorded_seen {};
+		static inline uint32_t recorded_count = 0;
+	};
+}
@@ -1,19 +1,31 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <string_view>
 #include <tuple>
 
 #include <xamarin-app.hh>
+#include <runtime-base/minimal-perfect-hash.hh>
 #include <runtime-base/strings.hh>
+#include <runtime-base/zstd.hh>
 
 namespace xamarin::android {
 	class AssemblyStore
 	{
+		static constexpr uint32_t MAX_BACKGROUND_DECOMPRESSION_WORKERS = 2;
+		static constexpr size_t DECOMPRESSION_LOCK_STRIPES = 16uz;
+
+	public:
+		// Returns the payload of the secondary store with the given (1-based) number. Must not return if the store
+		// can't be mapped.
+		using secondary_store_loader_fn = const void* (*)(uint32_t store_number) noexcept;
+
 	public:
 		static auto open_assembly (std::string_view const& name, int64_t &size) noexcept -> void*;
 
@@ -21,22 +33,131 @@ namespace xamarin::android {
 		// dlopen()+dlsym() of the `_assembly_store` dynamic symbol). The payload is mapped
 		// read-only and is never modified, so it (and every pointer derived from it) is `const`.
 		// `get_full_store_path` is invoked only to build diagnostics if the payload turns out
-		// to be invalid.
-		static void configure_from_payload (const void *payload_start, const std::function<std::string()>& get_full_store_path) noexcept;
+		// to be invalid. `load_secondary_store` is called, at most once per store, the first
+		// time an assembly is looked up in one of the secondary stores the primary store lists.
+		static void configure_from_payload (const void *payload_start, const std::function<std::string()>& get_full_store_path, secondary_store_loader_fn load_secondary_store) noexcept;
+
+		// Starts a small pool of threads which decompress the compressed assemblies that are expected
+		// to be loaded during startup (as recorded by `AssemblyStoreProfile` or, failing that, in the
+		// `mapping_index` order), ahead of the runtime asking for them. The workers stop as soon as
+		// startup is marked as done. Must be called after `configure_from_payload`.
+		static void start_background_decompression () noexcept;
+
+		// Lets the decompressed-assembly cache remove the files left behind by the previous versions of the
+		// application and trim its pack to the size limit, in the background. Called once startup is done.
+		static void start_cache_maintenance () noexcept;
+
+		// Logs, for every uncompressed assembly mapped copy-on-write, how many of its pages were
+		// written to by the runtime (and thus are no longer shared with the store file).
+		static void log_copy_on_write_stats () noexcept;
+
+		// Logs how many pages of the assembly store are resident in memory, separately for the assembly images
+		// and for their debug and config data.
+		static void log_residency_stats () noexcept;
+
+	private:
+		// The index of one of the stores the assemblies are split between
+		struct StoreIndex final
+		{
+			const AssemblyStoreIndexEntry *hashes;
+			// Perfect hash table displacements (v7 stores only, `nullptr` for stores with a sorted index).
+			// Not necessarily 4-byte aligned.
+			const uint8_t *perfect_hash_displacements;
+			uint32_t perfect_hash_bucket_count;
+			uint64_t content_id;
+		};
+
+		struct SecondaryStore final
+		{
+			AssemblyStoreRuntimeData data;
+			StoreIndex index;
+			// As recorded in the primary store, so that a store left over from another version of the application
+			// isn't used by mistake
+			uint64_t expected_content_id;
+			bool mounted;
+		};
 
 	private:
 		static void set_assembly_data_and_size (uint8_t* source_assembly_data, uint32_t source_assembly_data_size, uint8_t*& dest_assembly_data, uint32_t& dest_assembly_data_size) noexcept;
 
 		// Returns a tuple of <assembly_data_pointer, data_size>
 		static auto get_assembly_data (AssemblyStoreSingleAssemblyRuntimeData const& e, std::string_view const& name) noexcept -> std::tuple<uint8_t*, uint32_t>;
-		static auto find_assembly_store_entry (std::string_view const& name, hash_t hash, const AssemblyStoreIndexEntry *entries, size_t entry_count) noexcept -> const AssemblyStoreIndexEntry*;
+		static auto get_compressed_descriptor (const CompressedAssemblyHeader *header) noexcept -> CompressedAssemblyDescriptor&;
+
+		[[gnu::always_inline]]
+		static auto is_compressed (const CompressedAssemblyHeader *header) noexcept -> bool
+		{
+			return header->magic == COMPRESSED_DATA_MAGIC;
+		}
+
+		// Decompresses the data following `header` with the codec the header names, using the store dictionary
+		// if the header asks for it. Aborts the application if the data is corrupt, returns the decompressed size.
+		static auto decompress_data (const CompressedAssemblyHeader *header, uint8_t *dest, size_t dest_size, const void *compressed_data, size_t compressed_data_size, std::string_view const& name) noexcept -> size_t;
+		static auto get_thread_decompression_context () noexcept -> ZSTD_DCtx*;
+		static void load_dictionary (const uint8_t *dictionary_section, const std::function<std::string()>& get_full_store_path) noexcept;
+		static void configure_debug_data_region (const uint8_t *data_start, const uint8_t *region_section) noexcept;
+
+		// Validates the header of the store at `payload_start` and fills in `store` and `index`. Returns a pointer
+		// to the first of the optional sections which follow the assembly names.
+		static auto map_store_index (const void *payload_start, AssemblyStoreRuntimeData &store, StoreIndex &index, const std::function<std::string()>& get_full_store_path) noexcept -> const uint8_t*;
+		static void configure_secondary_stores (const uint8_t *secondary_stores_section, secondary_store_loader_fn load_secondary_store) noexcept;
+		static auto mount_secondary_store (uint32_t store_number) noexcept -> SecondaryStore&;
+		static auto find_in_secondary_stores (std::string_view const& name, hash_t hash, const AssemblyStoreRuntimeData *&store) noexcept -> const AssemblyStoreIndexEntry*;
+		// Must be called with the decompression lock of the descriptor held. Returns `true` if the data came from the
+		// on-device decompressed-assembly cache.
+		static auto decompress_assembly_locked (const CompressedAssemblyHeader *header, uint32_t compressed_data_size, std::string_view const& name) noexcept -> bool;
+		// Assemblies are decompressed into disjoint areas of `uncompressed_assemblies_data_buffer`, so
+		// there's no need to serialize decompression of unrelated assemblies. Locks are striped over
+		// the compressed assembly descriptor index.
+		[[gnu::always_inline]]
+		static auto get_decompression_lock (uint32_t compressed_descriptor_index) noexcept -> std::mutex&
+		{
+			return assembly_decompress_locks[compressed_descriptor_index % DECOMPRESSION_LOCK_STRIPES];
+		}
+
+		static void lock_decompression (std::unique_lock<std::mutex> &lock) noexcept;
+		static void decompress_in_background (uint32_t descriptor_index) noexcept;
+		static auto background_decompression_worker (void *arg) noexcept -> void*;
+		static auto find_assembly_store_entry (std::string_view const& name, hash_t hash, AssemblyStoreRuntimeData const& store, StoreIndex const& index) noexcept -> const AssemblyStoreIndexEntry*;
+		static auto find_assembly_store_entry_sorted (std::string_view const& name, hash_t hash, AssemblyStoreRuntimeData const& store, StoreIndex const& index) noexcept -> const AssemblyStoreIndexEntry*;
+		static auto find_assembly_store_entry_perfect_hash (std::string_view const& name, hash_t hash, AssemblyStoreRuntimeData const& store, StoreIndex const& index) noexcept -> const AssemblyStoreIndexEntry*;
+
+		// Used to disambiguate CRC32 hash collisions in the store index. The name isn't NUL-terminated.
+		[[gnu::always_inline]]
+		static auto get_assembly_name (AssemblyStoreRuntimeData const& store, uint32_t descriptor_index) noexcept -> std::string_view
+		{
+			AssemblyStoreEntryDescriptor const& desc = store.assemblies[descriptor_index];
+			return {reinterpret_cast<const char*>(store.data_start + desc.name_offset), desc.name_length};
+		}
+
+		[[gnu::always_inline]]
+		static auto get_assembly_name (uint32_t descriptor_index) noexcept -> std::string_view
+		{
+			return get_assembly_name (assembly_store, descriptor_index);
+		}
 
 	private:
-		static inline const AssemblyStoreIndexEntry *assembly_store_hashes = nullptr;
-		// Assembly names indexed by `AssemblyStoreIndexEntry::descriptor_index`, used to disambiguate
-		// CRC32 hash collisions in the store index. Built once when the store is mapped.
-		static inline std::string_view *assembly_store_names = nullptr;
-		static inline uint64_t assembly_store_content_id = 0;
-		static inline std::mutex  assembly_decompress_mutex {};
+		// The primary store is described by the `assembly_store` global
+		static inline StoreIndex primary_index {};
+
+		static inline std::unique_ptr<SecondaryStore[]> secondary_stores {};
+		static inline uint32_t secondary_store_count = 0;
+		static inline const AssemblyStoreSecondaryIndexEntry *secondary_index = nullptr;
+		static inline uint32_t secondary_index_entry_count = 0;
+		static inline secondary_store_loader_fn secondary_store_loader = nullptr;
+		static inline std::mutex secondary_stores_lock {};
+
+		// Digested once, when the store is mapped, and shared by all the threads which decompress assemblies.
+		// `nullptr` if the store doesn't contain a dictionary.
+		static inline ZSTD_DDict *assembly_store_dictionary = nullptr;
+		static inline uint32_t assembly_store_dictionary_id = 0;
+		static inline std::array<std::mutex, DECOMPRESSION_LOCK_STRIPES> assembly_decompress_locks {};
+
+		// Store descriptor indices of the compressed assemblies to decompress in the background, in
+		// the order in which they're expected to be needed.
+		static inline std::unique_ptr<uint32_t[]> background_decompression_queue {};
+		static inline uint32_t background_decompression_queue_length = 0;
+		static inline uint32_t background_decompression_next = 0;
+		static inline uint32_t background_decompression_workers = 0;
 	};
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <string_view>
 
 #include <jni.h>
@@ -39,6 +40,8 @@ namespace xamarin::android {
 
 		static void gather_assemblies_and_libraries (jstring_array_wrapper& runtimeApks, bool have_split_apks);
 		static void map_assembly_store_via_dlopen (const char *store_path) noexcept;
+		static auto dlopen_assembly_store (const char *store_path) noexcept -> const void*;
+		static auto load_secondary_assembly_store (uint32_t store_number) noexcept -> const void*;
 		static void scan_filesystem_for_assemblies_and_libraries () noexcept;
 
 		static bool clr_external_assembly_probe (const char *path, void **data_start, int64_t *size) noexcept;
@@ -56,6 +59,9 @@ namespace xamarin::android {
 		static inline unsigned int domain_id = 0;
 		static inline std::shared_ptr<Timing> _timing{};
 		static inline bool found_assembly_store = false;
+		// Directory (with the trailing slash) the primary assembly store was loaded from, empty if it was loaded
+		// by its name alone. Secondary stores are loaded from the same place.
+		static inline std::string assembly_store_dir{};
 		static inline jnienv_register_jni_natives_fn jnienv_register_jni_natives = nullptr;
 		static inline jnienv_propagate_uncaught_exception_fn jnienv_propagate_uncaught_exception = nullptr;
 
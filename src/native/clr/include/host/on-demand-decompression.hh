@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace xamarin::android {
+	// Experimental, enabled at build time with `$(_AndroidAssemblyStoreOnDemandDecompression)`.
+	//
+	// Assemblies compressed as a sequence of independent Zstandard frames, followed by a seek table
+	// (the Zstandard "seekable format"), don't have to be decompressed in their entirety before they
+	// are handed to the runtime. Instead, the runtime gets an anonymous memory region registered with
+	// `userfaultfd`, and a handler thread decompresses the chunk containing the faulting address the
+	// first time any of its pages is touched. Startup usually needs just the metadata and a handful
+	// of methods of an assembly, so most of a large image is never decompressed at all.
+	//
+	// Should `userfaultfd` be unavailable (e.g. denied by the kernel configuration or the SELinux
+	// policy), the assembly is decompressed eagerly, its frames in parallel (see ParallelDecompression).
+	// Since the seek table is stored in a skippable frame, the data is a valid Zstandard stream either way.
+	class OnDemandDecompression
+	{
+		static constexpr uint32_t SKIPPABLE_FRAME_MAGIC = 0x184D2A5E;
+		static constexpr uint32_t SEEKABLE_MAGIC = 0x8F92EAB1;
+		static constexpr uint8_t SEEK_TABLE_CHECKSUM_FLAG = 0x80;
+
+	public:
+		// Location of the frames of an assembly compressed in the seekable format
+		struct SeekTable
+		{
+			uint32_t       image_size;
+			uint32_t       chunk_size;      // decompressed size of every frame but the last one
+			uint32_t       frame_count;
+			const uint8_t *frames;
+			std::unique_ptr<uint32_t[]> frame_offsets; // `frame_count + 1` offsets of the frames in `frames`
+		};
+
+		// Returns `true` if the data ends with a seek table, which still needs to be validated with `read_seek_table`
+		static auto is_seekable (const uint8_t *compressed_data, uint32_t compressed_size) noexcept -> bool;
+		static auto read_seek_table (SeekTable &seek_table, const uint8_t *compressed_data, uint32_t compressed_size, uint32_t uncompressed_size) noexcept -> bool;
+
+		// Returns a pointer to the region the assembly will be materialized in, or `nullptr` if it has to
+		// be decompressed eagerly. The region remains valid for the lifetime of the process.
+		static auto map_assembly (uint32_t descriptor_index, std::string_view const& name, const uint8_t *compressed_data, uint32_t compressed_size, uint32_t uncompressed_size) noexcept -> uint8_t*;
+
+		[[gnu::always_inline]]
+		static auto get_image (uint32_t descriptor_index) noexcept -> uint8_t*
+		{
+			if (images == nullptr) [[likely]] {
+				return nullptr;
+			}
+
+			return __atomic_load_n (&images[descriptor_index], __ATOMIC_ACQUIRE);
+		}
+
+	private:
+		struct [[gnu::packed]] SeekTableFooter final
+		{
+			uint32_t frame_count;
+			uint8_t  descriptor;
+			uint32_t magic; // SEEKABLE_MAGIC
+		};
+
+		static_assert (sizeof (SeekTableFooter) == 9uz);
+
+		struct Region final : SeekTable
+		{
+			uintptr_t      start;
+			size_t         size;            // whole pages
+		};
+
+		static void initialize () noexcept;
+		static auto find_region (uintptr_t address) noexcept -> Region*;
+		static void materialize (Region &region, uintptr_t fault_address) noexcept;
+		static auto handler_thread_entry (void *arg) noexcept -> void*;
+
+	private:
+		static inline int uffd = -1;
+		static inline size_t page_size = 0;
+		static inline std::unique_ptr<uint8_t*[]> images {};
+
+		// Append-only, entries are published by incrementing `region_count`
+		static inline std::unique_ptr<Region[]> regions {};
+		static inline uint32_t region_count = 0;
+	};
+}
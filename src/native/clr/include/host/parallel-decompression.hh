@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include <runtime-base/zstd.hh>
+
+namespace xamarin::android {
+	// Enabled at build time with `$(_AndroidAssemblyStoreParallelDecompression)`.
+	//
+	// Large assemblies are compressed as a sequence of independent Zstandard frames, followed by a seek
+	// table (see OnDemandDecompression). Unless such an assembly is decompressed on demand, its frames
+	// are decompressed in parallel, straight into their place in the destination buffer, by the thread
+	// which needs the assembly and a small pool of worker threads. Only one assembly is decompressed by
+	// the pool at a time; should the pool be busy, the calling thread decompresses all the frames itself.
+	class ParallelDecompression
+	{
+		static constexpr uint32_t MAX_WORKERS = 3;
+
+	public:
+		// Returns the decompressed size, or `0` if the data isn't split into frames and must be decompressed
+		// in one go. `dctx` is the decompression context of the calling thread.
+		static auto decompress (std::string_view const& name, const uint8_t *compressed_data, uint32_t compressed_size, uint8_t *dest, uint32_t dest_size, ZSTD_DCtx *dctx) noexcept -> size_t;
+
+	private:
+		struct Job;
+
+		static void initialize () noexcept;
+		static void decompress_frames (Job &job, ZSTD_DCtx *dctx) noexcept;
+		static auto worker_entry (void *arg) noexcept -> void*;
+
+	private:
+		static inline uint32_t worker_count = 0;
+
+		// Protected by the pool lock
+		static inline Job *current_job = nullptr;
+		static inline uint64_t job_generation = 0;
+		static inline uint32_t busy_workers = 0;
+	};
+}
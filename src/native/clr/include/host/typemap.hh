@@ -13,28 +13,79 @@ namespace xamarin::android {
 		static constexpr std::string_view JAVA { "Java" };
 
 	public:
+		// The hash of a type name in the form the typemap is keyed on: its `crc32_hash`, or its `xxh3_hash` if the
+		// Release typemap uses 64-bit hashes (see `typemap_name_hash_bits`). The Debug typemaps ignore it.
+		static auto hash_name (const char *name, size_t name_length) noexcept -> uint64_t;
+
+		// The overloads which take the length of the type name and its `hash_name` let the caller compute both just once
+		// per type, instead of on every lookup.
 #if defined(RELEASE)
 		static auto managed_to_java (const char *typeName, const uint8_t *mvid) noexcept -> const char*;
+		static auto managed_to_java (const char *typeName, size_t type_name_length, uint64_t type_name_hash, const uint8_t *mvid) noexcept -> const char*;
 #else
 		static auto managed_to_java (const char *typeName, const char *assemblyFullName) noexcept -> const char*;
 #endif
 		static auto java_to_managed (const char *java_type_name, char const** assembly_name, uint32_t *managed_type_token_id) noexcept -> bool;
+		static auto java_to_managed (const char *java_type_name, size_t java_type_name_length, uint64_t java_type_name_hash, char const** assembly_name, uint32_t *managed_type_token_id) noexcept -> bool;
 
 	private:
 #if defined(RELEASE)
 		static auto compare_mvid (const uint8_t *mvid, TypeMapModule const& module) noexcept -> int;
-		static auto find_module_entry (const uint8_t *mvid, const TypeMapModule *entries, size_t entry_count) noexcept -> const TypeMapModule*;
-		static auto find_managed_to_java_map_entry (hash_t name_hash, const char *type_name, size_t type_name_length, const TypeMapModuleEntry *map, size_t entry_count) noexcept -> const TypeMapModuleEntry*;
-		static auto managed_to_java_release (const char *typeName, const uint8_t *mvid) noexcept -> const char*;
-		static auto java_to_managed_release (const char *java_type_name, char const** assembly_name, uint32_t *managed_type_token_id) noexcept -> bool;
+		static auto module_index_home_slot (const uint8_t *mvid) noexcept -> uint32_t;
+		static auto find_module_entry (const uint8_t *mvid) noexcept -> const TypeMapModule*;
+		static auto find_module_entry_hashed (const uint8_t *mvid) noexcept -> const TypeMapModule*;
+		static auto find_module_entry_sorted (const uint8_t *mvid, const TypeMapModule *entries, size_t entry_count) noexcept -> const TypeMapModule*;
+
+		// The lookups below are shared by the CRC32 (`THash` is `hash_t`) and xxh3 (`THash` is `uint64_t`) typemaps
+		static auto uses_64bit_name_hashes () noexcept -> bool;
+
+		template<typename THash>
+		static auto find_managed_to_java_map_entry (THash name_hash, const char *type_name, size_t type_name_length, const TypeMapModuleEntry *map, const THash *hashes, size_t entry_count, bool eytzinger_layout) noexcept -> const TypeMapModuleEntry*;
+		template<typename THash>
+		static auto managed_to_java_release (const char *typeName, size_t type_name_length, THash name_hash, const uint8_t *mvid) noexcept -> const char*;
+		template<typename THash>
+		static auto java_to_managed_release (const char *java_type_name, size_t java_type_name_length, THash name_hash, char const** assembly_name, uint32_t *managed_type_token_id) noexcept -> bool;
 
-		static auto find_java_to_managed_entry (hash_t name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*;
+		template<typename THash>
+		static auto find_java_to_managed_entry (THash name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*;
+		template<typename THash>
+		static auto find_java_to_managed_entry_perfect_hash (THash name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*;
+		template<typename THash>
+		static auto find_java_to_managed_entry_sorted (THash name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*;
+		template<typename THash>
+		static auto match_java_to_managed_entry (size_t idx, THash name_hash, const char *java_type_name, size_t java_type_name_length) noexcept -> const TypeMapJava*;
+
+		template<typename THash>
+		static auto managed_to_java_cache_slot (const uint8_t *mvid, THash name_hash) noexcept -> size_t;
+		template<typename THash>
+		static auto managed_to_java_cache_lookup (const uint8_t *mvid, THash name_hash, const char *type_name, size_t type_name_length) noexcept -> const char*;
+		template<typename THash>
+		static void managed_to_java_cache_store (const uint8_t *mvid, THash name_hash, const TypeMapModule *module, const TypeMapModuleEntry *entry, bool is_duplicate) noexcept;
 #else
 		static auto index_to_name (ssize_t index, const char *typeName, const TypeMapEntry *map, const char (&name_map)[], std::string_view const& from_name, std::string_view const& to_name) -> const char*;
 		static auto find_index_by_hash (const char *typeName, const TypeMapEntry *map, const char (&name_map)[], std::string_view const& from_name, std::string_view const& to_name) noexcept -> ssize_t;
 		static auto find_index_by_name (const char *typeName, const TypeMapEntry *map, const char (&name_map)[], std::string_view const& from_name, std::string_view const& to_name) noexcept -> ssize_t;
+		static auto name_index_home_slot (hash_t name_hash) noexcept -> uint32_t;
+		static auto find_index_by_name_index (const char *typeName, const TypeMapEntry *map, const uint32_t *name_index, const char (&name_map)[], std::string_view const& from_name, std::string_view const& to_name) noexcept -> ssize_t;
 		static auto managed_to_java_debug (const char *typeName, const char *assemblyFullName) noexcept -> const char*;
 		static auto java_to_managed_debug (const char *java_type_name, char const** assembly_name, uint32_t *managed_type_token_id) noexcept -> bool;
 #endif
+
+#if defined(RELEASE)
+		// Successful managed-to-Java lookups are cached in a fixed-size, open addressing table. Each slot is a single
+		// 64-bit word, read and written atomically, which holds the (1-based) index of the module in `managed_to_java_map`
+		// in the upper half and the index of the module entry in the lower half. Entries found in the duplicates map have
+		// `MANAGED_TO_JAVA_CACHE_DUPLICATE_FLAG` set. A zero word marks an empty slot.
+		static constexpr size_t MANAGED_TO_JAVA_CACHE_SIZE_BITS = 10uz;
+		static constexpr size_t MANAGED_TO_JAVA_CACHE_SIZE = 1uz << MANAGED_TO_JAVA_CACHE_SIZE_BITS;
+		static constexpr size_t MANAGED_TO_JAVA_CACHE_PROBE_LIMIT = 8uz;
+		static constexpr uint32_t MANAGED_TO_JAVA_CACHE_DUPLICATE_FLAG = 0x80000000u;
+
+		alignas(uint64_t) static inline uint64_t managed_to_java_cache[MANAGED_TO_JAVA_CACHE_SIZE] {};
+
+		// Peers tend to be created in bursts for types from the same assembly, so the module found by the previous lookup
+		// on this thread is checked before the module index.
+		static inline thread_local const TypeMapModule *last_module = nullptr;
+#endif
 	};
 }
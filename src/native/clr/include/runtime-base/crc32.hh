@@ -9,6 +9,38 @@ namespace xamarin::android {
 	using hash_t = uint32_t;
 	static constexpr hash_t CRC32_POLYNOMIAL = 0xedb88320;
 
+	// Runtime implementations of the (reflected, zlib-compatible) CRC32 state update. All of them
+	// operate on the raw CRC state, that is without the initial and final inversion, and MUST produce
+	// identical results. `update` picks the fastest one supported by the CPU we run on, the remaining
+	// methods are public so that they can be compared against each other.
+	class Crc32 final
+	{
+	public:
+		static auto update (hash_t crc, const char *data, size_t len) noexcept -> hash_t;
+		static auto update_slice_by_8 (hash_t crc, const char *data, size_t len) noexcept -> hash_t;
+
+#if defined (__aarch64__)
+		static auto update_armv8 (hash_t crc, const char *data, size_t len) noexcept -> hash_t;
+#elif defined (__x86_64__)
+		static auto update_pclmul (hash_t crc, const char *data, size_t len) noexcept -> hash_t;
+#endif
+
+		static auto have_hardware_support () noexcept -> bool;
+
+		[[gnu::always_inline]]
+		static constexpr auto update_bitwise (hash_t crc, const char *data, size_t len) noexcept -> hash_t
+		{
+			for (size_t i = 0; i < len; i++) {
+				crc ^= static_cast<uint8_t>(data [i]);
+				for (size_t bit = 0; bit < 8; bit++) {
+					crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32_POLYNOMIAL : 0);
+				}
+			}
+
+			return crc;
+		}
+	};
+
 	[[gnu::always_inline]]
 	constexpr auto crc32_hash (const char *value, size_t len) noexcept -> hash_t
 	{
@@ -21,15 +53,11 @@ namespace xamarin::android {
 			return std::numeric_limits<uint32_t>::max ();
 		}
 
-		hash_t crc = 0xffffffff;
-		for (size_t i = 0; i < len; i++) {
-			crc ^= static_cast<uint8_t>(value [i]);
-			for (size_t bit = 0; bit < 8; bit++) {
-				crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32_POLYNOMIAL : 0);
-			}
+		if consteval {
+			return ~Crc32::update_bitwise (0xffffffff, value, len);
+		} else {
+			return ~Crc32::update (0xffffffff, value, len);
 		}
-
-		return ~crc;
 	}
 
 	template<size_t Size>
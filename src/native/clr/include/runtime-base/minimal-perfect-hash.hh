@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#include <runtime-base/crc32.hh>
+
+namespace xamarin::android {
+	// Lookup side of the "hash and displace" minimal perfect hash tables generated at build time for the assembly
+	// store index and the release Java-to-managed type map. A key's bucket selects a displacement which, together
+	// with the key, yields the key's slot in the table. Keys absent from the table map to *some* slot as well, so
+	// callers must always verify the entry they find.
+	//
+	// The functions below MUST be kept in sync with their counterparts in
+	// src/Xamarin.Android.Build.Tasks/Utilities/MinimalPerfectHash.cs
+	class MinimalPerfectHash final
+	{
+	public:
+		[[gnu::always_inline]]
+		static constexpr auto mix (uint64_t x) noexcept -> uint64_t
+		{
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdULL;
+			x ^= x >> 33;
+			x *= 0xc4ceb9fe1a85ec53ULL;
+			x ^= x >> 33;
+			return x;
+		}
+
+		[[gnu::always_inline]]
+		static constexpr auto bucket (hash_t hash, uint32_t bucket_count) noexcept -> uint32_t
+		{
+			return static_cast<uint32_t>((mix (hash) >> 32) % bucket_count);
+		}
+
+		[[gnu::always_inline]]
+		static constexpr auto slot (hash_t hash, uint32_t displacement, uint32_t slot_count) noexcept -> uint32_t
+		{
+			return static_cast<uint32_t>(mix ((static_cast<uint64_t>(displacement) << 32) | hash) % slot_count);
+		}
+	};
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#define XXH_NO_STREAM
+#define XXH_INLINE_ALL
+#define XXH_NAMESPACE xaInternal_
+#include <xxHash/xxhash.h>
+
+// shared/xxhash.hh can't be used here, its `hash_t` clashes with the CRC32 one in runtime-base/crc32.hh
+namespace xamarin::android {
+	[[gnu::always_inline]]
+	inline auto xxh3_hash (const char *value, size_t len) noexcept -> uint64_t
+	{
+		// Just like `crc32_hash`, an empty input maps to the maximum value. MUST be kept in sync with
+		// TypeMapHelper.HashNameForCLR64 in src/Xamarin.Android.Build.Tasks/Utilities/TypeMapHelper.cs
+		if (len == 0) [[unlikely]] {
+			return std::numeric_limits<uint64_t>::max ();
+		}
+
+		return XXH3_64bits (value, len);
+	}
+}
@@ -2,13 +2,14 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 #include <jni.h>
 #include <runtime-base/crc32.hh>
 
 static constexpr uint64_t FORMAT_TAG = 0x00045E6972616D58; // 'Xmari^XY' where XY is the format version
-static constexpr uint32_t COMPRESSED_DATA_MAGIC = 0x535A4158; // 'XAZS', little-endian
+static constexpr uint32_t COMPRESSED_DATA_MAGIC = 0x41434158; // 'XACA', little-endian
 static constexpr uint32_t ASSEMBLY_STORE_MAGIC = 0x41424158; // 'XABA', little-endian
 
 // The highest bit of assembly store version is a 64-bit ABI flag
@@ -30,11 +31,27 @@ static constexpr uint32_t ASSEMBLY_STORE_ABI = 0x00040000;
 #endif
 
 // Increase whenever an incompatible change is made to the assembly store format
-static constexpr uint32_t ASSEMBLY_STORE_FORMAT_VERSION = 4 | ASSEMBLY_STORE_64BIT_FLAG | ASSEMBLY_STORE_ABI;
+static constexpr uint32_t ASSEMBLY_STORE_FORMAT_VERSION = 7 | ASSEMBLY_STORE_64BIT_FLAG | ASSEMBLY_STORE_ABI;
+
+// Stores whose index is sorted by name hash instead of laid out as a perfect hash table. Still produced
+// when the perfect hash table can't be built at application build time.
+static constexpr uint32_t ASSEMBLY_STORE_FORMAT_VERSION_SORTED_INDEX = 6 | ASSEMBLY_STORE_64BIT_FLAG | ASSEMBLY_STORE_ABI;
+
+// Set in the version of stores which contain a Zstandard dictionary, placed right after the assembly names.
+// Runtimes which don't know about the flag reject such stores, as they can't decompress their contents.
+static constexpr uint32_t ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG = 0x01000000;
+
+// Set in the version of stores which keep the debug and config data of all the assemblies in a single region
+// following all the assembly images, instead of next to the image of each assembly.
+static constexpr uint32_t ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG = 0x02000000;
+
+// Set in the version of primary stores which are accompanied by secondary stores, holding the assemblies which
+// aren't needed during startup. The secondary stores are described by a section following the debug data region.
+static constexpr uint32_t ASSEMBLY_STORE_SECONDARY_STORES_FLAG = 0x04000000;
 
 static constexpr uint32_t MODULE_MAGIC_NAMES = 0x53544158; // 'XATS', little-endian
 static constexpr uint32_t MODULE_INDEX_MAGIC = 0x49544158; // 'XATI', little-endian
-static constexpr uint8_t  MODULE_FORMAT_VERSION = 2;       // Keep in sync with the value in src/Xamarin.Android.Build.Tasks/Utilities/TypeMapGenerator.cs
+static constexpr uint8_t  MODULE_FORMAT_VERSION = 5;       // Keep in sync with the value in src/Xamarin.Android.Build.Tasks/Utilities/TypeMapGenerator.cs
 
 #if defined (DEBUG)
 // MUST match src/Xamarin.Android.Build.Tasks/Utilities/TypeMappingDebugNativeAssemblyGeneratorCLR.cs
@@ -64,9 +81,11 @@ struct TypeMap
 	const TypeMapEntry  *managed_to_java;
 };
 #else
+// The managed type name hashes of the entries are kept in a separate array, parallel to the one holding the entries
+// (`modules_map_hashes` or `modules_map_hashes64` for `modules_map_data` etc), so that they can be searched without
+// pulling the rest of the entry into the cache.
 struct TypeMapModuleEntry
 {
-	xamarin::android::hash_t managed_type_name_hash;
 	uint32_t                 managed_type_name_index;
 	uint32_t                 managed_type_name_length;
 	uint32_t                 java_map_index;
@@ -81,8 +100,14 @@ struct TypeMapModule
 	uint32_t                  assembly_name_length;
 	uint32_t                  map_index;
 	uint32_t                  duplicate_map_index;
+	uint32_t                  flags;
 };
 
+// `TypeMapModule.flags` bits, set if the module's map or duplicate map entries are laid out in the Eytzinger (BFS)
+// order of the binary search tree over their hashes, instead of being simply sorted on hash.
+static constexpr uint32_t TYPEMAP_MODULE_EYTZINGER_MAP_FLAG = 0x01;
+static constexpr uint32_t TYPEMAP_MODULE_EYTZINGER_DUPLICATE_MAP_FLAG = 0x02;
+
 struct TypeMapJava
 {
 	uint32_t  module_index;
@@ -94,11 +119,23 @@ struct TypeMapJava
 };
 #endif
 
+// Keep in sync with src/Microsoft.Android.Build.Tasks/Utilities/AssemblyCompressor.cs
+enum class CompressionCodec : uint32_t
+{
+	Stored    = 0, // not compressed, used when compression doesn't make the assembly any smaller
+	Zstandard = 1,
+	LZ4       = 2, // LZ4 block format
+};
+
 struct CompressedAssemblyHeader
 {
 	uint32_t magic; // COMPRESSED_DATA_MAGIC
 	uint32_t descriptor_index;
 	uint32_t uncompressed_length;
+	CompressionCodec codec;
+	// ID of the assembly store dictionary the data was compressed with, `0` if none. Only Zstandard
+	// data is ever compressed with a dictionary.
+	uint32_t dictionary_id;
 };
 
 struct CompressedAssemblyDescriptor
@@ -112,12 +149,16 @@ struct CompressedAssemblyDescriptor
 //
 // Assembly store format
 //
-// Each target ABI/architecture has a single assembly store file, composed of the following parts:
+// Each target ABI/architecture has a primary assembly store file (`libassembly-store.so`) and, optionally, a number
+// of secondary store files (`libassembly-store-1.so`, `libassembly-store-2.so` etc), each composed of the following parts:
 //
 // [HEADER]
 // [INDEX]
 // [ASSEMBLY_DESCRIPTORS]
 // [ASSEMBLY_NAMES]
+// [ZSTD_DICTIONARY]     present if HEADER.FORMAT_VERSION has the ASSEMBLY_STORE_ZSTD_DICTIONARY_FLAG bit set
+// [DEBUG_DATA_REGION]   present if HEADER.FORMAT_VERSION has the ASSEMBLY_STORE_TRAILING_DEBUG_DATA_FLAG bit set
+// [SECONDARY_STORES]    present if HEADER.FORMAT_VERSION has the ASSEMBLY_STORE_SECONDARY_STORES_FLAG bit set
 // [ASSEMBLY DATA]
 //
 // Formats of the sections above are as follows:
@@ -130,11 +171,17 @@ struct CompressedAssemblyDescriptor
 //  [INDEX_SIZE]         uint; index size in bytes
 //  [CONTENT_ID]         ulong: deterministic hash of everything after the header
 //
-// INDEX (variable size, HEADER.ENTRY_COUNT*2 entries, for assembly names with and without the extension)
+// INDEX (variable size, HEADER.INDEX_ENTRY_COUNT entries, for assembly names with and without the extension)
 //  [NAME_HASH]          uint; CRC32 of the assembly name
 //  [DESCRIPTOR_INDEX]   uint; index into in-store assembly descriptor array
 //  [IGNORE]             byte; if set to anything other than 0, the assembly is to be ignored when loading
 //
+// In v7 stores the entries are placed in the slots of a minimal perfect hash table and are followed by
+// the table's displacements, all included in HEADER.INDEX_SIZE:
+//  [BUCKET_COUNT]       uint; number of displacement entries
+//  [DISPLACEMENTS]      uint[BUCKET_COUNT]
+// In v6 stores the entries are sorted by NAME_HASH instead.
+//
 // ASSEMBLY_DESCRIPTORS (variable size, HEADER.ENTRY_COUNT entries), each entry formatted as follows:
 //  [MAPPING_INDEX]      uint; index into a runtime array where assembly data pointers are stored
 //  [DATA_OFFSET]        uint; offset from the beginning of the store to the start of assembly data
@@ -143,10 +190,33 @@ struct CompressedAssemblyDescriptor
 //  [DEBUG_DATA_SIZE]    uint; size of the stored assembly PDB data, 0 if absent
 //  [CONFIG_DATA_OFFSET] uint; offset from the beginning of the store to the start of assembly .config contents, 0 if absent
 //  [CONFIG_DATA_SIZE]   uint; size of the stored assembly .config contents, 0 if absent
+//  [NAME_OFFSET]        uint; offset from the beginning of the store to the NAME bytes of the assembly's ASSEMBLY_NAMES entry
+//  [NAME_LENGTH]        uint; length of the assembly name
 //
-// ASSEMBLY_NAMES (variable size, HEADER.ENTRY_COUNT entries), each entry formatted as follows:
+// ASSEMBLY_NAMES (variable size, HEADER.ENTRY_COUNT entries, in descriptor order), each entry formatted as follows:
 //  [NAME_LENGTH]        uint: length of assembly name
 //  [NAME]               byte: UTF-8 bytes of assembly name, without the NUL terminator
+// The runtime slices the names straight out of the section using the descriptors' NAME_OFFSET and
+// NAME_LENGTH, the length prefix is kept for the benefit of tools which read the store sequentially.
+//
+// ZSTD_DICTIONARY (variable size), the dictionary some of the assemblies are compressed with:
+//  [DICTIONARY_SIZE]    uint: size of the dictionary
+//  [DICTIONARY]         byte: the dictionary, in the Zstandard dictionary format
+//
+// DEBUG_DATA_REGION (fixed size), location of the trailing part of ASSEMBLY DATA which contains the debug
+// and config data of all the assemblies, all the assembly images precede it:
+//  [REGION_OFFSET]      uint: offset from the beginning of the store to the start of the region
+//  [REGION_SIZE]        uint: size of the region
+//
+// SECONDARY_STORES (variable size), present in the primary store only:
+//  [STORE_COUNT]        uint: number of secondary stores
+//  [ENTRY_COUNT]        uint: number of entries in SECONDARY_INDEX
+//  [CONTENT_IDS]        ulong[STORE_COUNT]: CONTENT_ID of each of the secondary stores
+//  [SECONDARY_INDEX]    ENTRY_COUNT entries, sorted by NAME_HASH, each formatted as follows:
+//    [NAME_HASH]        uint; CRC32 of an assembly name found in the INDEX of a secondary store
+//    [STORE_NUMBER]     uint; 1-based number of that secondary store
+// A secondary store doesn't contain a dictionary, the assemblies it holds are compressed with the dictionary
+// of the primary store. Descriptor MAPPING_INDEX values are unique across all the stores.
 //
 
 //
@@ -182,6 +252,15 @@ struct [[gnu::packed]] AssemblyStoreEntryDescriptor final
 
 	uint32_t config_data_offset;
 	uint32_t config_data_size;
+
+	uint32_t name_offset;
+	uint32_t name_length;
+};
+
+struct [[gnu::packed]] AssemblyStoreSecondaryIndexEntry final
+{
+	xamarin::android::hash_t name_hash;
+	uint32_t store_number;
 };
 
 struct AssemblyStoreRuntimeData final
@@ -225,6 +304,8 @@ struct ApplicationConfig
 	const char *android_package_name;
 	bool have_assembly_store;
 	bool assembly_store_decompression_cache_enabled;
+	uint32_t assembly_store_decompression_cache_max_size_mb;
+	bool assembly_store_on_demand_decompression;
 };
 
 struct DSOCacheEntry
@@ -289,6 +370,12 @@ extern "C" {
 	[[gnu::visibility("default")]] extern const char type_map_assembly_names[];
 	[[gnu::visibility("default")]] extern const char type_map_managed_type_names[];
 	[[gnu::visibility("default")]] extern const char type_map_java_type_names[];
+
+	// Open addressing hash tables which map name hashes to `type_map.java_to_managed` and `type_map.managed_to_java`
+	// entry indexes + 1. Both have `type_map_name_index_size` (power of 2, or 0 if the map is empty) slots.
+	[[gnu::visibility("default")]] extern const uint32_t type_map_name_index_size;
+	[[gnu::visibility("default")]] extern const uint32_t type_map_java_to_managed_index[];
+	[[gnu::visibility("default")]] extern const uint32_t type_map_managed_to_java_index[];
 #else
 	[[gnu::visibility("default")]] extern const uint32_t managed_to_java_map_module_count;
 	[[gnu::visibility("default")]] extern const uint32_t java_type_count;
@@ -297,10 +384,29 @@ extern "C" {
 	[[gnu::visibility("default")]] extern const char managed_type_names[];
 	[[gnu::visibility("default")]] extern const char managed_assembly_names[];
 	[[gnu::visibility("default")]] extern const TypeMapModule managed_to_java_map[];
+	[[gnu::visibility("default")]] extern const uint32_t managed_to_java_module_index_size; // power of 2, or 0 if there are no modules
+	[[gnu::visibility("default")]] extern const uint32_t managed_to_java_module_index[];
 	[[gnu::visibility("default")]] extern const TypeMapModuleEntry modules_map_data[];
 	[[gnu::visibility("default")]] extern const TypeMapModuleEntry modules_duplicates_data[];
 	[[gnu::visibility("default")]] extern const TypeMapJava java_to_managed_map[];
+
+	// Type names are hashed either with CRC32 or, if `typemap_name_hash_bits` is 64, with xxh3. Only the hash arrays of
+	// the selected width have any entries, the others are empty.
+	[[gnu::visibility("default")]] extern const uint32_t typemap_name_hash_bits;
 	[[gnu::visibility("default")]] extern const xamarin::android::hash_t java_to_managed_hashes[];
+	[[gnu::visibility("default")]] extern const xamarin::android::hash_t modules_map_hashes[];
+	[[gnu::visibility("default")]] extern const xamarin::android::hash_t modules_duplicates_hashes[];
+	[[gnu::visibility("default")]] extern const uint64_t java_to_managed_hashes64[];
+	[[gnu::visibility("default")]] extern const uint64_t modules_map_hashes64[];
+	[[gnu::visibility("default")]] extern const uint64_t modules_duplicates_hashes64[];
+
+	// Minimal perfect hash table over the distinct Java type name hashes (for 64-bit hashes, over the distinct upper
+	// halves of them), each slot holds the index of the first entry with the slot's key. The table is absent if the
+	// bucket count is 0.
+	[[gnu::visibility("default")]] extern const uint32_t java_to_managed_perfect_hash_bucket_count;
+	[[gnu::visibility("default")]] extern const uint32_t java_to_managed_perfect_hash_slot_count;
+	[[gnu::visibility("default")]] extern const uint32_t java_to_managed_perfect_hash_displacements[];
+	[[gnu::visibility("default")]] extern const uint32_t java_to_managed_perfect_hash_slots[];
 #endif
 
 	[[gnu::visibility("default")]] extern uint32_t compressed_assembly_count;
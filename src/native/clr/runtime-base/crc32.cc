@@ -0,0 +1,257 @@
+#include <array>
+#include <cstring>
+
+#if defined (__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#elif defined (__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include <runtime-base/crc32.hh>
+
+using namespace xamarin::android;
+
+namespace {
+	using slice_table = std::array<std::array<hash_t, 256>, 8>;
+
+	// Table `N` gives the CRC of a byte followed by `N` zero bytes, which lets the slice-by-8 loop
+	// process 8 bytes per iteration with independent table lookups.
+	consteval auto make_slice_by_8_table () noexcept -> slice_table
+	{
+		slice_table table {};
+
+		for (uint32_t i = 0; i < 256; i++) {
+			const char byte = static_cast<char>(i);
+			table[0][i] = Crc32::update_bitwise (0, &byte, 1);
+		}
+
+		for (size_t n = 1; n < table.size (); n++) {
+			for (size_t i = 0; i < 256; i++) {
+				hash_t prev = table[n - 1][i];
+				table[n][i] = (prev >> 8) ^ table[0][prev & 0xff];
+			}
+		}
+
+		return table;
+	}
+
+	constexpr slice_table crc32_table = make_slice_by_8_table ();
+
+	[[gnu::always_inline]]
+	inline auto update_byte (hash_t crc, uint8_t byte) noexcept -> hash_t
+	{
+		return (crc >> 8) ^ crc32_table[0][(crc ^ byte) & 0xff];
+	}
+
+	auto detect_hardware_support () noexcept -> bool
+	{
+#if defined (__aarch64__)
+		return (getauxval (AT_HWCAP) & HWCAP_CRC32) != 0;
+#elif defined (__x86_64__)
+		__builtin_cpu_init ();
+		return __builtin_cpu_supports ("pclmul") && __builtin_cpu_supports ("sse4.1");
+#else
+		return false;
+#endif
+	}
+
+	// Initialized dynamically. Should the hash be needed before this translation unit's static
+	// initializers have run, the slice-by-8 fallback is used, which yields the very same results.
+	bool hardware_crc32_available = detect_hardware_support ();
+}
+
+auto Crc32::have_hardware_support () noexcept -> bool
+{
+	return hardware_crc32_available;
+}
+
+auto Crc32::update (hash_t crc, const char *data, size_t len) noexcept -> hash_t
+{
+#if defined (__aarch64__)
+	if (hardware_crc32_available) [[likely]] {
+		return update_armv8 (crc, data, len);
+	}
+#elif defined (__x86_64__)
+	if (hardware_crc32_available) [[likely]] {
+		return update_pclmul (crc, data, len);
+	}
+#endif
+
+	return update_slice_by_8 (crc, data, len);
+}
+
+auto Crc32::update_slice_by_8 (hash_t crc, const char *data, size_t len) noexcept -> hash_t
+{
+	auto p = reinterpret_cast<const uint8_t*>(data);
+
+	while (len > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+		crc = update_byte (crc, *p++);
+		len--;
+	}
+
+	// All the Android ABIs are little-endian, the code below depends on it
+	while (len >= 8) {
+		uint32_t one;
+		uint32_t two;
+		memcpy (&one, p, sizeof (one));
+		memcpy (&two, p + 4, sizeof (two));
+		one ^= crc;
+
+		crc = crc32_table[7][one & 0xff] ^
+			crc32_table[6][(one >> 8) & 0xff] ^
+			crc32_table[5][(one >> 16) & 0xff] ^
+			crc32_table[4][one >> 24] ^
+			crc32_table[3][two & 0xff] ^
+			crc32_table[2][(two >> 8) & 0xff] ^
+			crc32_table[1][(two >> 16) & 0xff] ^
+			crc32_table[0][two >> 24];
+
+		p += 8;
+		len -= 8;
+	}
+
+	while (len > 0) {
+		crc = update_byte (crc, *p++);
+		len--;
+	}
+
+	return crc;
+}
+
+#if defined (__aarch64__)
+[[gnu::target ("crc")]]
+auto Crc32::update_armv8 (hash_t crc, const char *data, size_t len) noexcept -> hash_t
+{
+	auto p = reinterpret_cast<const uint8_t*>(data);
+
+	while (len > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+		crc = __crc32b (crc, *p++);
+		len--;
+	}
+
+	while (len >= 8) {
+		uint64_t v;
+		memcpy (&v, p, sizeof (v));
+		crc = __crc32d (crc, v);
+		p += 8;
+		len -= 8;
+	}
+
+	if (len >= 4) {
+		uint32_t v;
+		memcpy (&v, p, sizeof (v));
+		crc = __crc32w (crc, v);
+		p += 4;
+		len -= 4;
+	}
+
+	while (len > 0) {
+		crc = __crc32b (crc, *p++);
+		len--;
+	}
+
+	return crc;
+}
+#elif defined (__x86_64__)
+//
+// Carry-less multiplication folding, as described in Intel's "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction" paper. The constants are those for the bit-reflected
+// CRC32 (zlib) polynomial. Inputs shorter than 64 bytes, as well as the tail of the longer ones
+// which doesn't fill a whole 16-byte block, are handed over to the slice-by-8 implementation.
+//
+[[gnu::target ("pclmul,sse4.1")]]
+auto Crc32::update_pclmul (hash_t crc, const char *data, size_t len) noexcept -> hash_t
+{
+	if (len < 64) {
+		return update_slice_by_8 (crc, data, len);
+	}
+
+	alignas(16) static constexpr uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+	alignas(16) static constexpr uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+	alignas(16) static constexpr uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+	alignas(16) static constexpr uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+	auto p = reinterpret_cast<const uint8_t*>(data);
+	size_t tail_len = len & 15;
+	len -= tail_len;
+
+	__m128i x1 = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(p + 0x00));
+	__m128i x2 = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(p + 0x10));
+	__m128i x3 = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(p + 0x20));
+	__m128i x4 = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(p + 0x30));
+	__m128i x5;
+
+	x1 = _mm_xor_si128 (x1, _mm_cvtsi32_si128 (static_cast<int>(crc)));
+	__m128i x0 = _mm_load_si128 (reinterpret_cast<const __m128i*>(k1k2));
+
+	p += 64;
+	len -= 64;
+
+	// Fold four 128-bit lanes in parallel
+	while (len >= 64) {
+		x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+		__m128i x6 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+		__m128i x7 = _mm_clmulepi64_si128 (x3, x0, 0x00);
+		__m128i x8 = _mm_clmulepi64_si128 (x4, x0, 0x00);
+
+		x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128 (x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128 (x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128 (x4, x0, 0x11);
+
+		x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5), _mm_loadu_si128 (reinterpret_cast<const __m128i*>(p + 0x00)));
+		x2 = _mm_xor_si128 (_mm_xor_si128 (x2, x6), _mm_loadu_si128 (reinterpret_cast<const __m128i*>(p + 0x10)));
+		x3 = _mm_xor_si128 (_mm_xor_si128 (x3, x7), _mm_loadu_si128 (reinterpret_cast<const __m128i*>(p + 0x20)));
+		x4 = _mm_xor_si128 (_mm_xor_si128 (x4, x8), _mm_loadu_si128 (reinterpret_cast<const __m128i*>(p + 0x30)));
+
+		p += 64;
+		len -= 64;
+	}
+
+	// Fold the four lanes into a single one
+	x0 = _mm_load_si128 (reinterpret_cast<const __m128i*>(k3k4));
+	for (__m128i next : { x2, x3, x4 }) {
+		x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+		x1 = _mm_xor_si128 (_mm_xor_si128 (x1, next), x5);
+	}
+
+	// Fold the remaining whole 16-byte blocks
+	while (len >= 16) {
+		x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+		x1 = _mm_xor_si128 (_mm_xor_si128 (x1, _mm_loadu_si128 (reinterpret_cast<const __m128i*>(p))), x5);
+
+		p += 16;
+		len -= 16;
+	}
+
+	// Fold 128 bits to 64 bits
+	x2 = _mm_clmulepi64_si128 (x1, x0, 0x10);
+	x3 = _mm_setr_epi32 (~0, 0, ~0, 0);
+	x1 = _mm_xor_si128 (_mm_srli_si128 (x1, 8), x2);
+
+	x0 = _mm_loadl_epi64 (reinterpret_cast<const __m128i*>(k5k0));
+	x2 = _mm_srli_si128 (x1, 4);
+	x1 = _mm_and_si128 (x1, x3);
+	x1 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+	x1 = _mm_xor_si128 (x1, x2);
+
+	// Barrett reduction to 32 bits
+	x0 = _mm_load_si128 (reinterpret_cast<const __m128i*>(poly));
+	x2 = _mm_and_si128 (x1, x3);
+	x2 = _mm_clmulepi64_si128 (x2, x0, 0x10);
+	x2 = _mm_and_si128 (x2, x3);
+	x2 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+	x1 = _mm_xor_si128 (x1, x2);
+
+	crc = static_cast<hash_t>(_mm_extract_epi32 (x1, 1));
+	if (tail_len == 0) {
+		return crc;
+	}
+
+	return update_slice_by_8 (crc, reinterpret_cast<const char*>(p), tail_len);
+}
+#endif
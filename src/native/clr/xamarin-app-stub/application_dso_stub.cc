@@ -22,6 +22,9 @@ const TypeMapManagedTypeInfo type_map_managed_type_info[] = {};
 const char type_map_assembly_names[] = {};
 const char type_map_managed_type_names[] = {};
 const char type_map_java_type_names[] = {};
+const uint32_t type_map_name_index_size = 0;
+const uint32_t type_map_java_to_managed_index[] = {};
+const uint32_t type_map_managed_to_java_index[] = {};
 #else
 const uint32_t managed_to_java_map_module_count = 0;
 const uint32_t java_type_count = 0;
@@ -30,10 +33,22 @@ const uint64_t java_type_names_size = 0;
 const char managed_type_names[] = {};
 const char managed_assembly_names[] = {};
 const TypeMapModule managed_to_java_map[] = {};
+const uint32_t managed_to_java_module_index_size = 0;
+const uint32_t managed_to_java_module_index[] = {};
 const TypeMapModuleEntry modules_map_data[] = {};
 const TypeMapModuleEntry modules_duplicates_data[] = {};
 const TypeMapJava java_to_managed_map[] = {};
+const uint32_t typemap_name_hash_bits = 32;
 const xamarin::android::hash_t java_to_managed_hashes[] = {};
+const xamarin::android::hash_t modules_map_hashes[] = {};
+const xamarin::android::hash_t modules_duplicates_hashes[] = {};
+const uint64_t java_to_managed_hashes64[] = {};
+const uint64_t modules_map_hashes64[] = {};
+const uint64_t modules_duplicates_hashes64[] = {};
+const uint32_t java_to_managed_perfect_hash_bucket_count = 0;
+const uint32_t java_to_managed_perfect_hash_slot_count = 0;
+const uint32_t java_to_managed_perfect_hash_displacements[] = {};
+const uint32_t java_to_managed_perfect_hash_slots[] = {};
 #endif
 
 uint32_t compressed_assembly_count = 0;
@@ -67,6 +82,8 @@ const ApplicationConfig application_config = {
 	.android_package_name = android_package_name,
 	.have_assembly_store = false,
 	.assembly_store_decompression_cache_enabled = false,
+	.assembly_store_decompression_cache_max_size_mb = 0,
+	.assembly_store_on_demand_decompression = false,
 };
 
 // TODO: migrate to std::string_view for these two
@@ -50,6 +50,52 @@ namespace xamarin::android {
 			return left;
 		}
 
+		// Lower bound search of a table stored in the Eytzinger (BFS) order: the node at 1-based position `k` has its
+		// children at positions `2k` and `2k + 1`. The search is branchless and prefetches the node's grandchildren, which
+		// are adjacent in memory, while the current node is compared. Returns the array index of the first element not
+		// less than `key`, or `n` if there's no such element.
+		template<class T, typename TKey, bool (*less_than) (T const&, TKey)>
+		[[gnu::always_inline, gnu::flatten]]
+		static size_t eytzinger_lower_bound (TKey key, const T *arr, size_t n) noexcept
+		{
+			static_assert (less_than != nullptr, "less_than is a required template parameter");
+
+			size_t k = 1;
+			while (k <= n) {
+				// Prefetching past the end of the array is harmless, it never faults
+				__builtin_prefetch (arr + (4 * k - 1));
+				k = 2 * k + static_cast<size_t>(less_than (arr[k - 1], key));
+			}
+
+			// Every step to the right appended a 1 bit to `k`, drop them together with the final left step to get
+			// to the last node at which we went left, that is the lower bound
+			k >>= __builtin_ctzll (~static_cast<unsigned long long>(k)) + 1;
+			return k == 0 ? n : k - 1;
+		}
+
+		// Returns the array index of the in-order successor of the element at array index `idx` in an Eytzinger ordered
+		// table, or `n` if it's the last element. Used to visit all the elements equal to the lower bound.
+		[[gnu::always_inline]]
+		static size_t eytzinger_next (size_t idx, size_t n) noexcept
+		{
+			size_t k = idx + 1;
+			if (2 * k + 1 <= n) {
+				// Leftmost node of the right subtree
+				k = 2 * k + 1;
+				while (2 * k <= n) {
+					k = 2 * k;
+				}
+				return k - 1;
+			}
+
+			// Closest ancestor whose left subtree we're in
+			while ((k & 1) != 0) {
+				k >>= 1;
+			}
+			k >>= 1;
+			return k == 0 ? n : k - 1;
+		}
+
 		template<class T, typename TKey, typename TState, bool (*equal) (T const&, TKey, TState const&), bool (*less_than) (T const&, TKey, TState const&)>
 		[[gnu::always_inline, gnu::flatten]]
 		static ssize_t binary_search (const TState& state, TKey key, const T *arr, size_t n) noexcept
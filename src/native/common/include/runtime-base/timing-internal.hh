@@ -55,6 +55,23 @@ namespace xamarin::android {
 		Unspecified               = std::numeric_limits<uint16_t>::max (),
 	};
 
+	// Like events, counters should never change their assigned values and no values should be reused.
+	//
+	enum class TimingCounterKind : uint16_t
+	{
+		AssemblyDecompressionLockContention = 0,
+		AssemblyCacheHits                   = 1,
+		AssemblyCacheMisses                 = 2,
+		AssemblyCacheEvictions              = 3,
+		AssemblyCacheSize                   = 4,
+		OnDemandPagesMaterialized           = 5,
+		OnDemandImagePages                  = 6,
+		ManagedToJavaCacheHits              = 7,
+		ManagedToJavaCacheMisses            = 8,
+
+		Count,
+	};
+
 	struct TimingEvent
 	{
 		bool                         before_managed;
@@ -320,6 +337,20 @@ namespace xamarin::android {
 			log (*event, false /* skip_log_if_more_info_missing */);
 		}
 
+		// Counters are updated from any thread and reported, accumulated, by `dump ()`
+		[[gnu::always_inline]]
+		void increment_counter (TimingCounterKind kind, uint64_t value = 1u) noexcept
+		{
+			__atomic_fetch_add (&counters[static_cast<size_t>(kind)], value, __ATOMIC_RELAXED);
+		}
+
+		// For counters which report a current value (e.g. a size) rather than an accumulated one
+		[[gnu::always_inline]]
+		void set_counter (TimingCounterKind kind, uint64_t value) noexcept
+		{
+			__atomic_store_n (&counters[static_cast<size_t>(kind)], value, __ATOMIC_RELAXED);
+		}
+
 		void dump () noexcept;
 
 		// The `time_call` function declarations look definitely funky, but it all boils down to
@@ -527,6 +558,7 @@ namespace xamarin::android {
 		std::atomic_size_t next_event_index = 0uz;
 		TimingEventChunk *first_event_chunk = nullptr;
 		std::unique_ptr<std::string> output_file_name{};
+		uint64_t counters[static_cast<size_t>(TimingCounterKind::Count)] {};
 
 		static inline thread_local std::stack<TimingEvent*> open_sequences;
 		static inline thread_local TimingEventChunk *cached_event_chunk = nullptr;
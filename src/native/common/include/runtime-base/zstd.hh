@@ -12,7 +12,16 @@
 // We declare only the few entry points we need instead of pulling in `zstd.h`.
 //
 extern "C" {
+	typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+	typedef struct ZSTD_DDict_s ZSTD_DDict;
+
 	size_t ZSTD_decompress (void *dst, size_t dst_capacity, const void *src, size_t compressed_size) noexcept;
+	ZSTD_DCtx* ZSTD_createDCtx () noexcept;
+	size_t ZSTD_freeDCtx (ZSTD_DCtx *dctx) noexcept;
+	size_t ZSTD_decompressDCtx (ZSTD_DCtx *dctx, void *dst, size_t dst_capacity, const void *src, size_t compressed_size) noexcept;
+	ZSTD_DDict* ZSTD_createDDict (const void *dict_buffer, size_t dict_size) noexcept;
+	unsigned ZSTD_getDictID_fromDDict (const ZSTD_DDict *ddict) noexcept;
+	size_t ZSTD_decompress_usingDDict (ZSTD_DCtx *dctx, void *dst, size_t dst_capacity, const void *src, size_t compressed_size, const ZSTD_DDict *ddict) noexcept;
 	unsigned ZSTD_isError (size_t code) noexcept;
 	const char* ZSTD_getErrorName (size_t code) noexcept;
 }
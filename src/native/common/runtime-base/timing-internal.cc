@@ -165,6 +165,22 @@ void FastTiming::dump (size_t entries, bool indent, std::function<void(std::stri
 	log_time ("[2/6] Java to Managed lookup"sv, total_java_to_managed_time);
 	log_time ("[2/7] Managed to Java lookup"sv, total_managed_to_java_time);
 	log_time ("[2/8] Assembly decompression"sv, total_assembly_decompression_time);
+
+	auto log_counter = [this, &line_writer] (std::string_view const& msg, TimingCounterKind kind)
+	{
+		// Same as above, do not change the string format after the first colon.
+		line_writer (std::format ("  {}: {}", msg, __atomic_load_n (&counters[static_cast<size_t>(kind)], __ATOMIC_RELAXED)));
+	};
+
+	log_counter ("[2/9] Assembly decompression lock contention"sv, TimingCounterKind::AssemblyDecompressionLockContention);
+	log_counter ("[2/10] Decompressed-assembly cache hits"sv, TimingCounterKind::AssemblyCacheHits);
+	log_counter ("[2/11] Decompressed-assembly cache misses"sv, TimingCounterKind::AssemblyCacheMisses);
+	log_counter ("[2/12] Decompressed-assembly cache evictions"sv, TimingCounterKind::AssemblyCacheEvictions);
+	log_counter ("[2/13] Decompressed-assembly cache size (bytes)"sv, TimingCounterKind::AssemblyCacheSize);
+	log_counter ("[2/14] On-demand decompression pages materialized"sv, TimingCounterKind::OnDemandPagesMaterialized);
+	log_counter ("[2/15] On-demand decompression image pages"sv, TimingCounterKind::OnDemandImagePages);
+	log_counter ("[2/16] Managed to Java lookup cache hits"sv, TimingCounterKind::ManagedToJavaCacheHits);
+	log_counter ("[2/17] Managed to Java lookup cache misses"sv, TimingCounterKind::ManagedToJavaCacheMisses);
 }
 
 void FastTiming::dump_to_logcat (size_t entries) noexcept
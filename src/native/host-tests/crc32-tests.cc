@@ -0,0 +1,150 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include <runtime-base/crc32.hh>
+
+using namespace xamarin::android;
+using namespace std::literals;
+
+namespace {
+	struct Implementation
+	{
+		std::string_view name;
+		hash_t (*update) (hash_t crc, const char *data, size_t len) noexcept;
+	};
+
+	struct KnownHash
+	{
+		std::string_view value;
+		hash_t hash;
+	};
+
+	// Hashes produced by the managed generators (TypeMapHelper.HashNameForCLR, i.e. System.IO.Hashing.Crc32.HashToUInt32 over
+	// the UTF-8 bytes of the name). The same values are checked on the managed side, in TypeMapHelperTests.cs under
+	// src/Xamarin.Android.Build.Tasks/Tests/Xamarin.Android.Build.Tests/Tasks/
+	constexpr KnownHash known_hashes[] = {
+		{ ""sv, 0xffffffff },
+		{ "a"sv, 0xe8b7be43 },
+		{ "123456789"sv, 0xcbf43926 },
+		{ "java/lang/Object"sv, 0x7cb3837d },
+		{ "Android.App.Activity, Mono.Android"sv, 0xed93ff66 },
+		{ "crc32/Zażółć gęślą jaźń"sv, 0x04a39337 },
+		{ "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog."sv, 0x9ae90aa7 },
+		{ "System.Collections.Generic.Dictionary`2+ValueCollection+Enumerator[[System.String, System.Private.CoreLib],[System.Object, System.Private.CoreLib]], System.Private.CoreLib"sv, 0x76712dad },
+	};
+
+	auto get_implementations () -> std::vector<Implementation>
+	{
+		std::vector<Implementation> ret {
+			{ "update"sv, Crc32::update },
+			{ "update_slice_by_8"sv, Crc32::update_slice_by_8 },
+		};
+
+		if (Crc32::have_hardware_support ()) {
+#if defined (__aarch64__)
+			ret.push_back ({ "update_armv8"sv, Crc32::update_armv8 });
+#elif defined (__x86_64__)
+			ret.push_back ({ "update_pclmul"sv, Crc32::update_pclmul });
+#endif
+		} else {
+			std::printf ("No hardware CRC32 support on this machine, only the portable implementations are tested\n");
+		}
+
+		return ret;
+	}
+
+	auto check_known_hashes (std::vector<Implementation> const& implementations) -> size_t
+	{
+		size_t failures = 0;
+
+		for (KnownHash const& known : known_hashes) {
+			hash_t hash = crc32_hash (known.value);
+			if (hash != known.hash) {
+				std::printf ("crc32_hash (\"%.*s\") returned 0x%08x, expected 0x%08x\n", static_cast<int>(known.value.length ()), known.value.data (), hash, known.hash);
+				failures++;
+			}
+
+			// The empty input sentinel is implemented by `crc32_hash` alone
+			if (known.value.empty ()) {
+				continue;
+			}
+
+			for (Implementation const& impl : implementations) {
+				hash = ~impl.update (0xffffffff, known.value.data (), known.value.length ());
+				if (hash != known.hash) {
+					std::printf ("%.*s (\"%.*s\") returned 0x%08x, expected 0x%08x\n",
+						static_cast<int>(impl.name.length ()), impl.name.data (),
+						static_cast<int>(known.value.length ()), known.value.data (),
+						hash, known.hash
+					);
+					failures++;
+				}
+			}
+		}
+
+		return failures;
+	}
+
+	// Random contents, lengths and offsets into the buffer, so that all the combinations of the aligned head, the wide (8, 16
+	// or 64 bytes at a time) loops and the byte-wise tails are exercised.
+	auto check_random_inputs (std::vector<Implementation> const& implementations, uint64_t seed) -> size_t
+	{
+		constexpr size_t ITERATIONS = 20000;
+		constexpr size_t MAX_LENGTH = 4096;
+		constexpr size_t MAX_OFFSET = 64;
+
+		std::mt19937_64 random (seed);
+		std::vector<char> buffer (MAX_LENGTH + MAX_OFFSET);
+		size_t failures = 0;
+
+		for (size_t i = 0; i < ITERATIONS; i++) {
+			for (char &c : buffer) {
+				c = static_cast<char>(random ());
+			}
+
+			// Favor the short inputs, which is what the runtime mostly hashes
+			size_t max_length = (i % 4) == 0 ? MAX_LENGTH : 256;
+			size_t length = random () % (max_length + 1);
+			size_t offset = random () % MAX_OFFSET;
+			auto initial_crc = static_cast<hash_t>(random ());
+			const char *data = buffer.data () + offset;
+
+			hash_t expected = Crc32::update_bitwise (initial_crc, data, length);
+			for (Implementation const& impl : implementations) {
+				hash_t hash = impl.update (initial_crc, data, length);
+				if (hash == expected) {
+					continue;
+				}
+
+				std::printf ("%.*s: 0x%08x != 0x%08x (length %zu, offset %zu, initial CRC 0x%08x, seed %llu)\n",
+					static_cast<int>(impl.name.length ()), impl.name.data (), hash, expected, length, offset, initial_crc,
+					static_cast<unsigned long long>(seed)
+				);
+				failures++;
+			}
+		}
+
+		return failures;
+	}
+}
+
+int main (int argc, char **argv)
+{
+	uint64_t seed = argc > 1 ? std::strtoull (argv[1], nullptr, 0) : 0x58414352433332ull;
+	std::vector<Implementation> implementations = get_implementations ();
+
+	size_t failures = check_known_hashes (implementations);
+	failures += check_random_inputs (implementations, seed);
+
+	if (failures > 0) {
+		std::printf ("%zu failure(s)\n", failures);
+		return 1;
+	}
+
+	std::printf ("All %zu CRC32 implementation(s) agree\n", implementations.size ());
+	return 0;
+}
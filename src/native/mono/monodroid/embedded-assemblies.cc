@@ -15,6 +15,8 @@
 #include <dirent.h>
 #include <sys/types.h>
 
+#include <lz4.h>
+
 #include <mono/metadata/assembly.h>
 #include <mono/metadata/class.h>
 #include <mono/metadata/image.h>
@@ -153,17 +155,72 @@ EmbeddedAssemblies::get_assembly_data (uint8_t *data, uint32_t data_size, [[mayb
 			}
 
 			const char *data_start = pointer_add<const char*>(data, sizeof(CompressedAssemblyHeader));
-			size_t ret = ZSTD_decompress (data_buffer, cad.uncompressed_file_size, data_start, assembly_data_size);
+			size_t ret;
+			switch (header->codec) {
+				case CompressionCodec::Zstandard:
+					if (header->dictionary_id != 0) [[unlikely]] {
+						Helpers::abort_application (
+							LOG_ASSEMBLY,
+							std::format (
+								"Assembly {} was compressed with dictionary {}, which MonoVM doesn't support",
+								optional_string (name),
+								header->dictionary_id
+							)
+						);
+					}
+
+					ret = ZSTD_decompress (data_buffer, cad.uncompressed_file_size, data_start, assembly_data_size);
+
+					if (ZSTD_isError (ret)) {
+						Helpers::abort_application (
+							LOG_ASSEMBLY,
+							std::format (
+								"Decompression of assembly {} failed: {}",
+								optional_string (name),
+								ZSTD_getErrorName (ret)
+							)
+						);
+					}
+					break;
+
+				case CompressionCodec::LZ4: {
+					int lz4_ret = LZ4_decompress_safe (
+						data_start,
+						reinterpret_cast<char*>(data_buffer),
+						static_cast<int>(assembly_data_size),
+						static_cast<int>(cad.uncompressed_file_size)
+					);
 
-			if (ZSTD_isError (ret)) {
-				Helpers::abort_application (
-					LOG_ASSEMBLY,
-					std::format (
-						"Decompression of assembly {} failed: {}",
-						optional_string (name),
-						ZSTD_getErrorName (ret)
-					)
-				);
+					if (lz4_ret < 0) {
+						Helpers::abort_application (
+							LOG_ASSEMBLY,
+							std::format (
+								"Decompression of assembly {} failed: corrupt LZ4 data",
+								optional_string (name)
+							)
+						);
+					}
+					ret = static_cast<size_t>(lz4_ret);
+					break;
+				}
+
+				case CompressionCodec::Stored:
+					// Data of an unexpected size is caught by the check below
+					ret = assembly_data_size;
+					if (ret == cad.uncompressed_file_size) {
+						memcpy (data_buffer, data_start, ret);
+					}
+					break;
+
+				default:
+					Helpers::abort_application (
+						LOG_ASSEMBLY,
+						std::format (
+							"Assembly {} is compressed with an unknown codec {}",
+							optional_string (name),
+							static_cast<uint32_t>(header->codec)
+						)
+					);
 			}
 
 			if (ret != cad.uncompressed_file_size) {
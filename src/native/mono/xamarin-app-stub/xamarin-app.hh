@@ -12,7 +12,7 @@
 #include <shared/xxhash.hh>
 
 static constexpr uint64_t FORMAT_TAG = 0x00035E6972616D58; // 'Xmari^XY' where XY is the format version
-static constexpr uint32_t COMPRESSED_DATA_MAGIC = 0x535A4158; // 'XAZS', little-endian
+static constexpr uint32_t COMPRESSED_DATA_MAGIC = 0x41434158; // 'XACA', little-endian
 static constexpr uint32_t ASSEMBLY_STORE_MAGIC = 0x41424158; // 'XABA', little-endian
 
 // The highest bit of assembly store version is a 64-bit ABI flag
@@ -102,11 +102,22 @@ struct TypeMapJava
 };
 #endif
 
+// Keep in sync with src/Microsoft.Android.Build.Tasks/Utilities/AssemblyCompressor.cs
+enum class CompressionCodec : uint32_t
+{
+	Stored    = 0, // not compressed, used when compression doesn't make the assembly any smaller
+	Zstandard = 1,
+	LZ4       = 2, // LZ4 block format
+};
+
 struct CompressedAssemblyHeader
 {
 	uint32_t magic; // COMPRESSED_DATA_MAGIC
 	uint32_t descriptor_index;
 	uint32_t uncompressed_length;
+	CompressionCodec codec;
+	// Assembly store dictionaries aren't supported by MonoVM, always `0`
+	uint32_t dictionary_id;
 };
 
 struct CompressedAssemblyDescriptor
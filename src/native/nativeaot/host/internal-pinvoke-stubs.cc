@@ -16,6 +16,13 @@ namespace {
 	}
 }
 
+uint64_t clr_typemap_hash_name (
+	[[maybe_unused]] const char *name,
+	[[maybe_unused]] uint32_t name_length) noexcept
+{
+	pinvoke_unreachable ();
+}
+
 const char* clr_typemap_managed_to_java (
 	[[maybe_unused]] const char *typeName,
 	[[maybe_unused]] const char *assemblyFullName,
@@ -24,6 +31,16 @@ const char* clr_typemap_managed_to_java (
 	pinvoke_unreachable ();
 }
 
+const char* clr_typemap_managed_to_java_hashed (
+	[[maybe_unused]] const char *typeName,
+	[[maybe_unused]] uint32_t typeNameLength,
+	[[maybe_unused]] uint64_t typeNameHash,
+	[[maybe_unused]] const char *assemblyFullName,
+	[[maybe_unused]] const uint8_t *mvid) noexcept
+{
+	pinvoke_unreachable ();
+}
+
 bool clr_typemap_java_to_managed (
 	[[maybe_unused]] const char *java_type_name,
 	[[maybe_unused]] char const** assembly_name,
@@ -18,7 +18,9 @@ extern "C" {
 	void _monodroid_gref_log (const char *message) noexcept;
 	int _monodroid_gref_log_new (jobject curHandle, char curType, jobject newHandle, char newType, const char *threadName, int threadId, const char *from, int from_writable) noexcept;
 	void _monodroid_gref_log_delete (jobject handle, char type, const char *threadName, int threadId, const char *from, int from_writable) noexcept;
+	uint64_t clr_typemap_hash_name (const char *name, uint32_t name_length) noexcept;
 	const char* clr_typemap_managed_to_java (const char *typeName, const char *assemblyFullName, const uint8_t *mvid) noexcept;
+	const char* clr_typemap_managed_to_java_hashed (const char *typeName, uint32_t typeNameLength, uint64_t typeNameHash, const char *assemblyFullName, const uint8_t *mvid) noexcept;
 	bool clr_typemap_java_to_managed (const char *java_type_name, char const** assembly_name, uint32_t *managed_type_token_id) noexcept;
 	BridgeProcessingFtn clr_initialize_gc_bridge (
 		BridgeProcessingStartedFtn bridge_processing_started_callback,
@@ -16,7 +16,7 @@ public class FastTimingTests : DeviceTest
 	{
 		const string completedMessage = "FAST_TIMING_EVENTS_COMPLETED";
 		const string bufferGrowthMessage = "Allocated timing event buffer from 4096 to 8192";
-		const string dumpCompletedMessage = "[2/8] Assembly decompression";
+		const string dumpCompletedMessage = "[2/17] Managed to Java lookup cache misses";
 
 		if (IgnoreUnsupportedConfiguration (AndroidRuntime.CoreCLR, release: false)) {
 			return;
@@ -81,4 +81,73 @@ public class FastTimingTests : DeviceTest
 			RunAdbCommand ($"shell setprop debug.mono.log {value}");
 		}
 	}
+
+	[Test]
+	public void OnDemandDecompressionMaterializesPartOfTheImages ()
+	{
+		const string materializedMessage = "[2/14] On-demand decompression pages materialized";
+		const string imagePagesMessage = "[2/15] On-demand decompression image pages";
+
+		if (IgnoreUnsupportedConfiguration (AndroidRuntime.CoreCLR, release: true)) {
+			return;
+		}
+
+		string packageName = PackageUtils.MakePackageName (AndroidRuntime.CoreCLR, "ondemand");
+		var proj = new XamarinAndroidApplicationProject (packageName: packageName) {
+			IsRelease = true,
+		};
+		proj.SetRuntime (AndroidRuntime.CoreCLR);
+		proj.SetRuntimeIdentifiers ([DeviceAbi]);
+		proj.SetProperty ("_AndroidFastTiming", "True");
+		proj.SetProperty ("_AndroidAssemblyStoreOnDemandDecompression", "True");
+		proj.SetDefaultTargetDevice ();
+
+		using var builder = CreateApkBuilder (packageName: packageName);
+		Assert.IsTrue (builder.Install (proj), "Project should have installed.");
+
+		string previousMonoLog = RunAdbCommand ("shell getprop debug.mono.log").Trim ();
+		try {
+			RunAdbCommand ("shell setprop debug.mono.log timing=fast-bare");
+			ClearAdbLogcat ();
+			StartActivityAndAssert (proj);
+
+			ulong materializedPages = 0;
+			ulong imagePages = 0;
+			bool dumpCompleted = MonitorAdbLogcat (
+				line => {
+					TryReadCounter (line, materializedMessage, ref materializedPages);
+					return TryReadCounter (line, imagePagesMessage, ref imagePages);
+				},
+				Path.Combine (Root, builder.ProjectDirectory, "on-demand-dump.log"),
+				timeout: 60,
+				onMonitoringStarted: () => RunAdbCommand (
+					$"shell am broadcast -a mono.android.app.DUMP_TIMING_DATA -n {proj.PackageName}/mono.android.app.DumpTimingData"
+				)
+			);
+
+			Assert.IsTrue (dumpCompleted, $"Output did not contain {imagePagesMessage}.");
+			if (imagePages == 0) {
+				Assert.Ignore ("userfaultfd is not available on this device, assemblies were decompressed eagerly.");
+			}
+
+			TestContext.Out.WriteLine ($"Materialized {materializedPages} of {imagePages} pages ({100.0 * materializedPages / imagePages:F1}%)");
+			Assert.Greater (materializedPages, 0UL, "Some pages of the images must have been materialized.");
+			Assert.Less (materializedPages, imagePages, "Not all pages of the images should have been materialized.");
+		} finally {
+			RunAdbCommand ($"shell am force-stop {proj.PackageName}");
+			string value = previousMonoLog.Length == 0 ? "\"\"" : $"\"{previousMonoLog}\"";
+			RunAdbCommand ($"shell setprop debug.mono.log {value}");
+		}
+	}
+
+	static bool TryReadCounter (string line, string message, ref ulong value)
+	{
+		int index = line.IndexOf (message, StringComparison.Ordinal);
+		if (index < 0) {
+			return false;
+		}
+
+		string text = line.Substring (index + message.Length).TrimStart (':', ' ').Trim ();
+		return UInt64.TryParse (text, out value);
+	}
 }
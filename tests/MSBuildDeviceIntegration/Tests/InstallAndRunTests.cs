@@ -763,31 +763,34 @@ static int InvokeIntMethod (Java.Lang.Object instance, string methodName)
 				"First launch should succeed."
 			);
 
-			string [] cacheFiles = [];
-			for (int attempt = 0; attempt < 40 && cacheFiles.Length < 2; attempt++) {
+			// All the decompressed assemblies of the store are kept in a single pack file
+			string packFile = "";
+			string PackFileSize () => RunAdbCommand (
+				$"shell run-as {app.PackageName} stat -c %s {packFile}"
+			).Trim ();
+			for (int attempt = 0; attempt < 40 && (packFile.Length == 0 || PackFileSize () == "0"); attempt++) {
 				Thread.Sleep (250);
-				cacheFiles = RunAdbCommand (
-					$"shell run-as {app.PackageName} find code_cache/decompressed-assembly-cache-v1 -type f -name '*.bin'"
+				packFile = RunAdbCommand (
+					$"shell run-as {app.PackageName} find code_cache/decompressed-assembly-cache-v2 -type f -name '*.pack'"
 				)
 					.Split (new [] { '\r', '\n' }, StringSplitOptions.RemoveEmptyEntries)
-					.Where (line => line.EndsWith (".bin", StringComparison.Ordinal))
-					.ToArray ();
+					.FirstOrDefault (line => line.EndsWith (".pack", StringComparison.Ordinal)) ?? "";
 			}
-			Assert.That (cacheFiles.Length, Is.GreaterThanOrEqualTo (2), "The first launch should persist multiple decompressed assemblies.");
+			Assert.That (packFile, Is.Not.Empty, "The first launch should persist decompressed assemblies.");
 
 			RunAdbCommand ($"shell am force-stop --user all {app.PackageName}");
-			string cacheFileToCorrupt = cacheFiles.First ();
-			string ValidFileHash () => RunAdbCommand (
-				$"shell run-as {app.PackageName} md5sum {cacheFileToCorrupt}"
+			string PackFileHash () => RunAdbCommand (
+				$"shell run-as {app.PackageName} md5sum {packFile}"
 			).Split (new [] { ' ', '\r', '\n', '\t' }, StringSplitOptions.RemoveEmptyEntries).FirstOrDefault () ?? "";
 
-			string validHash = ValidFileHash ();
-			Assert.That (validHash, Is.Not.Empty, $"Should be able to hash the persisted cache file '{cacheFileToCorrupt}'.");
+			string validHash = PackFileHash ();
+			Assert.That (validHash, Is.Not.Empty, $"Should be able to hash the persisted cache pack '{packFile}'.");
 
 			RunAdbCommand (
-				$"shell run-as {app.PackageName} dd if=/dev/zero of={cacheFileToCorrupt} bs=1 count=1 conv=notrunc"
+				$"shell run-as {app.PackageName} sh -c 'printf X | dd of={packFile} bs=1 count=1 conv=notrunc'"
 			);
-			Assert.That (ValidFileHash (), Is.Not.EqualTo (validHash), "Corrupting the cache file should change its contents.");
+			string corruptedHash = PackFileHash ();
+			Assert.That (corruptedHash, Is.Not.EqualTo (validHash), "Corrupting the cache pack should change its contents.");
 
 			ClearAdbLogcat ();
 			AdbStartActivity ($"{app.PackageName}/{app.JavaPackageName}.MainActivity");
@@ -801,30 +804,114 @@ static int InvokeIntMethod (Java.Lang.Object instance, string methodName)
 				"Second launch should succeed."
 			);
 
-			// A corrupted entry must be rejected (footer hash mismatch) and re-decompressed, which
-			// re-persists a byte-identical file. Verify the *exact* corrupted file is healed rather
-			// than merely checking that some other valid entry is still mapped.
+			// A corrupted pack must be rejected as a whole (TOC or file metadata mismatch), with the
+			// assemblies decompressed from the store and persisted in a freshly created pack.
 			bool rewritten = false;
 			for (int attempt = 0; attempt < 40 && !rewritten; attempt++) {
 				Thread.Sleep (250);
-				rewritten = ValidFileHash () == validHash;
+				string hash = PackFileHash ();
+				rewritten = hash.Length > 0 && hash != corruptedHash && PackFileSize () != "0";
 			}
-			Assert.IsTrue (rewritten, $"The corrupted cache file '{cacheFileToCorrupt}' should be rewritten with valid contents after fallback.");
+			Assert.IsTrue (rewritten, $"The corrupted cache pack '{packFile}' should be rewritten after fallback.");
+
+			RunAdbCommand ($"shell am force-stop --user all {app.PackageName}");
+			ClearAdbLogcat ();
+			AdbStartActivity ($"{app.PackageName}/{app.JavaPackageName}.MainActivity");
+			Assert.IsTrue (
+				WaitForActivityToStart (
+					app.PackageName,
+					"MainActivity",
+					Path.Combine (Root, appBuilder.ProjectDirectory, "assembly-cache-third-launch.log"),
+					ActivityStartTimeoutInSeconds
+				),
+				"Third launch should succeed."
+			);
 
 			string [] pids = RunAdbCommand ($"shell pidof {app.PackageName}")
 				.Split (new [] { ' ', '\r', '\n', '\t' }, StringSplitOptions.RemoveEmptyEntries);
-			Assert.IsNotEmpty (pids, "The application process should be running after the second launch.");
+			Assert.IsNotEmpty (pids, "The application process should be running after the third launch.");
 			var maps = new StringBuilder ();
 			foreach (string pid in pids) {
 				maps.Append (RunAdbCommand ($"shell run-as {app.PackageName} cat /proc/{pid}/maps"));
 			}
 			StringAssert.Contains (
-				"/code_cache/decompressed-assembly-cache-v1/",
+				"/code_cache/decompressed-assembly-cache-v2/",
 				maps.ToString (),
-				"The second launch should map persisted decompressed assemblies."
+				"The third launch should map the persisted decompressed-assembly pack."
 			);
 		}
 
+		[Test]
+		public void AssemblyFromSecondaryAssemblyStoreLoads ([Values] bool extractNativeLibs)
+		{
+			const string logcatMessage = "SECONDARY_ASSEMBLY_STORE_FEATURE_LOADED";
+
+			if (IgnoreUnsupportedConfiguration (AndroidRuntime.CoreCLR, release: true)) {
+				return;
+			}
+
+			var path = Path.Combine ("temp", TestName);
+			var lib = new XamarinAndroidLibraryProject {
+				IsRelease = true,
+				ProjectName = "SecondaryFeature",
+				Sources = {
+					new BuildItem.Source ("Feature.cs") {
+						TextContent = () => """
+namespace SecondaryFeature;
+
+public static class Feature
+{
+	public static string Describe () => $"{typeof (Feature).Assembly.GetName ().Name} loaded";
+}
+""",
+					},
+				},
+			};
+			lib.SetRuntime (AndroidRuntime.CoreCLR);
+
+			var proj = new XamarinAndroidApplicationProject (packageName: PackageUtils.MakePackageName (AndroidRuntime.CoreCLR, $"secondarystore{extractNativeLibs}")) {
+				IsRelease = true,
+			};
+			proj.SetRuntime (AndroidRuntime.CoreCLR);
+			proj.SetRuntimeIdentifiers ([DeviceAbi]);
+			proj.SetProperty ("_AndroidAssemblyStoreSecondaryAssemblies", lib.ProjectName);
+			proj.References.Add (new BuildItem.ProjectReference ($"..\\{lib.ProjectName}\\{lib.ProjectName}.csproj", lib.ProjectName, lib.ProjectGuid));
+			// The runtime looks the stores up in the native library directory when they're extracted, and lets the
+			// dynamic linker find them in the APK otherwise
+			proj.AndroidManifest = proj.AndroidManifest.Replace ("<application ", $"<application android:extractNativeLibs=\"{extractNativeLibs.ToString ().ToLowerInvariant ()}\" ");
+			// The call is in a separate method, so that the assembly isn't needed until after startup
+			proj.MainActivity = proj.DefaultMainActivity
+				.Replace ("//${AFTER_ONCREATE}", "LogSecondaryFeature ();")
+				.Replace (
+					"//${FIELDS}",
+					$$"""
+		[System.Runtime.CompilerServices.MethodImpl (System.Runtime.CompilerServices.MethodImplOptions.NoInlining)]
+		static void LogSecondaryFeature ()
+		{
+			Android.Util.Log.Info ("SecondaryStoreTest", $"{{logcatMessage}}: {SecondaryFeature.Feature.Describe ()}");
+		}
+"""
+				);
+
+			using var libBuilder = CreateDllBuilder (Path.Combine (path, lib.ProjectName));
+			Assert.IsTrue (libBuilder.Build (lib), "Library build should have succeeded.");
+
+			using var appBuilder = CreateApkBuilder (Path.Combine (path, proj.ProjectName));
+			Assert.IsTrue (appBuilder.Install (proj), "Install should have succeeded.");
+
+			var apk = Path.Combine (Root, appBuilder.ProjectDirectory, proj.OutputPath, $"{proj.PackageName}-Signed.apk");
+			using (var zip = System.IO.Compression.ZipFile.OpenRead (apk)) {
+				Assert.IsNotNull (zip.GetEntry ($"lib/{DeviceAbi}/libassembly-store-1.so"), "The APK should contain a secondary assembly store.");
+			}
+
+			RunProjectAndAssert (proj, appBuilder);
+			Assert.IsTrue (WaitForActivityToStart (proj.PackageName, "MainActivity",
+				Path.Combine (Root, appBuilder.ProjectDirectory, "logcat.log"), ActivityStartTimeoutInSeconds), "Activity should have started.");
+			Assert.IsTrue (MonitorAdbLogcat ((line) => line.Contains ($"{logcatMessage}: {lib.ProjectName} loaded"),
+				Path.Combine (Root, appBuilder.ProjectDirectory, "secondary-store-logcat.log"), 45),
+				$"Output did not contain {logcatMessage}! The assembly from the secondary store should have loaded.");
+		}
+
 		[Test]
 		public void ActivityAliasRuns ([Values] bool isRelease, [Values (AndroidRuntime.CoreCLR, AndroidRuntime.NativeAOT)] AndroidRuntime runtime)
 		{
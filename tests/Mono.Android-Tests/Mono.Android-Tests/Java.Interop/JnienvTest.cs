@@ -11,6 +11,8 @@ using Android.Content;
 
 using Java.Interop;
 
+using Microsoft.Android.Runtime;
+
 using NUnit.Framework;
 using Android.OS;
 
@@ -506,6 +508,28 @@ namespace Java.InteropTests
 			Assert.AreEqual (null, m, "`JnienvTest` does *not* subclass Java.Lang.Object, it should *not* be in the typemap!");
 		}
 
+		[Test]
+		public void ManagedToJavaTypeMappingByCachedHash ()
+		{
+			if (!RuntimeFeature.IsCoreClrRuntime || RuntimeFeature.TrimmableTypeMap || RuntimeFeature.ManagedToJavaUsesAssemblyFullName) {
+				Assert.Ignore ("Only the CoreCLR Release typemap is searched by the cached type name hash.");
+			}
+
+			// The hash comes from the runtime and may be 64-bit wide, the lookups fail if it doesn't arrive intact
+			AssertManagedToJavaByCachedHash (typeof (Activity), "android/app/Activity");
+			AssertManagedToJavaByCachedHash (typeof (Java.Lang.Object), "java/lang/Object");
+			AssertManagedToJavaByCachedHash (typeof (Android.Views.View.IOnClickListener), "android/view/View$OnClickListener");
+			AssertManagedToJavaByCachedHash (typeof (JnienvTest), null);
+		}
+
+		static void AssertManagedToJavaByCachedHash (Type type, string? expectedJavaName)
+		{
+			var name = TypemapName.ForType (type);
+			Assert.IsNotNull (name, $"No typemap name for `{type}`");
+			Assert.AreSame (name, TypemapName.ForType (type), $"Typemap name of `{type}` should be computed only once");
+			Assert.AreEqual (expectedJavaName, JNIEnv.TypemapManagedToJava (type), $"Java type of `{type}`");
+		}
+
 		[Test]
 		[Category ("GCBridge")]
 		[Category ("NativeAOTIgnore")]
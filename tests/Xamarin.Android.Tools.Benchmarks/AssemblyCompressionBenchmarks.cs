@@ -0,0 +1,73 @@
+using System;
+using System.IO;
+using System.IO.Compression;
+using System.Runtime.InteropServices;
+using BenchmarkDotNet.Attributes;
+using K4os.Compression.LZ4;
+
+namespace Xamarin.Android.Tools.Benchmarks;
+
+// Compares the decompression throughput of the codecs the assembly store can compress assemblies with:
+// Zstandard (the default, at the level used by Release builds) and LZ4 (for the assemblies listed in
+// `$(_AndroidAssemblyStoreLz4Assemblies)`). The inputs are the BCL assemblies of the runtime running the
+// benchmark. Zstandard goes through libSystem.IO.Compression.Native, the very library the Android runtime
+// decompresses with. LZ4 goes through K4os, a port of liblz4 (external/lz4), which the Android runtime
+// decompresses with.
+//
+// The compressed sizes are printed during the global setup, since the ratio is the other half of the trade.
+[MemoryDiagnoser]
+public class AssemblyCompressionBenchmarks
+{
+	// Keep in sync with the `Release` default of `$(_AndroidAssemblyStoreCompressionLevel)`
+	const int ZstandardLevel = 22;
+
+	[Params ("System.Private.CoreLib.dll", "System.Linq.dll", "System.Collections.dll", "System.Runtime.dll")]
+	public string Assembly { get; set; } = "";
+
+	byte [] _zstandardData = Array.Empty<byte> ();
+	byte [] _lz4Data = Array.Empty<byte> ();
+	byte [] _output = Array.Empty<byte> ();
+
+	[GlobalSetup]
+	public void Setup ()
+	{
+		byte[] image = File.ReadAllBytes (Path.Combine (RuntimeEnvironment.GetRuntimeDirectory (), Assembly));
+		_output = new byte [image.Length];
+
+		var zstandard = new byte [checked ((int) ZstandardEncoder.GetMaxCompressedLength (image.Length))];
+		if (!ZstandardEncoder.TryCompress (image, zstandard, out int zstandardLength, ZstandardLevel, 0)) {
+			throw new InvalidOperationException ($"Failed to compress '{Assembly}' with Zstandard");
+		}
+		_zstandardData = zstandard.AsSpan (0, zstandardLength).ToArray ();
+
+		var lz4 = new byte [LZ4Codec.MaximumOutputSize (image.Length)];
+		int lz4Length = LZ4Codec.Encode (image, lz4, LZ4Level.L12_MAX);
+		if (lz4Length <= 0) {
+			throw new InvalidOperationException ($"Failed to compress '{Assembly}' with LZ4");
+		}
+		_lz4Data = lz4.AsSpan (0, lz4Length).ToArray ();
+
+		Console.WriteLine ($"// {Assembly}: {image.Length} bytes, Zstandard {_zstandardData.Length} bytes, LZ4 {_lz4Data.Length} bytes");
+	}
+
+	[Benchmark (Baseline = true)]
+	public int Zstandard ()
+	{
+		if (!ZstandardDecoder.TryDecompress (_zstandardData, _output, out int written)) {
+			throw new InvalidOperationException ("Zstandard decompression failed");
+		}
+
+		return written;
+	}
+
+	[Benchmark]
+	public int LZ4 ()
+	{
+		int written = LZ4Codec.Decode (_lz4Data, _output);
+		if (written != _output.Length) {
+			throw new InvalidOperationException ("LZ4 decompression failed");
+		}
+
+		return written;
+	}
+}
@@ -0,0 +1,115 @@
+using System;
+using System.IO.Hashing;
+using System.Text;
+using BenchmarkDotNet.Attributes;
+using Xamarin.Android.Tasks;
+
+namespace Xamarin.Android.Tools.Benchmarks;
+
+// Compares the two assembly store index layouts understood by the CoreCLR host: the sorted index (v6,
+// binary search over CRC32 hashes followed by a walk over the run of equal hashes) and the minimal
+// perfect hash index (v7, a single probe). Both variants mirror the lookup performed by
+// `AssemblyStore::open_assembly` in src/native/clr/host/assembly-store.cc, including the final name
+// comparison.
+[MemoryDiagnoser]
+public class AssemblyStoreIndexBenchmarks
+{
+	[Params (500, 1000, 2000)]
+	public int AssemblyCount { get; set; }
+
+	byte [][] _names = Array.Empty<byte[]> ();
+	byte [][] _lookups = Array.Empty<byte[]> ();
+
+	uint [] _sortedHashes = Array.Empty<uint> ();
+	int [] _sortedNameIndices = Array.Empty<int> ();
+
+	uint [] _displacements = Array.Empty<uint> ();
+	uint [] _slotHashes = Array.Empty<uint> ();
+	int [] _slotNameIndices = Array.Empty<int> ();
+
+	[GlobalSetup]
+	public void Setup ()
+	{
+		_names = new byte [AssemblyCount][];
+		for (int i = 0; i < AssemblyCount; i++) {
+			_names [i] = Encoding.UTF8.GetBytes ($"Company{i % 37}.Product{i}.Feature.dll");
+		}
+
+		_sortedHashes = new uint [AssemblyCount];
+		_sortedNameIndices = new int [AssemblyCount];
+		for (int i = 0; i < AssemblyCount; i++) {
+			_sortedHashes [i] = Crc32.HashToUInt32 (_names [i]);
+			_sortedNameIndices [i] = i;
+		}
+
+		var hashes = (uint[])_sortedHashes.Clone ();
+		if (!MinimalPerfectHash.TryBuild (hashes, out _displacements, out int[] slots)) {
+			throw new InvalidOperationException ("Failed to build the perfect hash table");
+		}
+		_slotHashes = new uint [slots.Length];
+		_slotNameIndices = new int [slots.Length];
+		for (int i = 0; i < slots.Length; i++) {
+			_slotHashes [i] = hashes [slots [i]];
+			_slotNameIndices [i] = slots [i];
+		}
+
+		Array.Sort (_sortedHashes, _sortedNameIndices);
+
+		// Look the names up in a different order than the one they were added in
+		_lookups = (byte[][])_names.Clone ();
+		new Random (42).Shuffle (_lookups);
+	}
+
+	[Benchmark (Baseline = true)]
+	public int SortedIndex ()
+	{
+		int found = 0;
+		foreach (byte[] name in _lookups) {
+			uint hash = Crc32.HashToUInt32 (name);
+			int idx = LowerBound (_sortedHashes, hash);
+			while (idx < _sortedHashes.Length && _sortedHashes [idx] == hash) {
+				if (name.AsSpan ().SequenceEqual (_names [_sortedNameIndices [idx]])) {
+					found++;
+					break;
+				}
+				idx++;
+			}
+		}
+
+		return found;
+	}
+
+	[Benchmark]
+	public int PerfectHashIndex ()
+	{
+		int found = 0;
+		uint slotCount = (uint)_slotHashes.Length;
+		uint bucketCount = (uint)_displacements.Length;
+		foreach (byte[] name in _lookups) {
+			uint hash = Crc32.HashToUInt32 (name);
+			uint bucket = MinimalPerfectHash.GetBucket (hash, bucketCount);
+			uint slot = MinimalPerfectHash.GetSlot (hash, _displacements [bucket], slotCount);
+			if (_slotHashes [slot] == hash && name.AsSpan ().SequenceEqual (_names [_slotNameIndices [slot]])) {
+				found++;
+			}
+		}
+
+		return found;
+	}
+
+	static int LowerBound (uint [] array, uint key)
+	{
+		int lo = 0;
+		int hi = array.Length;
+		while (lo < hi) {
+			int mid = lo + ((hi - lo) >> 1);
+			if (array [mid] < key) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+
+		return lo;
+	}
+}
@@ -0,0 +1,158 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Hashing;
+using System.Numerics;
+using System.Runtime.Intrinsics.X86;
+using System.Text;
+using BenchmarkDotNet.Attributes;
+using Xamarin.Android.Tasks;
+
+namespace Xamarin.Android.Tools.Benchmarks;
+
+// Compares the lower bound search over a sorted table of CRC32 type name hashes (`Search::lower_bound`) with the one
+// over the same table in Eytzinger order (`Search::eytzinger_lower_bound`), both in
+// src/native/common/include/runtime-base/search.hh. The build tasks lay out the per-module managed-to-Java type maps
+// in Eytzinger order once they have at least `EytzingerLayout.MinimumEntryCount` entries.
+//
+// The searches are C# ports of the native ones, so the numbers show how the two layouts compare to each other rather
+// than how fast the runtime is. The tables are built from the Java names of the Android API types Mono.Android binds
+// (src/Mono.Android/Profiles/api-*.params.txt), which make up the largest module map of every app. Lookups are for
+// random names of the table, so that the search touches cold parts of the larger tables.
+[MemoryDiagnoser]
+public class EytzingerSearchBenchmarks
+{
+	const int LookupCount = 10000;
+
+	// From the smallest table laid out in Eytzinger order, to about the size of the Mono.Android map
+	[Params (64, 1024, 6000)]
+	public int EntryCount { get; set; }
+
+	uint [] _sorted = Array.Empty<uint> ();
+	uint [] _eytzinger = Array.Empty<uint> ();
+	uint [] _lookups = Array.Empty<uint> ();
+
+	[GlobalSetup]
+	public void Setup ()
+	{
+		var random = new Random (42);
+		string [] names = ReadApiTypeNames ();
+		if (names.Length < EntryCount) {
+			throw new InvalidOperationException ($"The API description has only {names.Length} types, {EntryCount} needed");
+		}
+		random.Shuffle (names);
+
+		_sorted = new uint [EntryCount];
+		for (int i = 0; i < EntryCount; i++) {
+			_sorted [i] = Crc32.HashToUInt32 (Encoding.UTF8.GetBytes (names [i]));
+		}
+		Array.Sort (_sorted);
+
+		_eytzinger = (uint[])_sorted.Clone ();
+		EytzingerLayout.Apply (_eytzinger);
+
+		_lookups = new uint [LookupCount];
+		for (int i = 0; i < LookupCount; i++) {
+			_lookups [i] = _sorted [random.Next (EntryCount)];
+		}
+	}
+
+	[Benchmark (Baseline = true)]
+	public int Sorted ()
+	{
+		int found = 0;
+		foreach (uint hash in _lookups) {
+			int idx = LowerBound (_sorted, hash);
+			if (idx < _sorted.Length && _sorted [idx] == hash) {
+				found++;
+			}
+		}
+
+		return found;
+	}
+
+	[Benchmark]
+	public int Eytzinger ()
+	{
+		int found = 0;
+		foreach (uint hash in _lookups) {
+			int idx = EytzingerLowerBound (_eytzinger, hash);
+			if (idx < _eytzinger.Length && _eytzinger [idx] == hash) {
+				found++;
+			}
+		}
+
+		return found;
+	}
+
+	// Turns the `package android.app` and `  class Activity` lines of the API description into `android/app/Activity`
+	static string [] ReadApiTypeNames ()
+	{
+		using Stream? stream = typeof (EytzingerSearchBenchmarks).Assembly.GetManifestResourceStream ("api.params.txt");
+		if (stream == null) {
+			throw new InvalidOperationException ("The API description resource is missing");
+		}
+
+		var names = new HashSet<string> (StringComparer.Ordinal);
+		using var reader = new StreamReader (stream);
+		string package = String.Empty;
+		string? line;
+		while ((line = reader.ReadLine ()) != null) {
+			if (line.StartsWith ("package ", StringComparison.Ordinal)) {
+				package = line.Substring ("package ".Length).Trim ().Replace ('.', '/');
+				continue;
+			}
+
+			string [] parts = line.Split (' ', StringSplitOptions.RemoveEmptyEntries);
+			if (!line.StartsWith ("  ", StringComparison.Ordinal) || line.StartsWith ("   ", StringComparison.Ordinal) ||
+			    parts.Length != 2 || (parts [0] != "class" && parts [0] != "interface")) {
+				continue;
+			}
+
+			string type = parts [1];
+			int genericStart = type.IndexOf ('<');
+			if (genericStart >= 0) {
+				type = type.Substring (0, genericStart);
+			}
+			names.Add ($"{package}/{type.Replace ('.', '$')}");
+		}
+
+		var ret = new string [names.Count];
+		names.CopyTo (ret);
+		return ret;
+	}
+
+	static int LowerBound (uint [] arr, uint hash)
+	{
+		int lo = 0;
+		int hi = arr.Length;
+		while (lo < hi) {
+			int mid = lo + ((hi - lo) >> 1);
+			if (arr [mid] < hash) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+
+		return lo;
+	}
+
+	static unsafe int EytzingerLowerBound (uint [] arr, uint hash)
+	{
+		uint n = (uint)arr.Length;
+		uint k = 1;
+		fixed (uint *p = arr) {
+			while (k <= n) {
+				if (Sse.IsSupported) {
+					// Grandchildren of the current node, same as the `__builtin_prefetch` call in the native code
+					Sse.Prefetch0 (p + Math.Min (4 * k - 1, n - 1));
+				}
+				k = 2 * k + (arr [k - 1] < hash ? 1u : 0u);
+			}
+		}
+
+		k >>= BitOperations.TrailingZeroCount (~k) + 1;
+		return k == 0 ? (int)n : (int)k - 1;
+	}
+}
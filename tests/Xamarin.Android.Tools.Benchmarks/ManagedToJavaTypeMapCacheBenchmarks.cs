@@ -0,0 +1,226 @@
+using System;
+using System.Buffers.Binary;
+using System.IO.Hashing;
+using System.Text;
+using BenchmarkDotNet.Attributes;
+
+namespace Xamarin.Android.Tools.Benchmarks;
+
+// Compares the release managed-to-Java typemap lookup performed by `TypeMapper::managed_to_java_release` in
+// src/native/clr/host/typemap.cc with and without the lookup cache in front of it. The uncached variant mirrors the
+// binary search over module MVIDs followed by the CRC32 lower bound search in the module's type map, the cached one
+// mirrors the open addressing table of `(module index, entry index)` words which is consulted first.
+//
+// Peers are created for a small set of types over and over (activities, views, collections), with the occasional
+// lookup of a type not seen before. `RepeatRatio` is the fraction of lookups which ask for one of the hot types.
+[MemoryDiagnoser]
+public class ManagedToJavaTypeMapCacheBenchmarks
+{
+	const int ModuleCount = 60;
+	const int TypesPerModule = 200;
+	const int HotTypeCount = 64;
+	const int LookupCount = 10000;
+
+	const int CacheSizeBits = 10;
+	const int CacheSize = 1 << CacheSizeBits;
+	const int CacheProbeLimit = 8;
+
+	[Params (0.5, 0.9, 0.99)]
+	public double RepeatRatio { get; set; }
+
+	sealed class Module
+	{
+		public byte [] Mvid = Array.Empty<byte> ();
+		public uint [] NameHashes = Array.Empty<uint> ();
+		public byte [][] Names = Array.Empty<byte[]> ();
+		public int [] JavaNameIndices = Array.Empty<int> ();
+	}
+
+	Module [] _modules = Array.Empty<Module> ();
+	string [] _javaNames = Array.Empty<string> ();
+	(byte [] mvid, byte [] name) [] _lookups = Array.Empty<(byte[], byte[])> ();
+	ulong [] _cache = new ulong [CacheSize];
+
+	[GlobalSetup]
+	public void Setup ()
+	{
+		var random = new Random (42);
+		_modules = new Module [ModuleCount];
+		_javaNames = new string [ModuleCount * TypesPerModule];
+		for (int m = 0; m < ModuleCount; m++) {
+			var module = new Module {
+				Mvid = new byte [16],
+				NameHashes = new uint [TypesPerModule],
+				Names = new byte [TypesPerModule][],
+				JavaNameIndices = new int [TypesPerModule],
+			};
+			random.NextBytes (module.Mvid);
+
+			for (int t = 0; t < TypesPerModule; t++) {
+				module.Names [t] = Encoding.UTF8.GetBytes ($"Company.Product{m}.Feature{t % 13}.Type{t}");
+				module.NameHashes [t] = Crc32.HashToUInt32 (module.Names [t]);
+			}
+			Array.Sort (module.NameHashes, module.Names);
+
+			for (int t = 0; t < TypesPerModule; t++) {
+				module.JavaNameIndices [t] = (m * TypesPerModule) + t;
+				_javaNames [(m * TypesPerModule) + t] = $"crc64{m:x8}/Type{t}";
+			}
+			_modules [m] = module;
+		}
+		Array.Sort (_modules, (a, b) => a.Mvid.AsSpan ().SequenceCompareTo (b.Mvid));
+
+		var hotTypes = new (Module module, int type) [HotTypeCount];
+		for (int i = 0; i < HotTypeCount; i++) {
+			hotTypes [i] = (_modules [random.Next (ModuleCount)], random.Next (TypesPerModule));
+		}
+
+		// Managed code passes a copy of the type name and the MVID with every call, lookups mustn't share the arrays
+		_lookups = new (byte[], byte[]) [LookupCount];
+		for (int i = 0; i < LookupCount; i++) {
+			(Module module, int type) = random.NextDouble () < RepeatRatio
+				? hotTypes [random.Next (HotTypeCount)]
+				: (_modules [random.Next (ModuleCount)], random.Next (TypesPerModule));
+			_lookups [i] = ((byte[])module.Mvid.Clone (), (byte[])module.Names [type].Clone ());
+		}
+	}
+
+	[Benchmark (Baseline = true)]
+	public int Uncached ()
+	{
+		int found = 0;
+		foreach ((byte[] mvid, byte[] name) in _lookups) {
+			uint hash = Crc32.HashToUInt32 (name);
+			if (Find (mvid, hash, name, out _, out _) != null) {
+				found++;
+			}
+		}
+
+		return found;
+	}
+
+	[Benchmark]
+	public int Cached ()
+	{
+		// Every run starts with an empty cache, just like the application does
+		Array.Clear (_cache);
+
+		int found = 0;
+		foreach ((byte[] mvid, byte[] name) in _lookups) {
+			uint hash = Crc32.HashToUInt32 (name);
+			if (CacheLookup (mvid, hash, name) != null) {
+				found++;
+				continue;
+			}
+
+			if (Find (mvid, hash, name, out int moduleIndex, out int entryIndex) != null) {
+				CacheStore (mvid, hash, moduleIndex, entryIndex);
+				found++;
+			}
+		}
+
+		return found;
+	}
+
+	string? Find (byte [] mvid, uint hash, byte [] name, out int moduleIndex, out int entryIndex)
+	{
+		entryIndex = -1;
+		moduleIndex = FindModule (mvid);
+		if (moduleIndex < 0) {
+			return null;
+		}
+
+		Module module = _modules [moduleIndex];
+		int idx = LowerBound (module.NameHashes, hash);
+		while (idx < module.NameHashes.Length && module.NameHashes [idx] == hash) {
+			if (name.AsSpan ().SequenceEqual (module.Names [idx])) {
+				entryIndex = idx;
+				return _javaNames [module.JavaNameIndices [idx]];
+			}
+			idx++;
+		}
+
+		return null;
+	}
+
+	string? CacheLookup (byte [] mvid, uint hash, byte [] name)
+	{
+		int homeSlot = GetCacheSlot (mvid, hash);
+		for (int i = 0; i < CacheProbeLimit; i++) {
+			ulong slot = _cache [(homeSlot + i) & (CacheSize - 1)];
+			if (slot == 0) {
+				return null;
+			}
+
+			Module module = _modules [(int)(slot >> 32) - 1];
+			int entryIndex = (int)(uint)slot;
+			if (module.NameHashes [entryIndex] != hash || !mvid.AsSpan ().SequenceEqual (module.Mvid)) {
+				continue;
+			}
+
+			if (name.AsSpan ().SequenceEqual (module.Names [entryIndex])) {
+				return _javaNames [module.JavaNameIndices [entryIndex]];
+			}
+		}
+
+		return null;
+	}
+
+	void CacheStore (byte [] mvid, uint hash, int moduleIndex, int entryIndex)
+	{
+		ulong value = ((ulong)(moduleIndex + 1) << 32) | (uint)entryIndex;
+		int homeSlot = GetCacheSlot (mvid, hash);
+		for (int i = 0; i < CacheProbeLimit; i++) {
+			ref ulong slot = ref _cache [(homeSlot + i) & (CacheSize - 1)];
+			if (slot == 0 || slot == value) {
+				slot = value;
+				return;
+			}
+		}
+
+		_cache [homeSlot] = value;
+	}
+
+	static int GetCacheSlot (byte [] mvid, uint hash)
+	{
+		ulong key = BinaryPrimitives.ReadUInt64LittleEndian (mvid) ^ (((ulong)hash << 32) | hash);
+		return (int)((key * 0x9e3779b97f4a7c15ul) >> (64 - CacheSizeBits));
+	}
+
+	int FindModule (byte [] mvid)
+	{
+		int lo = 0;
+		int hi = _modules.Length - 1;
+		while (lo <= hi) {
+			int mid = lo + ((hi - lo) >> 1);
+			int cmp = _modules [mid].Mvid.AsSpan ().SequenceCompareTo (mvid);
+			if (cmp == 0) {
+				return mid;
+			}
+
+			if (cmp < 0) {
+				lo = mid + 1;
+			} else {
+				hi = mid - 1;
+			}
+		}
+
+		return -1;
+	}
+
+	static int LowerBound (uint [] array, uint key)
+	{
+		int lo = 0;
+		int hi = array.Length;
+		while (lo < hi) {
+			int mid = lo + ((hi - lo) >> 1);
+			if (array [mid] < key) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+
+		return lo;
+	}
+}